@@ -3,22 +3,105 @@
 
 #include <vulkan/vulkan.h>
 
+#include <commandstream.h>
+#include <deferredlighting.h>
+#include <drawqueue.h>
+
 VkCommandPool command_pool_create(const VkDevice device, const uint32_t queue_family_index);
 
 void command_pool_destroy(const VkDevice device, const VkCommandPool command_pool);
 
-VkCommandBuffer *command_buffer_create_draw(
-    const VkDevice device,
-    const VkSurfaceCapabilitiesKHR surface_capabilities,
-    const VkCommandPool command_pool,
+VkCommandBuffer *command_buffers_allocate(const VkDevice device, const VkCommandPool command_pool, const uint32_t command_buffer_count);
+
+// Commands of the extended dynamic state extensions, which are not exported by
+// the loader and have to be looked up per device. Only the states in
+// dynamic_state_flags are set while recording.
+struct command_buffer_dynamic_state_commands {
+    uint32_t dynamic_state_flags;
+    PFN_vkCmdSetPrimitiveTopologyEXT set_primitive_topology;
+    PFN_vkCmdSetCullModeEXT set_cull_mode;
+    PFN_vkCmdSetFrontFaceEXT set_front_face;
+    PFN_vkCmdSetDepthTestEnableEXT set_depth_test_enable;
+    PFN_vkCmdSetDepthWriteEnableEXT set_depth_write_enable;
+    PFN_vkCmdSetDepthCompareOpEXT set_depth_compare_op;
+    PFN_vkCmdSetPolygonModeEXT set_polygon_mode;
+    PFN_vkCmdSetColorBlendEnableEXT set_color_blend_enable;
+    PFN_vkCmdSetColorBlendEquationEXT set_color_blend_equation;
+};
+
+struct command_buffer_dynamic_state_commands command_buffer_load_dynamic_state_commands(const VkDevice device, const uint32_t dynamic_state_flags);
+
+// Commands of VK_KHR_dynamic_rendering, looked up like the ones above.
+struct command_buffer_dynamic_rendering_commands {
+    PFN_vkCmdBeginRenderingKHR begin_rendering;
+    PFN_vkCmdEndRenderingKHR end_rendering;
+};
+
+struct command_buffer_dynamic_rendering_commands command_buffer_load_dynamic_rendering_commands(const VkDevice device);
+
+// The dynamic state of the draws is set when it differs from the previous
+// draw, the first draw sets all of it. With depth_prepass the depth pre-pass
+// pipelines of the draws are used and draws without one are left out.
+void command_buffer_record_draw_queue(
+    const VkCommandBuffer command_buffer,
+    const struct draw_queue *const draw_queue,
+    const struct command_buffer_dynamic_state_commands *const dynamic_state_commands,
+    const bool depth_prepass,
+    struct draw_queue_statistics *const draw_queue_statistics
+);
+
+// Translates a command stream into Vulkan calls. Only the states in the
+// dynamic_state_flags of dynamic_state_commands are set from the dynamic state
+// packets of the stream. Copies are an error inside_render_pass.
+void command_buffer_replay_stream(
+    const VkCommandBuffer command_buffer,
+    const struct command_buffer_dynamic_state_commands *const dynamic_state_commands,
+    const bool inside_render_pass,
+    const struct command_stream *const command_stream
+);
+
+void command_buffer_begin(const VkCommandBuffer command_buffer);
+
+// Barriers around the render pass are recorded by the caller, the attachments
+// are expected in and left in their attachment optimal layouts. With
+// depth_prepass the draw queue is recorded twice, see
+// command_buffer_record_draw_queue. With deferred_lighting the draws fill the
+// G-buffer and the lighting subpass follows them.
+void command_buffer_record_render_pass(
+    const VkCommandBuffer command_buffer,
+    const VkExtent2D render_extent,
     const VkRenderPass render_pass,
-    const VkFramebuffer *const framebuffers,
-    const VkPipeline graphics_pipeline,
-    const VkBuffer vertex_buffer,
-    const uint32_t swapchain_image_count,
-    const uint32_t vertex_count
+    const VkFramebuffer framebuffer,
+    const struct deferred_lighting *const deferred_lighting,
+    const struct draw_queue *const draw_queue,
+    const struct command_buffer_dynamic_state_commands *const dynamic_state_commands,
+    const bool depth_prepass,
+    const struct command_stream *const *const command_streams,
+    const uint32_t command_stream_count,
+    struct draw_queue_statistics *const draw_queue_statistics
 );
 
+// Records the same as command_buffer_record_render_pass with dynamic
+// rendering, straight into image_view and the optional depth_image_view
+// without render pass or framebuffer. With a resolve_image_view, image_view
+// is multisampled and only its resolved average is stored.
+void command_buffer_record_rendering(
+    const VkCommandBuffer command_buffer,
+    const VkExtent2D render_extent,
+    const VkImageView image_view,
+    const VkImageView resolve_image_view,
+    const VkImageView depth_image_view,
+    const struct command_buffer_dynamic_rendering_commands *const dynamic_rendering_commands,
+    const struct draw_queue *const draw_queue,
+    const struct command_buffer_dynamic_state_commands *const dynamic_state_commands,
+    const bool depth_prepass,
+    const struct command_stream *const *const command_streams,
+    const uint32_t command_stream_count,
+    struct draw_queue_statistics *const draw_queue_statistics
+);
+
+void command_buffer_end(const VkCommandBuffer command_buffer);
+
 void command_buffers_free(const VkDevice device, const VkCommandPool command_pool, VkCommandBuffer *command_buffers, const uint32_t swapchain_image_count);
 
 #endif
@@ -0,0 +1,222 @@
+#ifndef COMMANDSTREAM_H
+#define COMMANDSTREAM_H
+
+#include <vulkan/vulkan.h>
+
+#include <pipeline.h>
+
+#include <stdatomic.h>
+#include <stdio.h>
+
+// Producers encode into their own command_stream, streams take fixed-size
+// blocks from a shared command_arena with a single atomic add, so any thread
+// can record without touching a VkCommandPool. A stream itself must only be
+// used by one thread at a time.
+
+enum command_stream_op {
+    COMMAND_STREAM_OP_BIND_PIPELINE = 1,
+    COMMAND_STREAM_OP_BIND_DESCRIPTOR_SET,
+    COMMAND_STREAM_OP_PUSH_CONSTANTS,
+    COMMAND_STREAM_OP_BIND_VERTEX_BUFFER,
+    COMMAND_STREAM_OP_BIND_INDEX_BUFFER,
+    COMMAND_STREAM_OP_SET_VIEWPORT,
+    COMMAND_STREAM_OP_SET_SCISSOR,
+    COMMAND_STREAM_OP_DRAW,
+    COMMAND_STREAM_OP_DRAW_INDEXED,
+    COMMAND_STREAM_OP_COPY_BUFFER,
+    // Ops are stored in captures, new ones go at the end.
+    COMMAND_STREAM_OP_SET_DYNAMIC_STATE
+};
+
+struct command_stream_packet {
+    uint32_t op;
+    uint32_t size;
+};
+
+struct command_stream_bind_pipeline {
+    struct command_stream_packet packet;
+    VkPipeline pipeline;
+    VkPipelineBindPoint pipeline_bind_point;
+};
+
+struct command_stream_bind_descriptor_set {
+    struct command_stream_packet packet;
+    VkPipelineLayout pipeline_layout;
+    VkDescriptorSet descriptor_set;
+    VkPipelineBindPoint pipeline_bind_point;
+    uint32_t set;
+    uint32_t dynamic_offset_count;
+    uint32_t dynamic_offset;
+};
+
+struct command_stream_push_constants {
+    struct command_stream_packet packet;
+    VkPipelineLayout pipeline_layout;
+    VkShaderStageFlags stage_flags;
+    uint32_t offset;
+    uint32_t size;
+    uint8_t data[];
+};
+
+struct command_stream_bind_vertex_buffer {
+    struct command_stream_packet packet;
+    VkBuffer buffer;
+    VkDeviceSize offset;
+    uint32_t binding;
+};
+
+struct command_stream_bind_index_buffer {
+    struct command_stream_packet packet;
+    VkBuffer buffer;
+    VkDeviceSize offset;
+    VkIndexType index_type;
+};
+
+struct command_stream_set_viewport {
+    struct command_stream_packet packet;
+    VkViewport viewport;
+};
+
+struct command_stream_set_scissor {
+    struct command_stream_packet packet;
+    VkRect2D scissor;
+};
+
+struct command_stream_set_dynamic_state {
+    struct command_stream_packet packet;
+    struct graphics_pipeline_dynamic_state dynamic_state;
+};
+
+struct command_stream_draw {
+    struct command_stream_packet packet;
+    uint32_t vertex_count;
+    uint32_t instance_count;
+    uint32_t first_vertex;
+    uint32_t first_instance;
+};
+
+struct command_stream_draw_indexed {
+    struct command_stream_packet packet;
+    uint32_t index_count;
+    uint32_t instance_count;
+    uint32_t first_index;
+    int32_t vertex_offset;
+    uint32_t first_instance;
+};
+
+struct command_stream_copy_buffer {
+    struct command_stream_packet packet;
+    VkBuffer source_buffer;
+    VkBuffer destination_buffer;
+    VkBufferCopy buffer_copy;
+};
+
+struct command_arena {
+    uint8_t *data;
+    size_t capacity;
+    size_t block_size;
+    atomic_size_t head;
+    atomic_uint generation;
+};
+
+struct command_stream_block {
+    uint8_t *data;
+    uint32_t used;
+};
+
+struct command_stream {
+    struct command_arena *arena;
+    struct command_stream_block *blocks;
+    uint32_t block_count;
+    uint32_t block_capacity;
+    uint32_t packet_count;
+    uint32_t arena_generation;
+};
+
+struct command_stream_iterator {
+    uint32_t block_index;
+    uint32_t offset;
+};
+
+struct command_arena *command_arena_create(const size_t capacity, const size_t block_size);
+
+void command_arena_destroy(struct command_arena *command_arena);
+
+void command_arena_reset(struct command_arena *command_arena);
+
+struct command_stream *command_stream_create(struct command_arena *command_arena);
+
+void command_stream_destroy(struct command_stream *command_stream);
+
+void command_stream_reset(struct command_stream *command_stream);
+
+void command_stream_bind_pipeline(struct command_stream *command_stream, const VkPipelineBindPoint pipeline_bind_point, const VkPipeline pipeline);
+
+// The packet has room for a single dynamic offset.
+void command_stream_bind_descriptor_set(
+    struct command_stream *command_stream,
+    const VkPipelineBindPoint pipeline_bind_point,
+    const VkPipelineLayout pipeline_layout,
+    const uint32_t set,
+    const VkDescriptorSet descriptor_set,
+    const uint32_t dynamic_offset_count,
+    const uint32_t dynamic_offset
+);
+
+void command_stream_push_constants(
+    struct command_stream *command_stream,
+    const VkPipelineLayout pipeline_layout,
+    const VkShaderStageFlags stage_flags,
+    const uint32_t offset,
+    const uint32_t size,
+    const void *const data
+);
+
+void command_stream_bind_vertex_buffer(struct command_stream *command_stream, const uint32_t binding, const VkBuffer buffer, const VkDeviceSize offset);
+
+void command_stream_bind_index_buffer(struct command_stream *command_stream, const VkBuffer buffer, const VkDeviceSize offset, const VkIndexType index_type);
+
+void command_stream_set_viewport(struct command_stream *command_stream, const VkViewport viewport);
+
+void command_stream_set_scissor(struct command_stream *command_stream, const VkRect2D scissor);
+
+// Pipelines are compiled with the dynamic state flags of the pipeline compiler,
+// so a stream has to set the state before its first draw after binding a
+// graphics pipeline. Replay only sets the states among those flags.
+void command_stream_set_dynamic_state(struct command_stream *command_stream, const struct graphics_pipeline_dynamic_state *const dynamic_state);
+
+void command_stream_draw(
+    struct command_stream *command_stream,
+    const uint32_t vertex_count,
+    const uint32_t instance_count,
+    const uint32_t first_vertex,
+    const uint32_t first_instance
+);
+
+void command_stream_draw_indexed(
+    struct command_stream *command_stream,
+    const uint32_t index_count,
+    const uint32_t instance_count,
+    const uint32_t first_index,
+    const int32_t vertex_offset,
+    const uint32_t first_instance
+);
+
+// Copies are only allowed in streams replayed outside a render pass, see
+// command_buffer_replay_stream.
+void command_stream_copy_buffer(
+    struct command_stream *command_stream,
+    const VkBuffer source_buffer,
+    const VkBuffer destination_buffer,
+    const VkBufferCopy buffer_copy
+);
+
+// Streams have to be encoded again after their arena was reset, iterating a
+// stale one is an error.
+const struct command_stream_packet *command_stream_next(const struct command_stream *const command_stream, struct command_stream_iterator *iterator);
+
+void command_stream_write(const struct command_stream *const command_stream, FILE *file);
+
+void command_stream_read(struct command_stream *command_stream, FILE *file);
+
+#endif
@@ -3,36 +3,163 @@
 
 #include <vulkan/vulkan.h>
 
+#include <commandbuffer.h>
+#include <commandstream.h>
+#include <deferredlighting.h>
+#include <drawqueue.h>
+#include <dynamicresolution.h>
+#include <framebuffer.h>
+#include <offscreen.h>
+#include <pipelinecompiler.h>
+#include <readback.h>
+#include <rendergraph.h>
+#include <renderpass.h>
+#include <shadermodule.h>
+#include <shaderwatcher.h>
+#include <uniformring.h>
 #include <window.h>
 
+#define CONTEXT_MAX_RETIRED_SHADER_MODULES 16U
+#define CONTEXT_OFFSCREEN_IMAGE_COUNT 3U
+// The color attachment of the G-buffer with deferred shading.
+#define CONTEXT_GBUFFER_ALBEDO_FORMAT VK_FORMAT_R8G8B8A8_UNORM
+
+// Every graphics pipeline the application requests is one of these variants
+// of the current shaders and render pass, so learn-vulkan-warmup can compile
+// all of them ahead of time.
+enum context_graphics_pipeline_variant {
+    CONTEXT_GRAPHICS_PIPELINE_VARIANT_DEFAULT = 0,
+    CONTEXT_GRAPHICS_PIPELINE_VARIANT_GRAYSCALE,
+    // Writes depth only, see LEARN_VULKAN_DEPTH_PREPASS.
+    CONTEXT_GRAPHICS_PIPELINE_VARIANT_DEPTH_PREPASS,
+    CONTEXT_GRAPHICS_PIPELINE_VARIANT_COUNT
+};
+
 struct context {
     VkInstance instance;
     VkPhysicalDevice physical_device;
     VkPhysicalDeviceProperties physical_device_properties;
     VkPhysicalDeviceMemoryProperties physical_device_memory_properties;
+    VkPhysicalDeviceFeatures enabled_features;
+    VkPhysicalDeviceVulkan12Features enabled_vulkan_12_features;
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT enabled_graphics_pipeline_library_features;
+    VkPhysicalDeviceExtendedDynamicStateFeaturesEXT enabled_extended_dynamic_state_features;
+    VkPhysicalDeviceExtendedDynamicState3FeaturesEXT enabled_extended_dynamic_state_3_features;
+    VkPhysicalDeviceDynamicRenderingFeaturesKHR enabled_dynamic_rendering_features;
+    struct command_buffer_dynamic_state_commands dynamic_state_commands;
+    struct command_buffer_dynamic_rendering_commands dynamic_rendering_commands;
     VkDevice device;
     VkSurfaceKHR surface;
     VkSurfaceFormatKHR surface_format;
     VkSurfaceCapabilitiesKHR surface_capabilities;
+    VkFormat depth_format;
+    // See LEARN_VULKAN_MSAA_SAMPLES. Above one sample the scene is drawn into
+    // a transient multisample image that is resolved into the swapchain image.
+    VkSampleCountFlagBits sample_count;
+    // Draws are recorded a second time with their depth pre-pass pipelines
+    // ahead of the main pass.
+    bool depth_prepass;
+    // See LEARN_VULKAN_DEFERRED. The draws fill a G-buffer that a lighting
+    // subpass shades, always with render pass objects and one sample.
+    bool deferred;
     VkSwapchainKHR swapchain;
+    // The images of the offscreen ring in headless contexts.
+    VkImage *swapchain_images;
     VkImageView *image_views;
+    struct offscreen_images *offscreen_images;
+    // Null with dynamic rendering, which needs no framebuffers either.
     VkRenderPass render_pass;
+    struct render_pass_cache *render_pass_cache;
+    struct framebuffer_cache *framebuffer_cache;
+    struct render_graph *render_graph;
+    uint32_t render_graph_swapchain_image;
+    uint32_t render_graph_depth_image;
+    // Only used with more than one sample.
+    uint32_t render_graph_color_image;
+    // Only used with deferred shading, UINT32_MAX otherwise.
+    uint32_t render_graph_albedo_image;
+    struct deferred_lighting *deferred_lighting;
+    struct readback *readback;
+    uint32_t render_graph_readback_buffer;
+    // See LEARN_VULKAN_DYNAMIC_RESOLUTION, null when it is off.
+    struct dynamic_resolution *dynamic_resolution;
+    uint32_t render_graph_scene_image;
+    // The size of the scene attachments and the part of them drawn this frame.
+    VkExtent2D scene_extent;
+    VkExtent2D render_extent;
+    VkPipelineCache pipeline_cache;
+    double pipeline_cache_save_time;
     VkPipelineLayout graphics_pipeline_layout;
-    VkPipeline graphics_pipeline;
-    VkFramebuffer *framebuffers;
+    // Of graphics_pipeline_layout, zero sized when the shaders have no push
+    // constants.
+    VkPushConstantRange graphics_push_constant_range;
+    struct pipeline_compiler *pipeline_compiler;
+    struct shader_module_cache *shader_module_cache;
+    struct shader_module *vertex_shader_module;
+    struct shader_module *fragment_shader_module;
+    VkDescriptorSetLayout descriptor_set_layout;
+    struct graphics_pipeline_description graphics_pipeline_description;
+    struct pipeline_future *graphics_pipeline_future;
+    struct shader_watcher *shader_watcher;
+    struct shader_module *pending_vertex_shader_module;
+    struct shader_module *pending_fragment_shader_module;
+    struct graphics_pipeline_description pending_graphics_pipeline_description;
+    struct pipeline_future *pending_graphics_pipeline_future;
+    // Reloaded shaders of deferred_lighting, swapped in the same way.
+    struct shader_module *pending_lighting_vertex_shader_module;
+    struct shader_module *pending_lighting_fragment_shader_module;
+    struct graphics_pipeline_description pending_lighting_pipeline_description;
+    struct pipeline_future *pending_lighting_pipeline_future;
+    struct shader_module *retired_shader_modules[CONTEXT_MAX_RETIRED_SHADER_MODULES];
+    uint32_t retired_shader_module_count;
+    uint64_t frame_index;
+    uint64_t completed_frame_count;
+    uint64_t *image_frame_counts;
     VkCommandPool command_pool;
     VkQueue queue;
     VkCommandBuffer *command_buffers;
     VkSemaphore semaphore_image_available;
     VkSemaphore semaphore_image_rendered;
     VkFence *fences;
+    struct uniform_ring *uniform_ring;
+    struct command_arena *command_arena;
+    struct draw_queue_statistics draw_queue_statistics;
     uint32_t swapchain_image_count;
+    uint32_t image_index;
     uint32_t queue_family_index;
 };
 
 struct context *context_create(GLFWwindow *window);
 
-void context_record_command_buffers(struct context *context, const VkBuffer vertex_buffer, const uint32_t vertex_count);
+// A context without a window, surface or swapchain. Frames run the same way,
+// but are rendered into a ring of offscreen images of color_format, which are
+// left in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL. Swapchain recreation does not
+// apply.
+struct context *context_create_headless(const uint32_t width, const uint32_t height, const VkFormat color_format);
+
+// Copies every frame of a headless context into readback, which needs the
+// extent and format of the context. The readback stays with the caller, who
+// destroys it before the context.
+void context_attach_readback(struct context *context, struct readback *readback);
+
+void context_describe_graphics_pipeline(
+    const struct context *context,
+    const enum context_graphics_pipeline_variant variant,
+    struct graphics_pipeline_description *description
+);
+
+// Also the frame boundary at which reloaded shaders are swapped in, see
+// LEARN_VULKAN_SHADER_SOURCE_DIRECTORY.
+void context_begin_frame(struct context *context);
+
+// The command streams are replayed inside the scene pass after the draw
+// queue, so they must not contain copies.
+void context_end_frame(
+    struct context *context,
+    const struct draw_queue *const draw_queue,
+    const struct command_stream *const *const command_streams,
+    const uint32_t command_stream_count
+);
 
 void context_destroy(struct context *context);
 
@@ -0,0 +1,58 @@
+#ifndef CULLING_H
+#define CULLING_H
+
+#include <vulkan/vulkan.h>
+
+// Matches `culling_object` in cull.glsl (std430).
+struct culling_object {
+    float bounding_sphere[4];
+    uint32_t index_count;
+    uint32_t first_index;
+    int32_t vertex_offset;
+    uint32_t padding;
+};
+
+// Matches the push constant block in cull.glsl. Planes are (normal, distance)
+// with normals pointing into the frustum.
+struct culling_push_constants {
+    float frustum_planes[6][4];
+    uint32_t object_count;
+};
+
+struct culling {
+    VkDescriptorSetLayout descriptor_set_layout;
+    VkDescriptorPool descriptor_pool;
+    VkDescriptorSet descriptor_set;
+    VkPipelineLayout pipeline_layout;
+    VkPipeline pipeline;
+    VkBuffer object_buffer;
+    VkDeviceMemory object_buffer_device_memory;
+    struct culling_object *objects;
+    VkBuffer draw_command_buffer;
+    VkDeviceMemory draw_command_buffer_device_memory;
+    VkBuffer draw_count_buffer;
+    VkDeviceMemory draw_count_buffer_device_memory;
+    uint32_t *draw_count;
+    uint32_t object_capacity;
+    uint32_t object_count;
+};
+
+struct culling *culling_create(
+    const VkDevice device,
+    const VkPipelineCache pipeline_cache,
+    const VkPhysicalDeviceMemoryProperties physical_device_memory_properties,
+    const VkShaderModule compute_shader_module,
+    const uint32_t object_capacity
+);
+
+void culling_destroy(const VkDevice device, struct culling *culling);
+
+void culling_set_objects(struct culling *culling, const struct culling_object *const objects, const uint32_t object_count);
+
+void culling_extract_frustum_planes(const float view_projection[16], float frustum_planes[6][4]);
+
+void culling_record_dispatch(const VkCommandBuffer command_buffer, const struct culling *const culling, const float frustum_planes[6][4]);
+
+void culling_record_draw(const VkCommandBuffer command_buffer, const struct culling *const culling);
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef DEFERREDLIGHTING_H
+#define DEFERREDLIGHTING_H
+
+#include <vulkan/vulkan.h>
+
+#include <pipeline.h>
+#include <pipelinecompiler.h>
+#include <shadermodule.h>
+#include <shaderreflection.h>
+
+#include <stdbool.h>
+
+// The lighting subpass of a deferred render pass, see
+// render_pass_description_init_deferred. A full screen triangle whose fragment
+// shader reads the G-buffer albedo and depth as input attachments. The
+// descriptor set layout is derived from the shaders.
+//
+// The pipeline is requested from the pipeline compiler like every other
+// graphics pipeline, so it is compiled in the background, shares the cache and
+// is covered by learn-vulkan-warmup. Until it is ready the lighting subpass
+// draws nothing.
+struct deferred_lighting {
+    VkDevice device;
+    struct shader_module_cache *shader_module_cache;
+    struct shader_module *vertex_shader_module;
+    struct shader_module *fragment_shader_module;
+    struct shader_reflection_layout shader_reflection_layout;
+    VkDescriptorSetLayout descriptor_set_layout;
+    VkPipelineLayout pipeline_layout;
+    VkDescriptorPool descriptor_pool;
+    VkDescriptorSet descriptor_set;
+    struct graphics_pipeline_description pipeline_description;
+    // The states the compiler makes dynamic are set to these before the draw,
+    // whatever the draws of the first subpass left behind.
+    struct graphics_pipeline_dynamic_state dynamic_state;
+    struct pipeline_future *pipeline_future;
+};
+
+// Requests the pipeline for the lighting subpass of render_pass. The shader
+// modules are held until deferred_lighting_destroy, which has to come after
+// the compiler is destroyed or idle.
+struct deferred_lighting *deferred_lighting_create(
+    const VkDevice device,
+    struct shader_module_cache *shader_module_cache,
+    struct pipeline_compiler *pipeline_compiler,
+    const VkRenderPass render_pass
+);
+
+void deferred_lighting_destroy(struct deferred_lighting *deferred_lighting);
+
+// Points the input attachments at the G-buffer, each time its images are
+// created. No submitted work may still use the descriptor set.
+void deferred_lighting_set_gbuffer(
+    struct deferred_lighting *deferred_lighting,
+    const VkImageView albedo_image_view,
+    const VkImageView depth_image_view
+);
+
+// Whether reloaded fullscreen and lighting shaders fit the pipeline layout.
+// The reason for a mismatch is printed as a warning.
+bool deferred_lighting_shaders_compatible(
+    const struct deferred_lighting *const deferred_lighting,
+    const struct shader_module *const vertex_shader_module,
+    const struct shader_module *const fragment_shader_module
+);
+
+// Recorded after vkCmdNextSubpass, with viewport, scissor and dynamic_state
+// already set. Records nothing while the pipeline is still compiling.
+void deferred_lighting_record(const struct deferred_lighting *const deferred_lighting, const VkCommandBuffer command_buffer);
+
+#endif
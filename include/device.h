@@ -3,10 +3,24 @@
 
 #include <vulkan/vulkan.h>
 
-VkDevice device_create(const VkPhysicalDevice physical_device, const uint32_t queue_family_index);
+VkDevice device_create(
+    const VkPhysicalDevice physical_device,
+    const uint32_t queue_family_index,
+    const uint32_t device_extension_count,
+    const char *const *const device_extension_names,
+    const void *const enabled_features
+);
 
 void device_destroy(const VkDevice device);
 
 VkQueue device_get_queue(const VkDevice device, const uint32_t queue_family_index);
 
+// Returns the first memory type allowed by memory_type_bits that has all of
+// memory_property_flags, or UINT32_MAX if there is none.
+uint32_t device_find_memory_type_index(
+    const VkPhysicalDeviceMemoryProperties physical_device_memory_properties,
+    const uint32_t memory_type_bits,
+    const VkMemoryPropertyFlags memory_property_flags
+);
+
 #endif
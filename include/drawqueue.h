@@ -0,0 +1,101 @@
+#ifndef DRAWQUEUE_H
+#define DRAWQUEUE_H
+
+#include <vulkan/vulkan.h>
+
+#include <pipeline.h>
+
+// Sort key layout, from the most to the least significant bits:
+// pass (4) | pipeline (12) | material (12) | vertex buffer (12) | depth (24).
+
+#define DRAW_QUEUE_PASS_BITS 4U
+#define DRAW_QUEUE_PIPELINE_BITS 12U
+#define DRAW_QUEUE_MATERIAL_BITS 12U
+#define DRAW_QUEUE_VERTEX_BUFFER_BITS 12U
+#define DRAW_QUEUE_DEPTH_BITS 24U
+
+// Vulkan guarantees at least 128 bytes of push constants.
+#define DRAW_PUSH_CONSTANT_SIZE 128U
+
+struct draw {
+    VkPipeline pipeline;
+    // Depth-only variant drawn first when the depth pre-pass is on, draws
+    // without one only appear in the main pass.
+    VkPipeline depth_prepass_pipeline;
+    VkPipelineLayout pipeline_layout;
+    VkDescriptorSet descriptor_set;
+    uint32_t dynamic_offset;
+    VkShaderStageFlags push_constant_stage_flags;
+    uint32_t push_constant_size;
+    uint8_t push_constant_data[DRAW_PUSH_CONSTANT_SIZE];
+    VkBuffer vertex_buffer;
+    VkBuffer index_buffer;
+    VkIndexType index_type;
+    uint32_t element_count;
+    uint32_t first_element;
+    int32_t vertex_offset;
+    struct graphics_pipeline_dynamic_state dynamic_state;
+};
+
+struct draw_queue_entry {
+    uint64_t key;
+    uint32_t draw_index;
+};
+
+struct draw_queue_handle_table {
+    uint64_t *handles;
+    uint32_t *ids;
+    uint32_t capacity;
+    uint32_t count;
+};
+
+struct draw_queue {
+    struct draw *draws;
+    struct draw_queue_entry *entries;
+    struct draw_queue_entry *scratch_entries;
+    struct draw_queue_handle_table pipeline_table;
+    struct draw_queue_handle_table vertex_buffer_table;
+    uint32_t draw_count;
+    uint32_t draw_capacity;
+    uint32_t skipped_draw_count;
+};
+
+struct draw_queue_statistics {
+    uint32_t draw_count;
+    uint32_t draws_skipped;
+    uint32_t pipeline_binds;
+    uint32_t vertex_buffer_binds;
+    uint32_t index_buffer_binds;
+    uint32_t descriptor_set_binds;
+    uint32_t push_constant_updates;
+    uint32_t dynamic_state_updates;
+    uint32_t binds_avoided;
+};
+
+struct draw_queue *draw_queue_create(void);
+
+void draw_queue_destroy(struct draw_queue *draw_queue);
+
+void draw_queue_reset(struct draw_queue *draw_queue);
+
+uint64_t draw_queue_make_key(
+    const uint32_t pass,
+    const uint32_t pipeline_id,
+    const uint32_t material_id,
+    const uint32_t vertex_buffer_id,
+    const float depth
+);
+
+// Draws whose pipeline is VK_NULL_HANDLE, typically still compiling, are
+// counted and dropped.
+void draw_queue_submit(
+    struct draw_queue *draw_queue,
+    const uint32_t pass,
+    const uint32_t material_id,
+    const float depth,
+    const struct draw *const draw
+);
+
+void draw_queue_sort(struct draw_queue *draw_queue);
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef DYNAMICRESOLUTION_H
+#define DYNAMICRESOLUTION_H
+
+#include <vulkan/vulkan.h>
+
+#include <stdbool.h>
+
+struct dynamic_resolution_statistics {
+    uint64_t sample_count;
+    uint32_t scale_decrease_count;
+    uint32_t scale_increase_count;
+};
+
+// Picks the resolution scale of the scene from the GPU time of the frames.
+// Each frame slot brackets its command buffer with two timestamps, which are
+// read once the fence of the slot has been waited on, so reading them never
+// blocks. Over the target the scale drops right away, under it the scale
+// creeps back up, so load spikes cost resolution instead of frames.
+struct dynamic_resolution {
+    VkDevice device;
+    VkQueryPool query_pool;
+    uint32_t slot_count;
+    bool *slot_pending;
+    // Nanoseconds per timestamp tick.
+    float timestamp_period;
+    // Only the timestampValidBits low bits of a timestamp count.
+    uint64_t timestamp_mask;
+    float min_scale;
+    float max_scale;
+    float scale;
+    // In milliseconds.
+    double target_gpu_time;
+    double gpu_time;
+    struct dynamic_resolution_statistics statistics;
+};
+
+// Needs timestampComputeAndGraphics. The scale starts out at max_scale.
+// timestamp_valid_bits is that of the queue family the frames run on.
+struct dynamic_resolution *dynamic_resolution_create(
+    const VkDevice device,
+    const VkPhysicalDeviceProperties physical_device_properties,
+    const uint32_t timestamp_valid_bits,
+    const uint32_t slot_count,
+    const float min_scale,
+    const float max_scale,
+    const double target_gpu_time
+);
+
+void dynamic_resolution_destroy(struct dynamic_resolution *dynamic_resolution);
+
+// For a new number of frame slots, pending measurements are dropped. The
+// device must be idle.
+void dynamic_resolution_resize(struct dynamic_resolution *dynamic_resolution, const uint32_t slot_count);
+
+// Called once the fence of slot has been waited on. A sample whose end is
+// before its start, which happens when the counter wraps, is skipped.
+void dynamic_resolution_update(struct dynamic_resolution *dynamic_resolution, const uint32_t slot);
+
+// First and last commands of the command buffer of slot.
+void dynamic_resolution_record_begin(const struct dynamic_resolution *dynamic_resolution, const VkCommandBuffer command_buffer, const uint32_t slot);
+
+void dynamic_resolution_record_end(struct dynamic_resolution *dynamic_resolution, const VkCommandBuffer command_buffer, const uint32_t slot);
+
+// Never less than one pixel in either direction.
+VkExtent2D dynamic_resolution_scale_extent(const VkExtent2D extent, const float scale);
+
+#endif
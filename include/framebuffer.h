@@ -3,18 +3,62 @@
 
 #include <vulkan/vulkan.h>
 
-VkFramebuffer *framebuffers_create(
+#define FRAMEBUFFER_MAX_ATTACHMENTS 8U
+
+VkFramebuffer framebuffer_create(
     const VkDevice device,
-    const VkSurfaceCapabilitiesKHR surface_capabilities,
-    const VkImageView *const image_views,
     const VkRenderPass render_pass,
-    const uint32_t swapchain_image_count
+    const uint32_t attachment_count,
+    const VkImageView *const attachments,
+    const VkExtent2D extent
 );
 
-void framebuffers_destroy(
-    const VkDevice device,
-    VkFramebuffer *framebuffers,
-    const uint32_t framebuffer_count
+void framebuffer_destroy(const VkDevice device, const VkFramebuffer framebuffer);
+
+// Zeroed before it is filled, it is hashed and compared as bytes.
+struct framebuffer_key {
+    VkRenderPass render_pass;
+    uint32_t attachment_count;
+    VkImageView attachments[FRAMEBUFFER_MAX_ATTACHMENTS];
+    VkExtent2D extent;
+};
+
+struct framebuffer_cache_entry {
+    struct framebuffer_key key;
+    uint64_t hash;
+    VkFramebuffer framebuffer;
+};
+
+struct framebuffer_cache_statistics {
+    uint32_t request_count;
+    uint32_t hit_count;
+    uint32_t create_count;
+    uint32_t framebuffer_count;
+};
+
+// Framebuffers by render pass, attachments and extent, created on first use.
+// A framebuffer must not outlive its image views, so whoever destroys a view
+// evicts it first, once no submitted work uses its framebuffers any more.
+struct framebuffer_cache {
+    VkDevice device;
+    struct framebuffer_cache_entry *entries;
+    uint32_t entry_capacity;
+    struct framebuffer_cache_statistics statistics;
+};
+
+struct framebuffer_cache *framebuffer_cache_create(const VkDevice device);
+
+void framebuffer_cache_destroy(struct framebuffer_cache *framebuffer_cache);
+
+VkFramebuffer framebuffer_cache_get(
+    struct framebuffer_cache *framebuffer_cache,
+    const VkRenderPass render_pass,
+    const uint32_t attachment_count,
+    const VkImageView *const attachments,
+    const VkExtent2D extent
 );
 
+// Destroys every framebuffer that uses image_view.
+void framebuffer_cache_evict_image_view(struct framebuffer_cache *framebuffer_cache, const VkImageView image_view);
+
 #endif
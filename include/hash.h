@@ -0,0 +1,11 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+uint64_t hash_bytes(const void *const data, const size_t size, const uint64_t seed);
+
+uint64_t hash_combine(const uint64_t hash, const uint64_t value);
+
+#endif
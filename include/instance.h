@@ -3,6 +3,8 @@
 
 #include <vulkan/vulkan.h>
 
+#include <stdbool.h>
+
 VkInstance instance_create(
     const uint32_t enabled_layer_count,
     const char *const *const enabled_layer_names,
@@ -18,6 +20,33 @@ VkPhysicalDeviceProperties physical_device_get_properties(const VkPhysicalDevice
 
 VkPhysicalDeviceMemoryProperties physical_device_get_memory_properties(const VkPhysicalDevice physical_device);
 
-uint32_t physical_device_find_queue_family_index(const VkPhysicalDevice physical_device, const VkQueueFlagBits queue_flag_bits);
+// The first queue family that has every flag of queue_flags.
+uint32_t physical_device_find_queue_family_index(const VkPhysicalDevice physical_device, const VkQueueFlags queue_flags);
+
+VkQueueFamilyProperties physical_device_get_queue_family_properties(const VkPhysicalDevice physical_device, const uint32_t queue_family_index);
+
+VkPhysicalDeviceVulkan12Features physical_device_get_vulkan_12_features(const VkPhysicalDevice physical_device);
+
+VkPhysicalDeviceFeatures physical_device_get_features(const VkPhysicalDevice physical_device);
+
+bool physical_device_supports_extension(const VkPhysicalDevice physical_device, const char *const extension_name);
+
+// Every feature is unset when the extension is not supported.
+VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT physical_device_get_graphics_pipeline_library_features(const VkPhysicalDevice physical_device);
+
+VkPhysicalDeviceExtendedDynamicStateFeaturesEXT physical_device_get_extended_dynamic_state_features(const VkPhysicalDevice physical_device);
+
+VkPhysicalDeviceExtendedDynamicState3FeaturesEXT physical_device_get_extended_dynamic_state_3_features(const VkPhysicalDevice physical_device);
+
+// The instance targets Vulkan 1.2, so dynamic rendering always comes from
+// VK_KHR_dynamic_rendering, also on 1.3 devices where it is core.
+VkPhysicalDeviceDynamicRenderingFeaturesKHR physical_device_get_dynamic_rendering_features(const VkPhysicalDevice physical_device);
+
+// The most precise depth-only format usable as an optimal tiling attachment.
+VkFormat physical_device_choose_depth_format(const VkPhysicalDevice physical_device);
+
+// The highest sample count up to requested_sample_count that both color and
+// depth framebuffer attachments support.
+VkSampleCountFlagBits physical_device_choose_sample_count(const VkPhysicalDeviceProperties physical_device_properties, const uint32_t requested_sample_count);
 
 #endif
@@ -0,0 +1,31 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <vulkan/vulkan.h>
+
+struct mesh {
+    void *vertex_data;
+    void *index_data;
+    uint32_t vertex_count;
+    uint32_t vertex_stride;
+    uint32_t index_count;
+    VkIndexType index_type;
+};
+
+struct mesh *mesh_create_welded(
+    const void *const vertex_data,
+    const uint32_t vertex_count,
+    const uint32_t vertex_stride
+);
+
+void mesh_destroy(struct mesh *mesh);
+
+VkIndexType mesh_choose_index_type(const uint32_t vertex_count);
+
+uint32_t mesh_get_index_size(const VkIndexType index_type);
+
+uint32_t mesh_get_vertex_data_size(const struct mesh *const mesh);
+
+uint32_t mesh_get_index_data_size(const struct mesh *const mesh);
+
+#endif
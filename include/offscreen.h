@@ -0,0 +1,25 @@
+#ifndef OFFSCREEN_H
+#define OFFSCREEN_H
+
+#include <vulkan/vulkan.h>
+
+// A ring of color images that stands in for a swapchain when there is no
+// surface. The images can be rendered to, copied from and blitted to.
+struct offscreen_images {
+    uint32_t image_count;
+    VkImage *images;
+    VkImageView *image_views;
+    VkDeviceMemory *device_memories;
+};
+
+struct offscreen_images *offscreen_images_create(
+    const VkDevice device,
+    const VkPhysicalDeviceMemoryProperties physical_device_memory_properties,
+    const VkFormat format,
+    const VkExtent2D extent,
+    const uint32_t image_count
+);
+
+void offscreen_images_destroy(const VkDevice device, struct offscreen_images *offscreen_images);
+
+#endif
@@ -3,17 +3,205 @@
 
 #include <vulkan/vulkan.h>
 
-VkPipelineLayout pipeline_layout_create(const VkDevice device);
+#include <shadermodule.h>
+#include <shaderreflection.h>
+
+#include <stdbool.h>
+
+VkPipelineLayout pipeline_layout_create(
+    const VkDevice device,
+    const uint32_t descriptor_set_layout_count,
+    const VkDescriptorSetLayout *const descriptor_set_layouts,
+    const uint32_t push_constant_range_count,
+    const VkPushConstantRange *const push_constant_ranges
+);
 
 void pipeline_layout_destroy(const VkPipelineLayout pipeline_layout, const VkDevice device);
 
+// Plain data describing a graphics pipeline. It is hashed and compared byte
+// by byte, so it must be set up with graphics_pipeline_description_init
+// before fields are assigned. Viewport and scissor are always dynamic.
+//
+// With the extended dynamic state extensions more of the fixed function state
+// can be set while recording. The description then only keeps a default for
+// those fields, so every description that differs in dynamic state alone maps
+// to the same pipeline, and the draw carries the actual values instead.
+
+#define GRAPHICS_PIPELINE_MAX_VERTEX_ATTRIBUTES 8U
+#define GRAPHICS_PIPELINE_MAX_SPECIALIZATION_CONSTANTS 8U
+
+struct graphics_pipeline_vertex_attribute {
+    uint32_t location;
+    VkFormat format;
+    uint32_t offset;
+};
+
+// 32 bit specialization constant values of one stage, sorted by constant id
+// so that equal variants hash equally. Unset constants keep their defaults.
+struct graphics_pipeline_specialization {
+    uint32_t constant_count;
+    uint32_t constant_ids[GRAPHICS_PIPELINE_MAX_SPECIALIZATION_CONSTANTS];
+    uint32_t values[GRAPHICS_PIPELINE_MAX_SPECIALIZATION_CONSTANTS];
+};
+
+enum graphics_pipeline_dynamic_state_flag_bits {
+    GRAPHICS_PIPELINE_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_BIT = 0x001,
+    GRAPHICS_PIPELINE_DYNAMIC_STATE_CULL_MODE_BIT = 0x002,
+    GRAPHICS_PIPELINE_DYNAMIC_STATE_FRONT_FACE_BIT = 0x004,
+    GRAPHICS_PIPELINE_DYNAMIC_STATE_DEPTH_TEST_ENABLE_BIT = 0x008,
+    GRAPHICS_PIPELINE_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_BIT = 0x010,
+    GRAPHICS_PIPELINE_DYNAMIC_STATE_DEPTH_COMPARE_OP_BIT = 0x020,
+    GRAPHICS_PIPELINE_DYNAMIC_STATE_POLYGON_MODE_BIT = 0x040,
+    GRAPHICS_PIPELINE_DYNAMIC_STATE_COLOR_BLEND_ENABLE_BIT = 0x080,
+    GRAPHICS_PIPELINE_DYNAMIC_STATE_COLOR_BLEND_EQUATION_BIT = 0x100
+};
+
+// The states of VK_EXT_extended_dynamic_state.
+#define GRAPHICS_PIPELINE_DYNAMIC_STATES_EXTENDED ( \
+    GRAPHICS_PIPELINE_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_BIT | \
+    GRAPHICS_PIPELINE_DYNAMIC_STATE_CULL_MODE_BIT | \
+    GRAPHICS_PIPELINE_DYNAMIC_STATE_FRONT_FACE_BIT | \
+    GRAPHICS_PIPELINE_DYNAMIC_STATE_DEPTH_TEST_ENABLE_BIT | \
+    GRAPHICS_PIPELINE_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_BIT | \
+    GRAPHICS_PIPELINE_DYNAMIC_STATE_DEPTH_COMPARE_OP_BIT \
+)
+
+// Values of the state that may be dynamic, as set for a draw.
+struct graphics_pipeline_dynamic_state {
+    VkPrimitiveTopology topology;
+    VkPolygonMode polygon_mode;
+    VkCullModeFlags cull_mode;
+    VkFrontFace front_face;
+    VkBool32 blend_enable;
+    VkColorBlendEquationEXT color_blend_equation;
+    VkBool32 depth_test_enable;
+    VkBool32 depth_write_enable;
+    VkCompareOp depth_compare_op;
+};
+
+struct graphics_pipeline_description {
+    VkShaderModule vertex_shader_module;
+    VkShaderModule fragment_shader_module;
+    uint64_t vertex_shader_content_hash;
+    uint64_t fragment_shader_content_hash;
+    struct graphics_pipeline_specialization vertex_specialization;
+    struct graphics_pipeline_specialization fragment_specialization;
+    VkPipelineLayout pipeline_layout;
+    VkRenderPass render_pass;
+    uint32_t subpass;
+    // With a null render_pass the pipeline is built for dynamic rendering into
+    // attachments of these formats, so it survives render pass recreation.
+    VkFormat color_attachment_format;
+    VkFormat depth_attachment_format;
+    uint32_t vertex_stride;
+    uint32_t vertex_attribute_count;
+    struct graphics_pipeline_vertex_attribute vertex_attributes[GRAPHICS_PIPELINE_MAX_VERTEX_ATTRIBUTES];
+    VkPrimitiveTopology topology;
+    VkPolygonMode polygon_mode;
+    VkCullModeFlags cull_mode;
+    VkFrontFace front_face;
+    VkSampleCountFlagBits sample_count;
+    VkBool32 blend_enable;
+    VkBlendFactor src_color_blend_factor;
+    VkBlendFactor dst_color_blend_factor;
+    VkBlendOp color_blend_op;
+    VkBlendFactor src_alpha_blend_factor;
+    VkBlendFactor dst_alpha_blend_factor;
+    VkBlendOp alpha_blend_op;
+    // Zero for depth-only pipelines such as a depth pre-pass.
+    VkColorComponentFlags color_write_mask;
+    VkBool32 depth_test_enable;
+    VkBool32 depth_write_enable;
+    VkCompareOp depth_compare_op;
+    uint32_t dynamic_state_flags;
+};
+
+void graphics_pipeline_description_init(struct graphics_pipeline_description *description);
+
+// Makes the given states dynamic and resets their fields to the defaults of
+// graphics_pipeline_description_init. A dynamic topology keeps its topology
+// class, which the pipeline still has to match.
+void graphics_pipeline_description_set_dynamic_states(
+    struct graphics_pipeline_description *description,
+    const uint32_t dynamic_state_flags
+);
+
+// Takes the values of every state that may be dynamic from a description that
+// has not been passed through graphics_pipeline_description_set_dynamic_states.
+struct graphics_pipeline_dynamic_state graphics_pipeline_description_get_dynamic_state(
+    const struct graphics_pipeline_description *const description
+);
+
+// Sets the shader modules together with their content hashes, so that a
+// module handle recycled by the driver never matches a stale description.
+void graphics_pipeline_description_set_shaders(
+    struct graphics_pipeline_description *description,
+    const struct shader_module *const vertex_shader_module,
+    const struct shader_module *const fragment_shader_module
+);
+
+// Sets a specialization constant by its name in the shader source. The stage
+// follows from the module, booleans take 0 or 1 and floats their bit pattern.
+void graphics_pipeline_description_set_specialization_constant(
+    struct graphics_pipeline_description *description,
+    const struct shader_module *const shader_module,
+    const char *const name,
+    const uint32_t value
+);
+
+// Interleaves the vertex shader inputs in location order into binding 0.
+void graphics_pipeline_description_set_vertex_input(
+    struct graphics_pipeline_description *description,
+    const struct shader_reflection *const vertex_shader_reflection
+);
+
+uint64_t graphics_pipeline_description_hash(const struct graphics_pipeline_description *const description);
+
+bool graphics_pipeline_description_equal(
+    const struct graphics_pipeline_description *const description_a,
+    const struct graphics_pipeline_description *const description_b
+);
+
+// The shader modules are not destroyed, they stay owned by the caller.
 VkPipeline graphics_pipeline_create(
     const VkDevice device,
-    const VkSurfaceCapabilitiesKHR surface_capabilities,
-    const VkRenderPass render_pass,
-    const VkShaderModule vertex_shader_module,
-    const VkShaderModule fragment_shader_module,
-    const VkPipelineLayout pipeline_layout
+    const VkPipelineCache pipeline_cache,
+    const struct graphics_pipeline_description *const description
+);
+
+// Pipeline libraries of VK_EXT_graphics_pipeline_library. A description is
+// split into four parts, each of which only depends on some of its fields.
+// The other fields of a part description keep their defaults, so a part is
+// shared by every description that agrees on the fields it depends on.
+void graphics_pipeline_description_get_library_part(
+    const struct graphics_pipeline_description *const description,
+    const VkGraphicsPipelineLibraryFlagBitsEXT library_part,
+    struct graphics_pipeline_description *part_description
+);
+
+VkPipeline graphics_pipeline_library_create(
+    const VkDevice device,
+    const VkPipelineCache pipeline_cache,
+    const struct graphics_pipeline_description *const description,
+    const VkGraphicsPipelineLibraryFlagBitsEXT library_part
+);
+
+// A link without optimize is fast enough to happen when a pipeline is first
+// needed, an optimized link produces code on par with a complete pipeline.
+VkPipeline graphics_pipeline_library_link(
+    const VkDevice device,
+    const VkPipelineCache pipeline_cache,
+    const VkPipelineLayout pipeline_layout,
+    const uint32_t library_count,
+    const VkPipeline *const libraries,
+    const bool optimize
+);
+
+VkPipeline compute_pipeline_create(
+    const VkDevice device,
+    const VkPipelineCache pipeline_cache,
+    const VkShaderModule compute_shader_module,
+    const VkPipelineLayout compute_pipeline_layout
 );
 
 void pipeline_destroy(const VkDevice device, const VkPipeline pipeline);
@@ -0,0 +1,26 @@
+#ifndef PIPELINECACHE_H
+#define PIPELINECACHE_H
+
+#include <vulkan/vulkan.h>
+
+#include <stdbool.h>
+
+// Creates a pipeline cache seeded from the file at path. The file is ignored
+// when it is missing or was written by a different driver or device.
+VkPipelineCache pipeline_cache_create(
+    const VkDevice device,
+    const VkPhysicalDeviceProperties physical_device_properties,
+    const char *const path,
+    bool *const loaded
+);
+
+size_t pipeline_cache_get_data_size(const VkDevice device, const VkPipelineCache pipeline_cache);
+
+// Writes the cache to a temporary file next to path and renames it over path,
+// so a crash never leaves a truncated cache behind. Pipelines may be created
+// into the cache from other threads meanwhile.
+void pipeline_cache_save(const VkDevice device, const VkPipelineCache pipeline_cache, const char *const path);
+
+void pipeline_cache_destroy(const VkDevice device, const VkPipelineCache pipeline_cache);
+
+#endif
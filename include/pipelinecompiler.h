@@ -0,0 +1,170 @@
+#ifndef PIPELINECOMPILER_H
+#define PIPELINECOMPILER_H
+
+#include <vulkan/vulkan.h>
+
+#include <pipeline.h>
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+// Pipelines are compiled by a pool of worker threads. The VkPipelineCache is
+// shared by all workers, which is safe because pipeline caches are internally
+// synchronized unless created with the externally synchronized flag.
+//
+// Requests are deduplicated by their description: a hash map from description
+// to future makes a repeated request an O(1) lookup returning the same future,
+// whether the pipeline is still compiling or done.
+//
+// With graphics pipeline libraries the four parts of a description are built
+// and cached on their own, so a new permutation usually only needs a fast link
+// of existing parts. The future becomes ready with the fast linked pipeline
+// and switches to an optimized link built once no other compile is queued.
+//
+// Pipelines built from a replaced shader are retired instead of destroyed:
+// they leave the map at once and are destroyed once the frames that may still
+// use them have completed.
+
+#define PIPELINE_COMPILER_LIBRARY_PART_COUNT 4U
+
+enum pipeline_future_state {
+    PIPELINE_FUTURE_STATE_PENDING = 0,
+    PIPELINE_FUTURE_STATE_READY
+};
+
+struct pipeline_future {
+    atomic_int state;
+    _Atomic(VkPipeline) pipeline;
+    VkPipeline fast_linked_pipeline;
+    double compile_time;
+    struct graphics_pipeline_description description;
+    VkGraphicsPipelineLibraryFlagBitsEXT library_part;
+    struct pipeline_future *libraries[PIPELINE_COMPILER_LIBRARY_PART_COUNT];
+    uint32_t reference_count;
+    uint32_t job_count;
+    struct pipeline_future *next_job;
+    struct pipeline_future *next_retired;
+    uint64_t retire_frame;
+    pthread_mutex_t mutex;
+    pthread_cond_t condition;
+};
+
+struct pipeline_compiler_entry {
+    uint64_t hash;
+    struct pipeline_future *future;
+};
+
+struct pipeline_compiler_statistics {
+    uint32_t request_count;
+    uint32_t hit_count;
+    uint32_t compile_count;
+    double compile_time;
+    double max_compile_time;
+    uint32_t library_count;
+    uint32_t library_hit_count;
+    uint32_t optimized_link_count;
+    double optimized_link_time;
+};
+
+struct pipeline_compiler {
+    VkDevice device;
+    VkPipelineCache pipeline_cache;
+    bool use_graphics_pipeline_library;
+    uint32_t dynamic_state_flags;
+    pthread_t *threads;
+    uint32_t thread_count;
+    pthread_mutex_t mutex;
+    pthread_cond_t condition;
+    pthread_cond_t idle_condition;
+    struct pipeline_future *job_head;
+    struct pipeline_future *job_tail;
+    struct pipeline_future *optimize_job_head;
+    struct pipeline_future *optimize_job_tail;
+    uint32_t pending_job_count;
+    struct pipeline_compiler_entry *entries;
+    uint32_t entry_capacity;
+    uint32_t entry_count;
+    struct pipeline_compiler_entry *library_entries;
+    uint32_t library_entry_capacity;
+    uint32_t library_entry_count;
+    struct pipeline_future *retired_head;
+    // A queued save of pipeline_cache, see pipeline_compiler_request_cache_save.
+    const char *pipeline_cache_save_path;
+    bool pipeline_cache_saving;
+    size_t pipeline_cache_saved_size;
+    struct pipeline_compiler_statistics statistics;
+    bool stopping;
+};
+
+// use_graphics_pipeline_library requires VK_EXT_graphics_pipeline_library and
+// its graphicsPipelineLibrary feature to be enabled on the device. The states
+// in dynamic_state_flags are made dynamic in every requested pipeline, their
+// extensions and features have to be enabled as well.
+struct pipeline_compiler *pipeline_compiler_create(
+    const VkDevice device,
+    const VkPipelineCache pipeline_cache,
+    const uint32_t thread_count,
+    const bool use_graphics_pipeline_library,
+    const uint32_t dynamic_state_flags
+);
+
+// Finishes all queued compiles, joins the workers and destroys every
+// pipeline. Optimized links and cache saves that have not started yet are
+// skipped.
+void pipeline_compiler_destroy(struct pipeline_compiler *pipeline_compiler);
+
+// Returns the future of an identical earlier request, or queues a new compile
+// and returns immediately. The future and its pipeline belong to the compiler.
+// Requests that only differ in dynamic state share one future, whose
+// description has the dynamic state fields reset. The shader modules of the
+// description must stay acquired until it is ready.
+struct pipeline_future *pipeline_compiler_request_graphics(
+    struct pipeline_compiler *pipeline_compiler,
+    const struct graphics_pipeline_description *const description
+);
+
+// Retires every pipeline and library whose vertex or fragment shader has the
+// given content hash. frame is the first frame that no longer uses them.
+void pipeline_compiler_retire_shader(
+    struct pipeline_compiler *pipeline_compiler,
+    const uint64_t shader_content_hash,
+    const uint64_t frame
+);
+
+// Retires every pipeline and library built against the given render pass,
+// which stays alive in the render pass cache until they are destroyed.
+void pipeline_compiler_retire_render_pass(
+    struct pipeline_compiler *pipeline_compiler,
+    const VkRenderPass render_pass,
+    const uint64_t frame
+);
+
+// Destroys retired pipelines that are compiled and no longer used once
+// completed_frame_count frames have completed. Never blocks. Returns true when
+// nothing retired is left, from then on the replaced shader modules are no
+// longer referenced by any compile.
+bool pipeline_compiler_collect_retired(struct pipeline_compiler *pipeline_compiler, const uint64_t completed_frame_count);
+
+// Queues a pipeline_cache_save of the pipeline cache to path, which has to stay
+// valid until the save completes. A worker runs it once no compile is waiting
+// and skips it when the cache has not grown since the last save. Never blocks,
+// and does nothing while a save is still queued.
+void pipeline_compiler_request_cache_save(struct pipeline_compiler *pipeline_compiler, const char *const path);
+
+// Blocks until every queued job, optimized links and cache saves included, has
+// completed.
+void pipeline_compiler_wait_idle(struct pipeline_compiler *pipeline_compiler);
+
+struct pipeline_compiler_statistics pipeline_compiler_get_statistics(struct pipeline_compiler *pipeline_compiler);
+
+bool pipeline_future_is_ready(const struct pipeline_future *const pipeline_future);
+
+// Returns the pipeline if it is ready and fallback_pipeline otherwise. Never
+// blocks. The result may change once while a fast linked pipeline is replaced
+// by its optimized link, both stay valid as long as the future.
+VkPipeline pipeline_future_get(const struct pipeline_future *const pipeline_future, const VkPipeline fallback_pipeline);
+
+VkPipeline pipeline_future_wait(struct pipeline_future *pipeline_future);
+
+#endif
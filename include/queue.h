@@ -11,14 +11,34 @@ VkFence *fences_create(const VkDevice device, const uint32_t swapchain_image_cou
 
 void fences_destroy(const VkDevice device, VkFence *fences, const uint32_t swapchain_image_count);
 
-void queue_draw(
-    const VkQueue queue,
+// Resets the fence once it is signaled, so it can be submitted again.
+void queue_wait_for_fence(const VkDevice device, const VkFence fence);
+
+uint32_t queue_acquire_next_image(
     const VkDevice device,
     const VkSwapchainKHR swapchain,
-    const VkCommandBuffer *command_buffers,
     const VkSemaphore semaphore_image_available,
-    const VkSemaphore semaphore_image_rendered,
     const VkFence *fences
 );
 
+void queue_submit_and_present(
+    const VkQueue queue,
+    const VkSwapchainKHR swapchain,
+    const VkCommandBuffer command_buffer,
+    const VkSemaphore semaphore_image_available,
+    const VkSemaphore semaphore_image_rendered,
+    const VkFence fence,
+    const uint32_t image_index
+);
+
+// For rendering without a swapchain, nothing is waited on. Unless it is null,
+// timeline_semaphore is signaled with timeline_value.
+void queue_submit(
+    const VkQueue queue,
+    const VkCommandBuffer command_buffer,
+    const VkFence fence,
+    const VkSemaphore timeline_semaphore,
+    const uint64_t timeline_value
+);
+
 #endif
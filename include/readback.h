@@ -0,0 +1,73 @@
+#ifndef READBACK_H
+#define READBACK_H
+
+#include <vulkan/vulkan.h>
+
+#include <stdbool.h>
+
+// pixels are tightly packed rows of the frame and only valid during the call.
+typedef void (*readback_consumer_function)(const void *const pixels, const VkExtent2D extent, const uint64_t frame_index, void *user_data);
+
+struct readback_slot {
+    VkBuffer buffer;
+    VkDeviceMemory device_memory;
+    void *mapped_data;
+    uint64_t frame_index;
+    bool pending;
+};
+
+struct readback_statistics {
+    uint64_t frame_count;
+    uint64_t byte_count;
+    // Frames between the copy and the consumer call, summed over all frames.
+    uint64_t latency_frame_count;
+    // Times a slot was needed before its copy had finished.
+    uint32_t stall_count;
+};
+
+// Copies of finished frames into a ring of host visible buffers, host cached
+// when the device has them. Frame n signals n + 1 on the timeline semaphore,
+// and readback_poll hands every finished copy to the consumer without
+// waiting. With at least as many slots as frames in flight a slot is free
+// again by the time the ring comes back to it.
+struct readback {
+    VkDevice device;
+    VkSemaphore timeline_semaphore;
+    VkExtent2D extent;
+    VkDeviceSize frame_size;
+    bool host_coherent;
+    uint32_t slot_count;
+    struct readback_slot *slots;
+    uint32_t slot_index;
+    readback_consumer_function consumer;
+    void *user_data;
+    struct readback_statistics statistics;
+};
+
+// Needs the timelineSemaphore feature. Only formats with 4, 8 or 16 byte
+// texels are supported.
+struct readback *readback_create(
+    const VkDevice device,
+    const VkPhysicalDeviceMemoryProperties physical_device_memory_properties,
+    const VkExtent2D extent,
+    const VkFormat format,
+    const uint32_t slot_count,
+    const readback_consumer_function consumer,
+    void *user_data
+);
+
+// Pending copies are dropped, the device must be idle.
+void readback_destroy(struct readback *readback);
+
+// Takes the slot of frame_index and returns the buffer that frame copies into.
+VkBuffer readback_begin_frame(struct readback *readback, const uint64_t frame_index);
+
+// Copies image, in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, into the buffer of
+// the current slot. Barriers are recorded by the caller.
+void readback_record_copy(const struct readback *readback, const VkCommandBuffer command_buffer, const VkImage image);
+
+// Hands the finished copies to the consumer, frame_index is the frame being
+// recorded.
+void readback_poll(struct readback *readback, const uint64_t frame_index);
+
+#endif
@@ -0,0 +1,216 @@
+#ifndef RENDERGRAPH_H
+#define RENDERGRAPH_H
+
+#include <vulkan/vulkan.h>
+
+#include <stdbool.h>
+
+// A frame render graph. Passes declare which images and buffers they access
+// and how, the graph is compiled once and executed every frame:
+//
+// - passes that contribute nothing to an output resource are culled,
+// - before every pass one batched vkCmdPipelineBarrier makes earlier writes
+//   visible and moves images into the layouts the pass needs,
+// - transient resources are created by the graph and placed into shared
+//   memory, resources whose pass ranges do not overlap may share bytes.
+//   There is one copy of each for all frames in flight, so the first use in
+//   an execution waits for the previous execution's uses of that memory.
+//
+// Imported resources, such as the swapchain image, are owned by the caller,
+// their handles may change every frame. Each resource is accessed at most once
+// per pass. Passes run in the order they were added.
+
+#define RENDER_GRAPH_MAX_RESOURCES 32U
+#define RENDER_GRAPH_MAX_PASSES 32U
+#define RENDER_GRAPH_MAX_PASS_ACCESSES 8U
+
+enum render_graph_access_type {
+    RENDER_GRAPH_ACCESS_COLOR_ATTACHMENT_WRITE = 0,
+    RENDER_GRAPH_ACCESS_DEPTH_ATTACHMENT_WRITE,
+    RENDER_GRAPH_ACCESS_DEPTH_ATTACHMENT_READ,
+    RENDER_GRAPH_ACCESS_INPUT_ATTACHMENT_READ,
+    // Written as an attachment and read back as an input attachment by a later
+    // subpass of the same pass. The render pass moves the image between the
+    // layouts of its subpasses and returns it to the attachment layout.
+    RENDER_GRAPH_ACCESS_COLOR_INPUT_ATTACHMENT,
+    RENDER_GRAPH_ACCESS_DEPTH_INPUT_ATTACHMENT,
+    RENDER_GRAPH_ACCESS_FRAGMENT_SAMPLED_READ,
+    RENDER_GRAPH_ACCESS_COMPUTE_SAMPLED_READ,
+    RENDER_GRAPH_ACCESS_COMPUTE_STORAGE_READ,
+    RENDER_GRAPH_ACCESS_COMPUTE_STORAGE_WRITE,
+    RENDER_GRAPH_ACCESS_TRANSFER_READ,
+    RENDER_GRAPH_ACCESS_TRANSFER_WRITE,
+    RENDER_GRAPH_ACCESS_VERTEX_BUFFER_READ,
+    RENDER_GRAPH_ACCESS_INDEX_BUFFER_READ,
+    RENDER_GRAPH_ACCESS_INDIRECT_BUFFER_READ,
+    RENDER_GRAPH_ACCESS_TYPE_COUNT
+};
+
+// Synchronization state of a resource before or after the graph.
+struct render_graph_resource_state {
+    VkPipelineStageFlags stage_mask;
+    VkAccessFlags access_mask;
+    VkImageLayout layout;
+};
+
+struct render_graph_image_description {
+    VkFormat format;
+    VkExtent2D extent;
+    VkSampleCountFlagBits sample_count;
+    // Only accessed as an attachment and never stored, lazily allocated
+    // memory is used when the device has it.
+    bool transient_attachment;
+};
+
+struct render_graph;
+
+// frame_data is what was passed to render_graph_execute.
+typedef void (*render_graph_record_function)(const VkCommandBuffer command_buffer, const struct render_graph *render_graph, void *frame_data);
+
+struct render_graph_access {
+    uint32_t resource;
+    enum render_graph_access_type type;
+};
+
+struct render_graph_barrier {
+    uint32_t resource;
+    VkAccessFlags src_access_mask;
+    VkAccessFlags dst_access_mask;
+    VkImageLayout old_layout;
+    VkImageLayout new_layout;
+};
+
+// One vkCmdPipelineBarrier, recorded before a pass or after the last one.
+struct render_graph_barrier_batch {
+    VkPipelineStageFlags src_stage_mask;
+    VkPipelineStageFlags dst_stage_mask;
+    uint32_t barrier_count;
+    struct render_graph_barrier barriers[RENDER_GRAPH_MAX_RESOURCES];
+};
+
+struct render_graph_pass {
+    char name[32];
+    render_graph_record_function record;
+    uint32_t access_count;
+    struct render_graph_access accesses[RENDER_GRAPH_MAX_PASS_ACCESSES];
+    bool culled;
+    struct render_graph_barrier_batch barrier_batch;
+};
+
+struct render_graph_resource {
+    char name[32];
+    bool is_image;
+    bool imported;
+    bool output;
+    struct render_graph_image_description image_description;
+    VkDeviceSize buffer_size;
+    VkImageUsageFlags image_usage;
+    VkBufferUsageFlags buffer_usage;
+    VkImage image;
+    VkImageView image_view;
+    VkBuffer buffer;
+    struct render_graph_resource_state initial_state;
+    struct render_graph_resource_state final_state;
+    uint32_t first_pass;
+    uint32_t last_pass;
+    VkMemoryRequirements memory_requirements;
+    uint32_t memory_type_index;
+    VkDeviceSize memory_offset;
+};
+
+struct render_graph_statistics {
+    uint32_t pass_count;
+    uint32_t culled_pass_count;
+    uint32_t barrier_batch_count;
+    uint32_t image_barrier_count;
+    uint32_t buffer_barrier_count;
+    uint32_t transient_resource_count;
+    VkDeviceSize transient_memory_size;
+    // What the transient resources would take without aliasing.
+    VkDeviceSize unaliased_memory_size;
+};
+
+struct render_graph {
+    VkDevice device;
+    VkPhysicalDeviceMemoryProperties physical_device_memory_properties;
+    VkDeviceSize buffer_image_granularity;
+    uint32_t resource_count;
+    struct render_graph_resource resources[RENDER_GRAPH_MAX_RESOURCES];
+    uint32_t pass_count;
+    struct render_graph_pass passes[RENDER_GRAPH_MAX_PASSES];
+    struct render_graph_barrier_batch final_barrier_batch;
+    uint32_t memory_count;
+    VkDeviceMemory memories[VK_MAX_MEMORY_TYPES];
+    bool compiled;
+    struct render_graph_statistics statistics;
+};
+
+struct render_graph *render_graph_create(
+    const VkDevice device,
+    const VkPhysicalDeviceProperties physical_device_properties,
+    const VkPhysicalDeviceMemoryProperties physical_device_memory_properties
+);
+
+void render_graph_destroy(struct render_graph *render_graph);
+
+// Destroys the transient resources and forgets every pass and resource, so
+// the graph can be built again, for example after a resize.
+void render_graph_reset(struct render_graph *render_graph);
+
+// The image is set with render_graph_set_image before each execution.
+uint32_t render_graph_import_image(
+    struct render_graph *render_graph,
+    const char *const name,
+    const VkFormat format,
+    const struct render_graph_resource_state initial_state
+);
+
+uint32_t render_graph_import_buffer(
+    struct render_graph *render_graph,
+    const char *const name,
+    const VkBuffer buffer,
+    const struct render_graph_resource_state initial_state
+);
+
+uint32_t render_graph_create_image(
+    struct render_graph *render_graph,
+    const char *const name,
+    const struct render_graph_image_description *const image_description
+);
+
+uint32_t render_graph_create_buffer(struct render_graph *render_graph, const char *const name, const VkDeviceSize size);
+
+// Output resources keep the passes writing them alive. Imported outputs are
+// left in final_state after the last pass.
+void render_graph_set_output(
+    struct render_graph *render_graph,
+    const uint32_t resource,
+    const struct render_graph_resource_state final_state
+);
+
+uint32_t render_graph_add_pass(struct render_graph *render_graph, const char *const name, const render_graph_record_function record);
+
+void render_graph_pass_access(
+    struct render_graph *render_graph,
+    const uint32_t pass,
+    const uint32_t resource,
+    const enum render_graph_access_type access_type
+);
+
+// Culls passes, computes the barriers and creates the transient resources.
+void render_graph_compile(struct render_graph *render_graph);
+
+void render_graph_set_image(struct render_graph *render_graph, const uint32_t resource, const VkImage image, const VkImageView image_view);
+
+// For imported buffers that change from frame to frame.
+void render_graph_set_buffer(struct render_graph *render_graph, const uint32_t resource, const VkBuffer buffer);
+
+void render_graph_execute(struct render_graph *render_graph, const VkCommandBuffer command_buffer, void *frame_data);
+
+VkImage render_graph_get_image(const struct render_graph *render_graph, const uint32_t resource);
+
+VkImageView render_graph_get_image_view(const struct render_graph *render_graph, const uint32_t resource);
+
+VkBuffer render_graph_get_buffer(const struct render_graph *render_graph, const uint32_t resource);
+
+#endif
@@ -3,8 +3,97 @@
 
 #include <vulkan/vulkan.h>
 
-VkRenderPass render_pass_create(const VkDevice device, const VkSurfaceFormatKHR surface_format);
+#define RENDER_PASS_MAX_COLOR_ATTACHMENTS 4U
+
+struct render_pass_attachment {
+    VkFormat format;
+    VkSampleCountFlagBits samples;
+    VkAttachmentLoadOp load_op;
+    VkAttachmentStoreOp store_op;
+    VkImageLayout initial_layout;
+    VkImageLayout final_layout;
+};
+
+// The attachment signature of a render pass with one subpass, or two with a
+// lighting subpass. Descriptions are hashed and compared as bytes, so they
+// start out from render_pass_description_init or
+// render_pass_description_init_deferred.
+struct render_pass_description {
+    uint32_t color_attachment_count;
+    struct render_pass_attachment color_attachments[RENDER_PASS_MAX_COLOR_ATTACHMENTS];
+    // Follows the color attachments in the framebuffer.
+    VkBool32 has_depth_attachment;
+    struct render_pass_attachment depth_attachment;
+    // One per color attachment, resolved at the end of the subpass. They
+    // follow the depth attachment in the framebuffer.
+    VkBool32 has_resolve_attachments;
+    struct render_pass_attachment resolve_attachments[RENDER_PASS_MAX_COLOR_ATTACHMENTS];
+    // A second subpass that reads the color and depth attachments as input
+    // attachments, in that order, and writes the lighting attachment. It comes
+    // last in the framebuffer and excludes resolve attachments.
+    VkBool32 has_lighting_subpass;
+    struct render_pass_attachment lighting_attachment;
+};
+
+// One color attachment of color_format that is cleared and stored, and unless
+// depth_format is VK_FORMAT_UNDEFINED a depth attachment that is cleared and
+// never stored, so it can live in lazily allocated memory. The render graph
+// transitions them, they stay in their attachment optimal layouts.
+//
+// With more than one sample the color attachment is multisampled and never
+// stored either, a single sample resolve attachment of color_format takes
+// the stored result instead.
+void render_pass_description_init(
+    struct render_pass_description *description,
+    const VkFormat color_format,
+    const VkFormat depth_format,
+    const VkSampleCountFlagBits sample_count
+);
+
+// A G-buffer of one color attachment of gbuffer_format and a depth attachment,
+// both cleared and never stored, and a lighting subpass that shades them into
+// an attachment of color_format. The G-buffer is handed from one subpass to
+// the next with a by-region dependency, so a tiler can keep it in tile memory
+// and its lazily allocated memory may never be backed at all.
+void render_pass_description_init_deferred(
+    struct render_pass_description *description,
+    const VkFormat gbuffer_format,
+    const VkFormat depth_format,
+    const VkFormat color_format
+);
+
+VkRenderPass render_pass_create_from_description(const VkDevice device, const struct render_pass_description *const description);
+
+VkRenderPass render_pass_create(const VkDevice device, const VkSurfaceFormatKHR surface_format, const VkFormat depth_format, const VkSampleCountFlagBits sample_count);
 
 void render_pass_destroy(const VkRenderPass render_pass, const VkDevice device);
 
+struct render_pass_cache_entry {
+    struct render_pass_description description;
+    uint64_t hash;
+    VkRenderPass render_pass;
+};
+
+struct render_pass_cache_statistics {
+    uint32_t request_count;
+    uint32_t hit_count;
+    uint32_t render_pass_count;
+};
+
+// Render passes by attachment signature. A format that reappears after a
+// resize or for another target gets the same handle back, so pipelines built
+// against it stay usable. Render passes live as long as the cache.
+struct render_pass_cache {
+    VkDevice device;
+    struct render_pass_cache_entry *entries;
+    uint32_t entry_capacity;
+    struct render_pass_cache_statistics statistics;
+};
+
+struct render_pass_cache *render_pass_cache_create(const VkDevice device);
+
+void render_pass_cache_destroy(struct render_pass_cache *render_pass_cache);
+
+VkRenderPass render_pass_cache_get(struct render_pass_cache *render_pass_cache, const struct render_pass_description *const description);
+
 #endif
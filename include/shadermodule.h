@@ -3,6 +3,69 @@
 
 #include <vulkan/vulkan.h>
 
-VkShaderModule shader_module_create(const VkDevice device, const char *const path);
+#include <shaderreflection.h>
+
+#include <pthread.h>
+
+// A shader module together with its reflection, which is computed once when
+// the module is created. Modules are shared through a shader_module_cache and
+// addressed by the contents of their SPIR-V, so identical binaries loaded
+// under different names end up as a single VkShaderModule.
+struct shader_module {
+    VkShaderModule handle;
+    struct shader_reflection reflection;
+    uint64_t content_hash[2];
+    size_t code_size;
+    uint32_t reference_count;
+};
+
+struct shader_module_cache_statistics {
+    uint32_t request_count;
+    uint32_t hit_count;
+    uint32_t module_count;
+};
+
+struct shader_module_cache {
+    VkDevice device;
+    pthread_mutex_t mutex;
+    struct shader_module **modules;
+    uint32_t module_capacity;
+    struct shader_module_cache_statistics statistics;
+};
+
+// Shaders are looked up by name in the embedded shader registry, see
+// shaderregistry.h, unless LEARN_VULKAN_SHADER_DIRECTORY is set, in which
+// case <name>.spv is mapped from that directory.
+VkShaderModule shader_module_create(const VkDevice device, const char *const name);
+
+struct shader_module_cache *shader_module_cache_create(const VkDevice device);
+
+// Every acquired module has to be released before the cache is destroyed.
+void shader_module_cache_destroy(struct shader_module_cache *shader_module_cache);
+
+struct shader_module *shader_module_cache_acquire(struct shader_module_cache *shader_module_cache, const char *const name);
+
+struct shader_module *shader_module_cache_acquire_code(
+    struct shader_module_cache *shader_module_cache,
+    const uint32_t *const code,
+    const size_t code_size
+);
+
+// Returns NULL and writes the reason to message when the code cannot be
+// reflected, instead of exiting.
+struct shader_module *shader_module_cache_try_acquire_code(
+    struct shader_module_cache *shader_module_cache,
+    const uint32_t *const code,
+    const size_t code_size,
+    char *const message,
+    const size_t message_size
+);
+
+// Destroys the module once the last reference is gone. Pipelines do not need
+// their shader modules after creation, so a module only has to be held while
+// pipelines using it may still be created.
+void shader_module_cache_release(struct shader_module_cache *shader_module_cache, struct shader_module *shader_module);
+
+struct shader_module_cache_statistics shader_module_cache_get_statistics(struct shader_module_cache *shader_module_cache);
 
 #endif
@@ -0,0 +1,111 @@
+#ifndef SHADERREFLECTION_H
+#define SHADERREFLECTION_H
+
+#include <vulkan/vulkan.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Minimal SPIR-V reflection: stage inputs, descriptor bindings, scalar
+// specialization constants and the push constant block of the first entry
+// point. Enough to derive vertex input state and pipeline layouts without
+// mirroring the GLSL by hand.
+
+#define SHADER_REFLECTION_MAX_INPUTS 16U
+#define SHADER_REFLECTION_MAX_BINDINGS 32U
+#define SHADER_REFLECTION_MAX_SETS 4U
+#define SHADER_REFLECTION_MAX_SPECIALIZATION_CONSTANTS 8U
+
+struct shader_reflection_input {
+    uint32_t location;
+    VkFormat format;
+    uint32_t size;
+};
+
+struct shader_reflection_binding {
+    uint32_t set;
+    uint32_t binding;
+    VkDescriptorType descriptor_type;
+    uint32_t descriptor_count;
+    VkShaderStageFlags stage_flags;
+};
+
+// Booleans default to 0 or 1, floats hold their bit pattern.
+struct shader_reflection_specialization_constant {
+    uint32_t constant_id;
+    uint32_t default_value;
+    char name[32];
+};
+
+struct shader_reflection {
+    VkShaderStageFlagBits stage;
+    uint32_t input_count;
+    struct shader_reflection_input inputs[SHADER_REFLECTION_MAX_INPUTS];
+    uint32_t binding_count;
+    struct shader_reflection_binding bindings[SHADER_REFLECTION_MAX_BINDINGS];
+    uint32_t specialization_constant_count;
+    struct shader_reflection_specialization_constant specialization_constants[SHADER_REFLECTION_MAX_SPECIALIZATION_CONSTANTS];
+    uint32_t push_constant_size;
+};
+
+// Bindings and push constants of all stages of a pipeline, merged.
+struct shader_reflection_layout {
+    uint32_t binding_count;
+    struct shader_reflection_binding bindings[SHADER_REFLECTION_MAX_BINDINGS];
+    uint32_t set_count;
+    VkPushConstantRange push_constant_range;
+    uint32_t push_constant_range_count;
+};
+
+// Exits on malformed or unsupported SPIR-V.
+void shader_reflection_parse(const uint32_t *const code, const size_t code_size, struct shader_reflection *reflection);
+
+// For shaders that may be rejected, such as reloaded ones: instead of exiting
+// the reason is written to message and false is returned.
+bool shader_reflection_try_parse(
+    const uint32_t *const code,
+    const size_t code_size,
+    struct shader_reflection *reflection,
+    char *const message,
+    const size_t message_size
+);
+
+// Exits when the stages disagree on a binding.
+void shader_reflection_merge_layout(
+    const struct shader_reflection *const *const reflections,
+    const uint32_t reflection_count,
+    struct shader_reflection_layout *layout
+);
+
+bool shader_reflection_try_merge_layout(
+    const struct shader_reflection *const *const reflections,
+    const uint32_t reflection_count,
+    struct shader_reflection_layout *layout,
+    char *const message,
+    const size_t message_size
+);
+
+// Whether a pipeline layout made for one layout also fits the other: the
+// same bindings, stages and push constant range, in any order.
+bool shader_reflection_layouts_equal(
+    const struct shader_reflection_layout *const layout_a,
+    const struct shader_reflection_layout *const layout_b
+);
+
+const struct shader_reflection_binding *shader_reflection_layout_find_binding(
+    const struct shader_reflection_layout *const layout,
+    const uint32_t set,
+    const uint32_t binding
+);
+
+// Uniform buffers become dynamic uniform buffers when dynamic_uniform_buffers
+// is set, matching how the uniform ring addresses them.
+VkDescriptorSetLayout shader_reflection_layout_create_descriptor_set_layout(
+    const VkDevice device,
+    const struct shader_reflection_layout *const layout,
+    const uint32_t set,
+    const VkBool32 dynamic_uniform_buffers
+);
+
+#endif
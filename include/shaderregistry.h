@@ -0,0 +1,18 @@
+#ifndef SHADERREGISTRY_H
+#define SHADERREGISTRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// SPIR-V compiled at build time and linked into the executable, looked up by
+// the name of the GLSL source without extension, e.g. "vert" for vert.glsl.
+
+struct shader_registry_entry {
+    const char *name;
+    const uint32_t *code;
+    size_t code_size;
+};
+
+const struct shader_registry_entry *shader_registry_find(const char *const name);
+
+#endif
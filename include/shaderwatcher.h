@@ -0,0 +1,41 @@
+#ifndef SHADERWATCHER_H
+#define SHADERWATCHER_H
+
+#include <shadermodule.h>
+
+#include <pthread.h>
+#include <stdbool.h>
+
+// Watches a directory of GLSL sources with inotify. A background thread runs
+// glslc on every <name>.glsl that is written and turns the SPIR-V into a
+// shader module through the shader module cache. The results are queued until
+// the frame loop polls them, so neither compiling nor waiting for changes ever
+// happens on the frame loop.
+
+struct shader_watcher_update {
+    char name[32];
+    struct shader_module *shader_module;
+    struct shader_watcher_update *next;
+};
+
+struct shader_watcher {
+    struct shader_module_cache *shader_module_cache;
+    char *source_directory;
+    int inotify_descriptor;
+    int stop_pipe[2];
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    struct shader_watcher_update *update_head;
+    struct shader_watcher_update *update_tail;
+};
+
+struct shader_watcher *shader_watcher_create(struct shader_module_cache *shader_module_cache, const char *const source_directory);
+
+// Modules of updates that were never polled are released.
+void shader_watcher_destroy(struct shader_watcher *shader_watcher);
+
+// Takes the oldest update without blocking. The caller owns the reference to
+// the shader module and releases it through the shader module cache.
+bool shader_watcher_poll(struct shader_watcher *shader_watcher, struct shader_watcher_update *update);
+
+#endif
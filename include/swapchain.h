@@ -20,6 +20,9 @@ void swapchain_destroy(const VkSwapchainKHR swapchain, const VkDevice device);
 
 uint32_t swapchain_get_image_count(const VkSwapchainKHR swapchain, const VkDevice device);
 
+// The images belong to the swapchain, only the returned array is freed.
+VkImage *swapchain_get_images(const VkSwapchainKHR swapchain, const VkDevice device, uint32_t swapchain_image_count);
+
 VkImageView *swapchain_create_image_views(const VkSwapchainKHR swapchain, const VkDevice device, const VkSurfaceFormatKHR surface_format, uint32_t swapchain_image_count);
 
 void swapchain_image_views_destroy(VkImageView *image_views, const VkDevice device, const uint32_t image_view_count);
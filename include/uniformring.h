@@ -0,0 +1,46 @@
+#ifndef UNIFORMRING_H
+#define UNIFORMRING_H
+
+#include <vulkan/vulkan.h>
+
+struct uniform_ring {
+    VkBuffer buffer;
+    VkDeviceMemory buffer_device_memory;
+    uint8_t *mapped_data;
+    VkDescriptorSetLayout descriptor_set_layout;
+    VkDescriptorPool descriptor_pool;
+    VkDescriptorSet descriptor_set;
+    VkDeviceSize alignment;
+    VkDeviceSize block_size;
+    VkDeviceSize frame_size;
+    VkDeviceSize frame_offset;
+    VkDeviceSize head;
+    uint32_t frame_count;
+};
+
+// Binding 0 of descriptor_set_layout must be a single dynamic uniform buffer.
+// The layout stays owned by the caller.
+struct uniform_ring *uniform_ring_create(
+    const VkDevice device,
+    const VkDescriptorSetLayout descriptor_set_layout,
+    const VkPhysicalDeviceProperties physical_device_properties,
+    const VkPhysicalDeviceMemoryProperties physical_device_memory_properties,
+    const uint32_t frame_count,
+    const uint32_t frame_size,
+    const uint32_t block_size
+);
+
+void uniform_ring_destroy(const VkDevice device, struct uniform_ring *uniform_ring);
+
+void uniform_ring_resize(
+    const VkDevice device,
+    const VkPhysicalDeviceMemoryProperties physical_device_memory_properties,
+    struct uniform_ring *uniform_ring,
+    const uint32_t frame_count
+);
+
+void uniform_ring_begin_frame(struct uniform_ring *uniform_ring, const uint32_t frame_index);
+
+uint32_t uniform_ring_push(struct uniform_ring *uniform_ring, const void *const data, const uint32_t size);
+
+#endif
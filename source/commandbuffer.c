@@ -2,12 +2,13 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 VkCommandPool command_pool_create(const VkDevice device, const uint32_t queue_family_index) {
     const VkCommandPoolCreateInfo command_pool_create_info = {
         .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
         .pNext = NULL,
-        .flags = 0,
+        .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
         .queueFamilyIndex = queue_family_index
     };
 
@@ -26,117 +27,508 @@ void command_pool_destroy(const VkDevice device, const VkCommandPool command_poo
     vkDestroyCommandPool(device, command_pool, NULL);
 }
 
-VkCommandBuffer *command_buffer_create_draw(
-    const VkDevice device,
-    const VkSurfaceCapabilitiesKHR surface_capabilities,
-    const VkCommandPool command_pool,
-    const VkRenderPass render_pass,
-    const VkFramebuffer *const framebuffers,
-    const VkPipeline graphics_pipeline,
-    const VkBuffer vertex_buffer,
-    const uint32_t swapchain_image_count,
-    const uint32_t vertex_count
-) {
-    const VkCommandBufferAllocateInfo draw_command_buffer_allocate_info = {
+VkCommandBuffer *command_buffers_allocate(const VkDevice device, const VkCommandPool command_pool, const uint32_t command_buffer_count) {
+    const VkCommandBufferAllocateInfo command_buffer_allocate_info = {
         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
         .pNext = NULL,
         .commandPool = command_pool,
         .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-        .commandBufferCount = swapchain_image_count
+        .commandBufferCount = command_buffer_count
     };
 
-    VkCommandBuffer *draw_command_buffers = malloc(swapchain_image_count * (sizeof *draw_command_buffers));
-    VkResult result = vkAllocateCommandBuffers(device, &draw_command_buffer_allocate_info, draw_command_buffers);
+    VkCommandBuffer *command_buffers = malloc(command_buffer_count * (sizeof *command_buffers));
+    VkResult result = vkAllocateCommandBuffers(device, &command_buffer_allocate_info, command_buffers);
 
     if (result != VK_SUCCESS) {
         fprintf(stderr, "error: failed to allocate command buffers\n");
         exit(1);
     }
 
-    const VkCommandBufferBeginInfo draw_command_buffer_begin_info = {
+    return command_buffers;
+}
+
+static PFN_vkVoidFunction command_buffer_load_command(const VkDevice device, const char *const name) {
+    const PFN_vkVoidFunction command = vkGetDeviceProcAddr(device, name);
+
+    if (command == NULL) {
+        fprintf(stderr, "error: failed to load %s\n", name);
+        exit(1);
+    }
+
+    return command;
+}
+
+struct command_buffer_dynamic_state_commands command_buffer_load_dynamic_state_commands(const VkDevice device, const uint32_t dynamic_state_flags) {
+    struct command_buffer_dynamic_state_commands commands = {
+        .dynamic_state_flags = dynamic_state_flags
+    };
+
+    if (dynamic_state_flags & GRAPHICS_PIPELINE_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_BIT) {
+        commands.set_primitive_topology = (PFN_vkCmdSetPrimitiveTopologyEXT) command_buffer_load_command(device, "vkCmdSetPrimitiveTopologyEXT");
+    }
+
+    if (dynamic_state_flags & GRAPHICS_PIPELINE_DYNAMIC_STATE_CULL_MODE_BIT) {
+        commands.set_cull_mode = (PFN_vkCmdSetCullModeEXT) command_buffer_load_command(device, "vkCmdSetCullModeEXT");
+    }
+
+    if (dynamic_state_flags & GRAPHICS_PIPELINE_DYNAMIC_STATE_FRONT_FACE_BIT) {
+        commands.set_front_face = (PFN_vkCmdSetFrontFaceEXT) command_buffer_load_command(device, "vkCmdSetFrontFaceEXT");
+    }
+
+    if (dynamic_state_flags & GRAPHICS_PIPELINE_DYNAMIC_STATE_DEPTH_TEST_ENABLE_BIT) {
+        commands.set_depth_test_enable = (PFN_vkCmdSetDepthTestEnableEXT) command_buffer_load_command(device, "vkCmdSetDepthTestEnableEXT");
+    }
+
+    if (dynamic_state_flags & GRAPHICS_PIPELINE_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_BIT) {
+        commands.set_depth_write_enable = (PFN_vkCmdSetDepthWriteEnableEXT) command_buffer_load_command(device, "vkCmdSetDepthWriteEnableEXT");
+    }
+
+    if (dynamic_state_flags & GRAPHICS_PIPELINE_DYNAMIC_STATE_DEPTH_COMPARE_OP_BIT) {
+        commands.set_depth_compare_op = (PFN_vkCmdSetDepthCompareOpEXT) command_buffer_load_command(device, "vkCmdSetDepthCompareOpEXT");
+    }
+
+    if (dynamic_state_flags & GRAPHICS_PIPELINE_DYNAMIC_STATE_POLYGON_MODE_BIT) {
+        commands.set_polygon_mode = (PFN_vkCmdSetPolygonModeEXT) command_buffer_load_command(device, "vkCmdSetPolygonModeEXT");
+    }
+
+    if (dynamic_state_flags & GRAPHICS_PIPELINE_DYNAMIC_STATE_COLOR_BLEND_ENABLE_BIT) {
+        commands.set_color_blend_enable = (PFN_vkCmdSetColorBlendEnableEXT) command_buffer_load_command(device, "vkCmdSetColorBlendEnableEXT");
+    }
+
+    if (dynamic_state_flags & GRAPHICS_PIPELINE_DYNAMIC_STATE_COLOR_BLEND_EQUATION_BIT) {
+        commands.set_color_blend_equation = (PFN_vkCmdSetColorBlendEquationEXT) command_buffer_load_command(device, "vkCmdSetColorBlendEquationEXT");
+    }
+
+    return commands;
+}
+
+struct command_buffer_dynamic_rendering_commands command_buffer_load_dynamic_rendering_commands(const VkDevice device) {
+    const struct command_buffer_dynamic_rendering_commands commands = {
+        .begin_rendering = (PFN_vkCmdBeginRenderingKHR) command_buffer_load_command(device, "vkCmdBeginRenderingKHR"),
+        .end_rendering = (PFN_vkCmdEndRenderingKHR) command_buffer_load_command(device, "vkCmdEndRenderingKHR")
+    };
+
+    return commands;
+}
+
+static uint32_t command_buffer_set_dynamic_state(
+    const VkCommandBuffer command_buffer,
+    const struct command_buffer_dynamic_state_commands *const commands,
+    const struct graphics_pipeline_dynamic_state *const dynamic_state,
+    const struct graphics_pipeline_dynamic_state *const bound_dynamic_state
+) {
+    const uint32_t flags = commands->dynamic_state_flags;
+    uint32_t update_count = 0U;
+
+    if ((flags & GRAPHICS_PIPELINE_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_BIT) && (bound_dynamic_state == NULL || dynamic_state->topology != bound_dynamic_state->topology)) {
+        commands->set_primitive_topology(command_buffer, dynamic_state->topology);
+        update_count++;
+    }
+
+    if ((flags & GRAPHICS_PIPELINE_DYNAMIC_STATE_CULL_MODE_BIT) && (bound_dynamic_state == NULL || dynamic_state->cull_mode != bound_dynamic_state->cull_mode)) {
+        commands->set_cull_mode(command_buffer, dynamic_state->cull_mode);
+        update_count++;
+    }
+
+    if ((flags & GRAPHICS_PIPELINE_DYNAMIC_STATE_FRONT_FACE_BIT) && (bound_dynamic_state == NULL || dynamic_state->front_face != bound_dynamic_state->front_face)) {
+        commands->set_front_face(command_buffer, dynamic_state->front_face);
+        update_count++;
+    }
+
+    if ((flags & GRAPHICS_PIPELINE_DYNAMIC_STATE_DEPTH_TEST_ENABLE_BIT) && (bound_dynamic_state == NULL || dynamic_state->depth_test_enable != bound_dynamic_state->depth_test_enable)) {
+        commands->set_depth_test_enable(command_buffer, dynamic_state->depth_test_enable);
+        update_count++;
+    }
+
+    if ((flags & GRAPHICS_PIPELINE_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_BIT) && (bound_dynamic_state == NULL || dynamic_state->depth_write_enable != bound_dynamic_state->depth_write_enable)) {
+        commands->set_depth_write_enable(command_buffer, dynamic_state->depth_write_enable);
+        update_count++;
+    }
+
+    if ((flags & GRAPHICS_PIPELINE_DYNAMIC_STATE_DEPTH_COMPARE_OP_BIT) && (bound_dynamic_state == NULL || dynamic_state->depth_compare_op != bound_dynamic_state->depth_compare_op)) {
+        commands->set_depth_compare_op(command_buffer, dynamic_state->depth_compare_op);
+        update_count++;
+    }
+
+    if ((flags & GRAPHICS_PIPELINE_DYNAMIC_STATE_POLYGON_MODE_BIT) && (bound_dynamic_state == NULL || dynamic_state->polygon_mode != bound_dynamic_state->polygon_mode)) {
+        commands->set_polygon_mode(command_buffer, dynamic_state->polygon_mode);
+        update_count++;
+    }
+
+    if ((flags & GRAPHICS_PIPELINE_DYNAMIC_STATE_COLOR_BLEND_ENABLE_BIT) && (bound_dynamic_state == NULL || dynamic_state->blend_enable != bound_dynamic_state->blend_enable)) {
+        commands->set_color_blend_enable(command_buffer, 0, 1, &dynamic_state->blend_enable);
+        update_count++;
+    }
+
+    if ((flags & GRAPHICS_PIPELINE_DYNAMIC_STATE_COLOR_BLEND_EQUATION_BIT) && (bound_dynamic_state == NULL || memcmp(&dynamic_state->color_blend_equation, &bound_dynamic_state->color_blend_equation, sizeof dynamic_state->color_blend_equation) != 0)) {
+        commands->set_color_blend_equation(command_buffer, 0, 1, &dynamic_state->color_blend_equation);
+        update_count++;
+    }
+
+    return update_count;
+}
+
+void command_buffer_record_draw_queue(
+    const VkCommandBuffer command_buffer,
+    const struct draw_queue *const draw_queue,
+    const struct command_buffer_dynamic_state_commands *const dynamic_state_commands,
+    const bool depth_prepass,
+    struct draw_queue_statistics *const draw_queue_statistics
+) {
+    VkPipeline bound_pipeline = VK_NULL_HANDLE;
+    VkBuffer bound_vertex_buffer = VK_NULL_HANDLE;
+    VkBuffer bound_index_buffer = VK_NULL_HANDLE;
+    VkIndexType bound_index_type = VK_INDEX_TYPE_UINT16;
+    VkDescriptorSet bound_descriptor_set = VK_NULL_HANDLE;
+    uint32_t bound_dynamic_offset = 0;
+    const struct graphics_pipeline_dynamic_state *bound_dynamic_state = NULL;
+
+    struct draw_queue_statistics statistics = {0};
+    statistics.draws_skipped = draw_queue->skipped_draw_count;
+
+    for (uint32_t entry_index = 0U; entry_index < draw_queue->draw_count; ++entry_index) {
+        const struct draw *const draw = &draw_queue->draws[draw_queue->entries[entry_index].draw_index];
+        const VkPipeline pipeline = depth_prepass ? draw->depth_prepass_pipeline : draw->pipeline;
+
+        if (pipeline == VK_NULL_HANDLE) {
+            continue;
+        }
+
+        if (pipeline != bound_pipeline) {
+            vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+            bound_pipeline = pipeline;
+            statistics.pipeline_binds++;
+        }
+        else {
+            statistics.binds_avoided++;
+        }
+
+        if (draw->descriptor_set != VK_NULL_HANDLE) {
+            if (draw->descriptor_set != bound_descriptor_set || draw->dynamic_offset != bound_dynamic_offset) {
+                vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, draw->pipeline_layout, 0, 1, &draw->descriptor_set, 1, &draw->dynamic_offset);
+                bound_descriptor_set = draw->descriptor_set;
+                bound_dynamic_offset = draw->dynamic_offset;
+                statistics.descriptor_set_binds++;
+            }
+            else {
+                statistics.binds_avoided++;
+            }
+        }
+
+        if (dynamic_state_commands != NULL && dynamic_state_commands->dynamic_state_flags != 0U) {
+            statistics.dynamic_state_updates += command_buffer_set_dynamic_state(command_buffer, dynamic_state_commands, &draw->dynamic_state, bound_dynamic_state);
+            bound_dynamic_state = &draw->dynamic_state;
+        }
+
+        if (draw->push_constant_size > 0) {
+            vkCmdPushConstants(command_buffer, draw->pipeline_layout, draw->push_constant_stage_flags, 0, draw->push_constant_size, draw->push_constant_data);
+            statistics.push_constant_updates++;
+        }
+
+        if (draw->vertex_buffer != bound_vertex_buffer) {
+            const VkDeviceSize vertex_buffer_offsets[] = {0};
+            vkCmdBindVertexBuffers(command_buffer, 0, 1, &draw->vertex_buffer, vertex_buffer_offsets);
+            bound_vertex_buffer = draw->vertex_buffer;
+            statistics.vertex_buffer_binds++;
+        }
+        else {
+            statistics.binds_avoided++;
+        }
+
+        if (draw->index_buffer != VK_NULL_HANDLE) {
+            if (draw->index_buffer != bound_index_buffer || draw->index_type != bound_index_type) {
+                vkCmdBindIndexBuffer(command_buffer, draw->index_buffer, 0, draw->index_type);
+                bound_index_buffer = draw->index_buffer;
+                bound_index_type = draw->index_type;
+                statistics.index_buffer_binds++;
+            }
+            else {
+                statistics.binds_avoided++;
+            }
+
+            vkCmdDrawIndexed(command_buffer, draw->element_count, 1, draw->first_element, draw->vertex_offset, 0);
+        }
+        else {
+            vkCmdDraw(command_buffer, draw->element_count, 1, draw->first_element, 0);
+        }
+
+        statistics.draw_count++;
+    }
+
+    if (draw_queue_statistics != NULL) {
+        *draw_queue_statistics = statistics;
+    }
+}
+
+void command_buffer_replay_stream(
+    const VkCommandBuffer command_buffer,
+    const struct command_buffer_dynamic_state_commands *const dynamic_state_commands,
+    const bool inside_render_pass,
+    const struct command_stream *const command_stream
+) {
+    struct command_stream_iterator iterator = {0};
+    const struct command_stream_packet *packet = NULL;
+
+    while ((packet = command_stream_next(command_stream, &iterator)) != NULL) {
+        switch (packet->op) {
+            case COMMAND_STREAM_OP_BIND_PIPELINE: {
+                const struct command_stream_bind_pipeline *const bind_pipeline = (const void *) packet;
+                vkCmdBindPipeline(command_buffer, bind_pipeline->pipeline_bind_point, bind_pipeline->pipeline);
+                break;
+            }
+            case COMMAND_STREAM_OP_BIND_DESCRIPTOR_SET: {
+                const struct command_stream_bind_descriptor_set *const bind_descriptor_set = (const void *) packet;
+                vkCmdBindDescriptorSets(command_buffer, bind_descriptor_set->pipeline_bind_point, bind_descriptor_set->pipeline_layout,
+                    bind_descriptor_set->set, 1, &bind_descriptor_set->descriptor_set,
+                    bind_descriptor_set->dynamic_offset_count, &bind_descriptor_set->dynamic_offset);
+                break;
+            }
+            case COMMAND_STREAM_OP_PUSH_CONSTANTS: {
+                const struct command_stream_push_constants *const push_constants = (const void *) packet;
+                vkCmdPushConstants(command_buffer, push_constants->pipeline_layout, push_constants->stage_flags, push_constants->offset, push_constants->size, push_constants->data);
+                break;
+            }
+            case COMMAND_STREAM_OP_BIND_VERTEX_BUFFER: {
+                const struct command_stream_bind_vertex_buffer *const bind_vertex_buffer = (const void *) packet;
+                vkCmdBindVertexBuffers(command_buffer, bind_vertex_buffer->binding, 1, &bind_vertex_buffer->buffer, &bind_vertex_buffer->offset);
+                break;
+            }
+            case COMMAND_STREAM_OP_BIND_INDEX_BUFFER: {
+                const struct command_stream_bind_index_buffer *const bind_index_buffer = (const void *) packet;
+                vkCmdBindIndexBuffer(command_buffer, bind_index_buffer->buffer, bind_index_buffer->offset, bind_index_buffer->index_type);
+                break;
+            }
+            case COMMAND_STREAM_OP_SET_VIEWPORT: {
+                const struct command_stream_set_viewport *const set_viewport = (const void *) packet;
+                vkCmdSetViewport(command_buffer, 0, 1, &set_viewport->viewport);
+                break;
+            }
+            case COMMAND_STREAM_OP_SET_SCISSOR: {
+                const struct command_stream_set_scissor *const set_scissor = (const void *) packet;
+                vkCmdSetScissor(command_buffer, 0, 1, &set_scissor->scissor);
+                break;
+            }
+            case COMMAND_STREAM_OP_SET_DYNAMIC_STATE: {
+                const struct command_stream_set_dynamic_state *const set_dynamic_state = (const void *) packet;
+
+                if (dynamic_state_commands != NULL && dynamic_state_commands->dynamic_state_flags != 0U) {
+                    command_buffer_set_dynamic_state(command_buffer, dynamic_state_commands, &set_dynamic_state->dynamic_state, NULL);
+                }
+
+                break;
+            }
+            case COMMAND_STREAM_OP_DRAW: {
+                const struct command_stream_draw *const draw = (const void *) packet;
+                vkCmdDraw(command_buffer, draw->vertex_count, draw->instance_count, draw->first_vertex, draw->first_instance);
+                break;
+            }
+            case COMMAND_STREAM_OP_DRAW_INDEXED: {
+                const struct command_stream_draw_indexed *const draw_indexed = (const void *) packet;
+                vkCmdDrawIndexed(command_buffer, draw_indexed->index_count, draw_indexed->instance_count, draw_indexed->first_index, draw_indexed->vertex_offset, draw_indexed->first_instance);
+                break;
+            }
+            case COMMAND_STREAM_OP_COPY_BUFFER: {
+                if (inside_render_pass) {
+                    fprintf(stderr, "error: command stream copies a buffer inside a render pass\n");
+                    exit(1);
+                }
+
+                const struct command_stream_copy_buffer *const copy_buffer = (const void *) packet;
+                vkCmdCopyBuffer(command_buffer, copy_buffer->source_buffer, copy_buffer->destination_buffer, 1, &copy_buffer->buffer_copy);
+                break;
+            }
+            default:
+                fprintf(stderr, "error: unknown command stream op %u\n", packet->op);
+                exit(1);
+        }
+    }
+}
+
+void command_buffer_begin(const VkCommandBuffer command_buffer) {
+    VkResult result = vkResetCommandBuffer(command_buffer, 0);
+
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "error: failed to reset command buffer\n");
+        exit(1);
+    }
+
+    const VkCommandBufferBeginInfo command_buffer_begin_info = {
         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
         .pNext = NULL,
-        .flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
         .pInheritanceInfo = NULL
     };
 
-    const VkClearColorValue clear_color_value = {
-        .float32 = {0.0f, 0.0f, 0.0f, 1.0f},
-        .int32 = {0, 0, 0, 255},
-        .uint32 = {0U, 0U, 0U, 255U}
-    };
+    result = vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info);
+
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "error: failed to begin command buffer recording\n");
+        exit(1);
+    }
+}
+
+// VkClearValue is a union, color and depth need one each.
+static const VkClearValue command_buffer_clear_values[] = {
+    {.color.float32 = {0.0f, 0.0f, 0.0f, 1.0f}},
+    {.depthStencil = {.depth = 1.0f, .stencil = 0U}}
+};
 
-    const VkClearDepthStencilValue clear_depth_stencil_value = {
-        .depth = 0.0f,
-        .stencil = 0U
+static void command_buffer_record_draws(
+    const VkCommandBuffer command_buffer,
+    const VkExtent2D render_extent,
+    const struct draw_queue *const draw_queue,
+    const struct command_buffer_dynamic_state_commands *const dynamic_state_commands,
+    const bool depth_prepass,
+    const struct command_stream *const *const command_streams,
+    const uint32_t command_stream_count,
+    struct draw_queue_statistics *const draw_queue_statistics
+) {
+    const VkViewport graphics_pipeline_viewport = {
+        .x = 0,
+        .y = 0,
+        .width = render_extent.width,
+        .height = render_extent.height,
+        .minDepth = 0.0f,
+        .maxDepth = 1.0f
     };
 
-    const VkClearValue clear_value = {
-        .color = clear_color_value,
-        .depthStencil = clear_depth_stencil_value
+    vkCmdSetViewport(command_buffer, 0, 1, &graphics_pipeline_viewport);
+
+    const VkRect2D graphics_pipeline_scissor = {
+        .offset.x = 0,
+        .offset.y = 0,
+        .extent.width = render_extent.width,
+        .extent.height = render_extent.height
     };
 
-    for (uint32_t draw_command_buffer_index = 0U; draw_command_buffer_index < swapchain_image_count; ++draw_command_buffer_index) {
-        result = vkBeginCommandBuffer(draw_command_buffers[draw_command_buffer_index], &draw_command_buffer_begin_info);
+    vkCmdSetScissor(command_buffer, 0, 1, &graphics_pipeline_scissor);
 
-        if (result != VK_SUCCESS) {
-            fprintf(stderr, "error: failed to begin command buffer recording\n");
-            exit(1);
-        }
+    // The pre-pass fills the depth buffer without shading, so the main pass
+    // only shades the fragments that end up visible.
+    if (depth_prepass) {
+        command_buffer_record_draw_queue(command_buffer, draw_queue, dynamic_state_commands, true, NULL);
+    }
 
+    command_buffer_record_draw_queue(command_buffer, draw_queue, dynamic_state_commands, false, draw_queue_statistics);
 
-        const VkRenderPassBeginInfo render_pass_begin_info = {
-            .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-            .pNext = NULL,
-            .renderPass = render_pass,
-            .framebuffer = framebuffers[draw_command_buffer_index],
-            .renderArea.offset.x = 0,
-            .renderArea.offset.y = 0,
-            .renderArea.extent.width = surface_capabilities.currentExtent.width,
-            .renderArea.extent.height = surface_capabilities.currentExtent.height,
-            .clearValueCount = 1,
-            .pClearValues = &clear_value
-        };
+    for (uint32_t command_stream_index = 0U; command_stream_index < command_stream_count; ++command_stream_index) {
+        command_buffer_replay_stream(command_buffer, dynamic_state_commands, true, command_streams[command_stream_index]);
+    }
+}
 
-        vkCmdBeginRenderPass(draw_command_buffers[draw_command_buffer_index], &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
-        vkCmdBindPipeline(draw_command_buffers[draw_command_buffer_index], VK_PIPELINE_BIND_POINT_GRAPHICS, graphics_pipeline);
+void command_buffer_record_render_pass(
+    const VkCommandBuffer command_buffer,
+    const VkExtent2D render_extent,
+    const VkRenderPass render_pass,
+    const VkFramebuffer framebuffer,
+    const struct deferred_lighting *const deferred_lighting,
+    const struct draw_queue *const draw_queue,
+    const struct command_buffer_dynamic_state_commands *const dynamic_state_commands,
+    const bool depth_prepass,
+    const struct command_stream *const *const command_streams,
+    const uint32_t command_stream_count,
+    struct draw_queue_statistics *const draw_queue_statistics
+) {
+    const VkRenderPassBeginInfo render_pass_begin_info = {
+        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+        .pNext = NULL,
+        .renderPass = render_pass,
+        .framebuffer = framebuffer,
+        .renderArea.offset.x = 0,
+        .renderArea.offset.y = 0,
+        .renderArea.extent.width = render_extent.width,
+        .renderArea.extent.height = render_extent.height,
+        .clearValueCount = 2,
+        .pClearValues = command_buffer_clear_values
+    };
 
-        const VkDeviceSize vertex_buffer_offsets[] = {0};
-        vkCmdBindVertexBuffers(draw_command_buffers[draw_command_buffer_index], 0, 1, &vertex_buffer, vertex_buffer_offsets);
+    vkCmdBeginRenderPass(command_buffer, &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
 
-        const VkViewport graphics_pipeline_viewport = {
-            .x = 0,
-            .y = 0,
-            .width = surface_capabilities.currentExtent.width,
-            .height = surface_capabilities.currentExtent.height,
-            .minDepth = 0.0f,
-            .maxDepth = 1.0f
-        };
+    command_buffer_record_draws(command_buffer, render_extent, draw_queue, dynamic_state_commands, depth_prepass, command_streams, command_stream_count, draw_queue_statistics);
 
-        vkCmdSetViewport(draw_command_buffers[draw_command_buffer_index], 0, 1, &graphics_pipeline_viewport);
+    if (deferred_lighting != NULL) {
+        vkCmdNextSubpass(command_buffer, VK_SUBPASS_CONTENTS_INLINE);
 
-        const VkRect2D graphics_pipeline_scissor = {
-            .offset.x = 0,
-            .offset.y = 0,
-            .extent.width = surface_capabilities.currentExtent.width,
-            .extent.height = surface_capabilities.currentExtent.height
-        };
+        if (dynamic_state_commands != NULL && dynamic_state_commands->dynamic_state_flags != 0U) {
+            command_buffer_set_dynamic_state(command_buffer, dynamic_state_commands, &deferred_lighting->dynamic_state, NULL);
+        }
 
-        vkCmdSetScissor(draw_command_buffers[draw_command_buffer_index], 0, 1, &graphics_pipeline_scissor);
+        deferred_lighting_record(deferred_lighting, command_buffer);
+    }
 
-        vkCmdDraw(draw_command_buffers[draw_command_buffer_index], vertex_count, 1, 0, 0);
+    vkCmdEndRenderPass(command_buffer);
+}
 
-        vkCmdEndRenderPass(draw_command_buffers[draw_command_buffer_index]);
+void command_buffer_record_rendering(
+    const VkCommandBuffer command_buffer,
+    const VkExtent2D render_extent,
+    const VkImageView image_view,
+    const VkImageView resolve_image_view,
+    const VkImageView depth_image_view,
+    const struct command_buffer_dynamic_rendering_commands *const dynamic_rendering_commands,
+    const struct draw_queue *const draw_queue,
+    const struct command_buffer_dynamic_state_commands *const dynamic_state_commands,
+    const bool depth_prepass,
+    const struct command_stream *const *const command_streams,
+    const uint32_t command_stream_count,
+    struct draw_queue_statistics *const draw_queue_statistics
+) {
+    const VkRenderingAttachmentInfoKHR color_attachment_info = {
+        .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR,
+        .pNext = NULL,
+        .imageView = image_view,
+        .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        .resolveMode = resolve_image_view != VK_NULL_HANDLE ? VK_RESOLVE_MODE_AVERAGE_BIT : VK_RESOLVE_MODE_NONE,
+        .resolveImageView = resolve_image_view,
+        .resolveImageLayout = resolve_image_view != VK_NULL_HANDLE ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED,
+        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+        .storeOp = resolve_image_view != VK_NULL_HANDLE ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE,
+        .clearValue = command_buffer_clear_values[0]
+    };
 
-        result = vkEndCommandBuffer(draw_command_buffers[draw_command_buffer_index]);
+    const VkRenderingAttachmentInfoKHR depth_attachment_info = {
+        .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR,
+        .pNext = NULL,
+        .imageView = depth_image_view,
+        .imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        .resolveMode = VK_RESOLVE_MODE_NONE,
+        .resolveImageView = VK_NULL_HANDLE,
+        .resolveImageLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+        .storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        .clearValue = command_buffer_clear_values[1]
+    };
 
-        if (result != VK_SUCCESS) {
-            fprintf(stderr, "error: failed to end command buffer recording\n");
-            exit(1);
-        }
+    const VkRenderingInfoKHR rendering_info = {
+        .sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR,
+        .pNext = NULL,
+        .flags = 0,
+        .renderArea.offset.x = 0,
+        .renderArea.offset.y = 0,
+        .renderArea.extent.width = render_extent.width,
+        .renderArea.extent.height = render_extent.height,
+        .layerCount = 1,
+        .viewMask = 0,
+        .colorAttachmentCount = 1,
+        .pColorAttachments = &color_attachment_info,
+        .pDepthAttachment = depth_image_view != VK_NULL_HANDLE ? &depth_attachment_info : NULL,
+        .pStencilAttachment = NULL
     };
 
-    return draw_command_buffers;
+    dynamic_rendering_commands->begin_rendering(command_buffer, &rendering_info);
+
+    command_buffer_record_draws(command_buffer, render_extent, draw_queue, dynamic_state_commands, depth_prepass, command_streams, command_stream_count, draw_queue_statistics);
+
+    dynamic_rendering_commands->end_rendering(command_buffer);
+}
+
+void command_buffer_end(const VkCommandBuffer command_buffer) {
+    VkResult result = vkEndCommandBuffer(command_buffer);
+
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "error: failed to end command buffer recording\n");
+        exit(1);
+    }
 }
 
 void command_buffers_free(const VkDevice device, const VkCommandPool command_pool, VkCommandBuffer *command_buffers, const uint32_t swapchain_image_count) {
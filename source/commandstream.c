@@ -0,0 +1,294 @@
+#include <commandstream.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#define COMMAND_STREAM_ALIGNMENT 8U
+
+static const char command_stream_file_magic[4] = {'L', 'V', 'C', 'S'};
+static const uint32_t command_stream_file_version = 1U;
+
+struct command_arena *command_arena_create(const size_t capacity, const size_t block_size) {
+    struct command_arena *command_arena = malloc(sizeof *command_arena);
+
+    command_arena->block_size = (block_size + COMMAND_STREAM_ALIGNMENT - 1U) & ~((size_t) COMMAND_STREAM_ALIGNMENT - 1U);
+    command_arena->capacity = capacity - capacity % command_arena->block_size;
+    command_arena->data = aligned_alloc(COMMAND_STREAM_ALIGNMENT, command_arena->capacity);
+
+    if (command_arena->data == NULL) {
+        fprintf(stderr, "error: failed to allocate command arena\n");
+        exit(1);
+    }
+
+    atomic_init(&command_arena->head, 0U);
+    atomic_init(&command_arena->generation, 0U);
+
+    return command_arena;
+}
+
+void command_arena_destroy(struct command_arena *command_arena) {
+    free(command_arena->data);
+    free(command_arena);
+}
+
+// Must only be called while no thread is encoding, typically at a frame boundary.
+void command_arena_reset(struct command_arena *command_arena) {
+    atomic_store(&command_arena->head, 0U);
+    atomic_fetch_add(&command_arena->generation, 1U);
+}
+
+static uint8_t *command_arena_allocate_block(struct command_arena *command_arena) {
+    const size_t offset = atomic_fetch_add_explicit(&command_arena->head, command_arena->block_size, memory_order_relaxed);
+
+    if (offset + command_arena->block_size > command_arena->capacity) {
+        fprintf(stderr, "error: command arena is exhausted\n");
+        exit(1);
+    }
+
+    return command_arena->data + offset;
+}
+
+struct command_stream *command_stream_create(struct command_arena *command_arena) {
+    struct command_stream *command_stream = malloc(sizeof *command_stream);
+
+    command_stream->arena = command_arena;
+    command_stream->block_capacity = 8U;
+    command_stream->blocks = malloc(command_stream->block_capacity * (sizeof *command_stream->blocks));
+    command_stream->block_count = 0U;
+    command_stream->packet_count = 0U;
+    command_stream->arena_generation = atomic_load(&command_arena->generation);
+
+    return command_stream;
+}
+
+void command_stream_destroy(struct command_stream *command_stream) {
+    free(command_stream->blocks);
+    free(command_stream);
+}
+
+void command_stream_reset(struct command_stream *command_stream) {
+    command_stream->block_count = 0U;
+    command_stream->packet_count = 0U;
+    command_stream->arena_generation = atomic_load(&command_stream->arena->generation);
+}
+
+static void *command_stream_allocate_packet(struct command_stream *command_stream, const uint32_t op, const uint32_t size) {
+    const uint32_t aligned_size = (size + COMMAND_STREAM_ALIGNMENT - 1U) & ~(COMMAND_STREAM_ALIGNMENT - 1U);
+
+    if (aligned_size > command_stream->arena->block_size) {
+        fprintf(stderr, "error: command stream packet is larger than an arena block\n");
+        exit(1);
+    }
+
+    // Blocks from before an arena reset are no longer ours.
+    if (command_stream->arena_generation != atomic_load_explicit(&command_stream->arena->generation, memory_order_relaxed)) {
+        command_stream_reset(command_stream);
+    }
+
+    struct command_stream_block *block = command_stream->block_count > 0U ? &command_stream->blocks[command_stream->block_count - 1U] : NULL;
+
+    if (block == NULL || block->used + aligned_size > command_stream->arena->block_size) {
+        if (command_stream->block_count == command_stream->block_capacity) {
+            command_stream->block_capacity *= 2U;
+            command_stream->blocks = realloc(command_stream->blocks, command_stream->block_capacity * (sizeof *command_stream->blocks));
+        }
+
+        block = &command_stream->blocks[command_stream->block_count++];
+        block->data = command_arena_allocate_block(command_stream->arena);
+        block->used = 0U;
+    }
+
+    struct command_stream_packet *packet = (struct command_stream_packet *) (block->data + block->used);
+    packet->op = op;
+    packet->size = aligned_size;
+
+    block->used += aligned_size;
+    command_stream->packet_count++;
+
+    return packet;
+}
+
+void command_stream_bind_pipeline(struct command_stream *command_stream, const VkPipelineBindPoint pipeline_bind_point, const VkPipeline pipeline) {
+    struct command_stream_bind_pipeline *bind_pipeline = command_stream_allocate_packet(command_stream, COMMAND_STREAM_OP_BIND_PIPELINE, sizeof *bind_pipeline);
+    bind_pipeline->pipeline = pipeline;
+    bind_pipeline->pipeline_bind_point = pipeline_bind_point;
+}
+
+void command_stream_bind_descriptor_set(
+    struct command_stream *command_stream,
+    const VkPipelineBindPoint pipeline_bind_point,
+    const VkPipelineLayout pipeline_layout,
+    const uint32_t set,
+    const VkDescriptorSet descriptor_set,
+    const uint32_t dynamic_offset_count,
+    const uint32_t dynamic_offset
+) {
+    if (dynamic_offset_count > 1U) {
+        fprintf(stderr, "error: command streams bind at most one dynamic offset, got %u\n", dynamic_offset_count);
+        exit(1);
+    }
+
+    struct command_stream_bind_descriptor_set *bind_descriptor_set = command_stream_allocate_packet(command_stream, COMMAND_STREAM_OP_BIND_DESCRIPTOR_SET, sizeof *bind_descriptor_set);
+    bind_descriptor_set->pipeline_layout = pipeline_layout;
+    bind_descriptor_set->descriptor_set = descriptor_set;
+    bind_descriptor_set->pipeline_bind_point = pipeline_bind_point;
+    bind_descriptor_set->set = set;
+    bind_descriptor_set->dynamic_offset_count = dynamic_offset_count;
+    bind_descriptor_set->dynamic_offset = dynamic_offset;
+}
+
+void command_stream_push_constants(
+    struct command_stream *command_stream,
+    const VkPipelineLayout pipeline_layout,
+    const VkShaderStageFlags stage_flags,
+    const uint32_t offset,
+    const uint32_t size,
+    const void *const data
+) {
+    struct command_stream_push_constants *push_constants = command_stream_allocate_packet(command_stream, COMMAND_STREAM_OP_PUSH_CONSTANTS, sizeof *push_constants + size);
+    push_constants->pipeline_layout = pipeline_layout;
+    push_constants->stage_flags = stage_flags;
+    push_constants->offset = offset;
+    push_constants->size = size;
+    memcpy(push_constants->data, data, size);
+}
+
+void command_stream_bind_vertex_buffer(struct command_stream *command_stream, const uint32_t binding, const VkBuffer buffer, const VkDeviceSize offset) {
+    struct command_stream_bind_vertex_buffer *bind_vertex_buffer = command_stream_allocate_packet(command_stream, COMMAND_STREAM_OP_BIND_VERTEX_BUFFER, sizeof *bind_vertex_buffer);
+    bind_vertex_buffer->buffer = buffer;
+    bind_vertex_buffer->offset = offset;
+    bind_vertex_buffer->binding = binding;
+}
+
+void command_stream_bind_index_buffer(struct command_stream *command_stream, const VkBuffer buffer, const VkDeviceSize offset, const VkIndexType index_type) {
+    struct command_stream_bind_index_buffer *bind_index_buffer = command_stream_allocate_packet(command_stream, COMMAND_STREAM_OP_BIND_INDEX_BUFFER, sizeof *bind_index_buffer);
+    bind_index_buffer->buffer = buffer;
+    bind_index_buffer->offset = offset;
+    bind_index_buffer->index_type = index_type;
+}
+
+void command_stream_set_viewport(struct command_stream *command_stream, const VkViewport viewport) {
+    struct command_stream_set_viewport *set_viewport = command_stream_allocate_packet(command_stream, COMMAND_STREAM_OP_SET_VIEWPORT, sizeof *set_viewport);
+    set_viewport->viewport = viewport;
+}
+
+void command_stream_set_scissor(struct command_stream *command_stream, const VkRect2D scissor) {
+    struct command_stream_set_scissor *set_scissor = command_stream_allocate_packet(command_stream, COMMAND_STREAM_OP_SET_SCISSOR, sizeof *set_scissor);
+    set_scissor->scissor = scissor;
+}
+
+void command_stream_set_dynamic_state(struct command_stream *command_stream, const struct graphics_pipeline_dynamic_state *const dynamic_state) {
+    struct command_stream_set_dynamic_state *set_dynamic_state = command_stream_allocate_packet(command_stream, COMMAND_STREAM_OP_SET_DYNAMIC_STATE, sizeof *set_dynamic_state);
+    set_dynamic_state->dynamic_state = *dynamic_state;
+}
+
+void command_stream_draw(
+    struct command_stream *command_stream,
+    const uint32_t vertex_count,
+    const uint32_t instance_count,
+    const uint32_t first_vertex,
+    const uint32_t first_instance
+) {
+    struct command_stream_draw *draw = command_stream_allocate_packet(command_stream, COMMAND_STREAM_OP_DRAW, sizeof *draw);
+    draw->vertex_count = vertex_count;
+    draw->instance_count = instance_count;
+    draw->first_vertex = first_vertex;
+    draw->first_instance = first_instance;
+}
+
+void command_stream_draw_indexed(
+    struct command_stream *command_stream,
+    const uint32_t index_count,
+    const uint32_t instance_count,
+    const uint32_t first_index,
+    const int32_t vertex_offset,
+    const uint32_t first_instance
+) {
+    struct command_stream_draw_indexed *draw_indexed = command_stream_allocate_packet(command_stream, COMMAND_STREAM_OP_DRAW_INDEXED, sizeof *draw_indexed);
+    draw_indexed->index_count = index_count;
+    draw_indexed->instance_count = instance_count;
+    draw_indexed->first_index = first_index;
+    draw_indexed->vertex_offset = vertex_offset;
+    draw_indexed->first_instance = first_instance;
+}
+
+void command_stream_copy_buffer(
+    struct command_stream *command_stream,
+    const VkBuffer source_buffer,
+    const VkBuffer destination_buffer,
+    const VkBufferCopy buffer_copy
+) {
+    struct command_stream_copy_buffer *copy_buffer = command_stream_allocate_packet(command_stream, COMMAND_STREAM_OP_COPY_BUFFER, sizeof *copy_buffer);
+    copy_buffer->source_buffer = source_buffer;
+    copy_buffer->destination_buffer = destination_buffer;
+    copy_buffer->buffer_copy = buffer_copy;
+}
+
+const struct command_stream_packet *command_stream_next(const struct command_stream *const command_stream, struct command_stream_iterator *iterator) {
+    // After an arena reset the blocks may already hold packets of other streams.
+    if (command_stream->block_count > 0U && command_stream->arena_generation != atomic_load_explicit(&command_stream->arena->generation, memory_order_relaxed)) {
+        fprintf(stderr, "error: command stream was encoded before the last arena reset\n");
+        exit(1);
+    }
+
+    while (iterator->block_index < command_stream->block_count) {
+        const struct command_stream_block *const block = &command_stream->blocks[iterator->block_index];
+
+        if (iterator->offset < block->used) {
+            const struct command_stream_packet *packet = (const struct command_stream_packet *) (block->data + iterator->offset);
+            iterator->offset += packet->size;
+            return packet;
+        }
+
+        iterator->block_index++;
+        iterator->offset = 0U;
+    }
+
+    return NULL;
+}
+
+// The capture holds raw handle values, so it can only be replayed by the
+// process that recorded it. That is enough for replay benchmarks.
+void command_stream_write(const struct command_stream *const command_stream, FILE *file) {
+    fwrite(command_stream_file_magic, sizeof command_stream_file_magic, 1, file);
+    fwrite(&command_stream_file_version, sizeof command_stream_file_version, 1, file);
+    fwrite(&command_stream->packet_count, sizeof command_stream->packet_count, 1, file);
+
+    struct command_stream_iterator iterator = {0};
+    const struct command_stream_packet *packet = NULL;
+
+    while ((packet = command_stream_next(command_stream, &iterator)) != NULL) {
+        fwrite(packet, packet->size, 1, file);
+    }
+}
+
+void command_stream_read(struct command_stream *command_stream, FILE *file) {
+    char magic[4];
+    uint32_t version = 0U;
+    uint32_t packet_count = 0U;
+
+    if (fread(magic, sizeof magic, 1, file) != 1 || memcmp(magic, command_stream_file_magic, sizeof magic) != 0
+        || fread(&version, sizeof version, 1, file) != 1 || version != command_stream_file_version
+        || fread(&packet_count, sizeof packet_count, 1, file) != 1) {
+        fprintf(stderr, "error: invalid command stream capture\n");
+        exit(1);
+    }
+
+    command_stream_reset(command_stream);
+
+    for (uint32_t packet_index = 0U; packet_index < packet_count; ++packet_index) {
+        struct command_stream_packet header;
+
+        if (fread(&header, sizeof header, 1, file) != 1 || header.size < sizeof header || header.size % COMMAND_STREAM_ALIGNMENT != 0U) {
+            fprintf(stderr, "error: truncated command stream capture\n");
+            exit(1);
+        }
+
+        struct command_stream_packet *packet = command_stream_allocate_packet(command_stream, header.op, header.size);
+
+        if (fread(packet + 1, header.size - sizeof header, 1, file) != 1 && header.size > sizeof header) {
+            fprintf(stderr, "error: truncated command stream capture\n");
+            exit(1);
+        }
+    }
+}
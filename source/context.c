@@ -2,26 +2,52 @@
 
 #include <buffer.h>
 #include <commandbuffer.h>
+#include <commandstream.h>
+#include <deferredlighting.h>
 #include <device.h>
+#include <dynamicresolution.h>
 #include <framebuffer.h>
 #include <instance.h>
 #include <pipeline.h>
+#include <pipelinecache.h>
+#include <pipelinecompiler.h>
 #include <queue.h>
+#include <readback.h>
+#include <rendergraph.h>
 #include <renderpass.h>
 #include <shadermodule.h>
+#include <shaderwatcher.h>
 #include <swapchain.h>
+#include <uniformring.h>
 #include <window.h>
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
 
-struct context *context_create(GLFWwindow *window) {
-    struct context *context = malloc(sizeof *context);
+static const char *const pipeline_cache_path = "pipeline.cache";
+
+// Seconds between writes of a grown pipeline cache while running.
+static const double pipeline_cache_save_interval = 30.0;
+
+static double context_get_time(void) {
+    struct timespec timespec;
+    clock_gettime(CLOCK_MONOTONIC, &timespec);
+    return timespec.tv_sec + timespec.tv_nsec / 1e9;
+}
 
+// Creates everything up to the pipeline compiler, which windowed and headless
+// contexts share. The swapchain extension is only enabled when presentable.
+static void context_create_device(
+    struct context *context,
+    const uint32_t instance_extension_count,
+    const char *const *const instance_extension_names,
+    const bool presentable
+) {
     const uint32_t instance_layer_count = 1;
     const char *const instance_layer_names[] = {"VK_LAYER_KHRONOS_validation"};
-    uint32_t instance_extension_count = 0;
-    const char *const *const instance_extension_names = glfwGetRequiredInstanceExtensions(&instance_extension_count);
     context->instance = instance_create(instance_layer_count, instance_layer_names , instance_extension_count, instance_extension_names);
 
     context->physical_device = instance_choose_physical_device(context->instance);
@@ -30,7 +56,561 @@ struct context *context_create(GLFWwindow *window) {
 
     context->queue_family_index = physical_device_find_queue_family_index(context->physical_device, VK_QUEUE_GRAPHICS_BIT);
 
-    context->device = device_create(context->physical_device, context->queue_family_index);
+    const VkPhysicalDeviceFeatures supported_features = physical_device_get_features(context->physical_device);
+    const VkPhysicalDeviceVulkan12Features supported_vulkan_12_features = physical_device_get_vulkan_12_features(context->physical_device);
+
+    // Pipeline libraries are used when available, lavapipe implements them.
+    context->enabled_graphics_pipeline_library_features = physical_device_get_graphics_pipeline_library_features(context->physical_device);
+    const bool use_graphics_pipeline_library = context->enabled_graphics_pipeline_library_features.graphicsPipelineLibrary;
+
+    // Fixed function state that can be set while recording no longer needs a
+    // pipeline per combination. Only the state used by the descriptions is
+    // enabled from the third extension.
+    context->enabled_extended_dynamic_state_features = physical_device_get_extended_dynamic_state_features(context->physical_device);
+    const VkPhysicalDeviceExtendedDynamicState3FeaturesEXT supported_extended_dynamic_state_3_features = physical_device_get_extended_dynamic_state_3_features(context->physical_device);
+
+    context->enabled_extended_dynamic_state_3_features = (VkPhysicalDeviceExtendedDynamicState3FeaturesEXT) {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT,
+        .pNext = NULL,
+        .extendedDynamicState3PolygonMode = supported_extended_dynamic_state_3_features.extendedDynamicState3PolygonMode,
+        .extendedDynamicState3ColorBlendEnable = supported_extended_dynamic_state_3_features.extendedDynamicState3ColorBlendEnable,
+        .extendedDynamicState3ColorBlendEquation = supported_extended_dynamic_state_3_features.extendedDynamicState3ColorBlendEquation
+    };
+
+    // Rendering straight into image views leaves render pass and framebuffers
+    // out of swapchain recreation and of pipeline compatibility.
+    context->enabled_dynamic_rendering_features = physical_device_get_dynamic_rendering_features(context->physical_device);
+    const bool use_dynamic_rendering = context->enabled_dynamic_rendering_features.dynamicRendering;
+
+    const bool use_extended_dynamic_state = context->enabled_extended_dynamic_state_features.extendedDynamicState;
+    const bool use_extended_dynamic_state_3 =
+        context->enabled_extended_dynamic_state_3_features.extendedDynamicState3PolygonMode ||
+        context->enabled_extended_dynamic_state_3_features.extendedDynamicState3ColorBlendEnable ||
+        context->enabled_extended_dynamic_state_3_features.extendedDynamicState3ColorBlendEquation;
+
+    uint32_t dynamic_state_flags = use_extended_dynamic_state ? GRAPHICS_PIPELINE_DYNAMIC_STATES_EXTENDED : 0U;
+    dynamic_state_flags |= context->enabled_extended_dynamic_state_3_features.extendedDynamicState3PolygonMode ? GRAPHICS_PIPELINE_DYNAMIC_STATE_POLYGON_MODE_BIT : 0U;
+    dynamic_state_flags |= context->enabled_extended_dynamic_state_3_features.extendedDynamicState3ColorBlendEnable ? GRAPHICS_PIPELINE_DYNAMIC_STATE_COLOR_BLEND_ENABLE_BIT : 0U;
+    dynamic_state_flags |= context->enabled_extended_dynamic_state_3_features.extendedDynamicState3ColorBlendEquation ? GRAPHICS_PIPELINE_DYNAMIC_STATE_COLOR_BLEND_EQUATION_BIT : 0U;
+
+    void *enabled_feature_chain = NULL;
+
+    if (use_graphics_pipeline_library) {
+        context->enabled_graphics_pipeline_library_features.pNext = enabled_feature_chain;
+        enabled_feature_chain = &context->enabled_graphics_pipeline_library_features;
+    }
+
+    if (use_extended_dynamic_state) {
+        context->enabled_extended_dynamic_state_features.pNext = enabled_feature_chain;
+        enabled_feature_chain = &context->enabled_extended_dynamic_state_features;
+    }
+
+    if (use_extended_dynamic_state_3) {
+        context->enabled_extended_dynamic_state_3_features.pNext = enabled_feature_chain;
+        enabled_feature_chain = &context->enabled_extended_dynamic_state_3_features;
+    }
+
+    if (use_dynamic_rendering) {
+        context->enabled_dynamic_rendering_features.pNext = enabled_feature_chain;
+        enabled_feature_chain = &context->enabled_dynamic_rendering_features;
+    }
+
+    context->enabled_vulkan_12_features = (VkPhysicalDeviceVulkan12Features) {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+        .pNext = enabled_feature_chain,
+        .drawIndirectCount = supported_vulkan_12_features.drawIndirectCount,
+        .timelineSemaphore = supported_vulkan_12_features.timelineSemaphore
+    };
+
+    if (context->physical_device_properties.apiVersion >= VK_API_VERSION_1_2) {
+        enabled_feature_chain = &context->enabled_vulkan_12_features;
+    }
+
+    VkPhysicalDeviceFeatures2 enabled_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = enabled_feature_chain,
+        .features.drawIndirectFirstInstance = supported_features.drawIndirectFirstInstance,
+        .features.multiDrawIndirect = supported_features.multiDrawIndirect
+    };
+
+    uint32_t device_extension_count = 0;
+    const char *device_extension_names[6];
+
+    if (presentable) {
+        device_extension_names[device_extension_count++] = VK_KHR_SWAPCHAIN_EXTENSION_NAME;
+    }
+
+    if (use_graphics_pipeline_library) {
+        device_extension_names[device_extension_count++] = VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME;
+        device_extension_names[device_extension_count++] = VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME;
+    }
+
+    if (use_extended_dynamic_state) {
+        device_extension_names[device_extension_count++] = VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME;
+    }
+
+    if (use_extended_dynamic_state_3) {
+        device_extension_names[device_extension_count++] = VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME;
+    }
+
+    if (use_dynamic_rendering) {
+        device_extension_names[device_extension_count++] = VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME;
+    }
+
+    context->device = device_create(context->physical_device, context->queue_family_index, device_extension_count, device_extension_names, &enabled_features);
+
+    context->enabled_features = enabled_features.features;
+    context->dynamic_state_commands = command_buffer_load_dynamic_state_commands(context->device, dynamic_state_flags);
+
+    if (use_dynamic_rendering) {
+        context->dynamic_rendering_commands = command_buffer_load_dynamic_rendering_commands(context->device);
+    }
+
+    context->queue = device_get_queue(context->device, context->queue_family_index);
+
+    context->depth_format = physical_device_choose_depth_format(context->physical_device);
+    context->depth_prepass = getenv("LEARN_VULKAN_DEPTH_PREPASS") != NULL;
+
+    const char *const requested_sample_count = getenv("LEARN_VULKAN_MSAA_SAMPLES");
+    context->sample_count = physical_device_choose_sample_count(context->physical_device_properties, requested_sample_count ? (uint32_t) strtoul(requested_sample_count, NULL, 10) : 1U);
+
+    // An input attachment is read at its own pixel and through a view of a
+    // single aspect, so the G-buffer has one sample and no stencil.
+    context->deferred = getenv("LEARN_VULKAN_DEFERRED") != NULL;
+
+    if (context->deferred && context->sample_count != VK_SAMPLE_COUNT_1_BIT) {
+        fprintf(stderr, "warning: deferred shading renders with one sample, ignoring LEARN_VULKAN_MSAA_SAMPLES\n");
+        context->sample_count = VK_SAMPLE_COUNT_1_BIT;
+    }
+
+    if (context->deferred && context->depth_format == VK_FORMAT_D24_UNORM_S8_UINT) {
+        fprintf(stderr, "warning: deferred shading needs a depth format without stencil, rendering forward\n");
+        context->deferred = false;
+    }
+
+    context->render_pass_cache = render_pass_cache_create(context->device);
+    context->shader_module_cache = shader_module_cache_create(context->device);
+    context->vertex_shader_module = shader_module_cache_acquire(context->shader_module_cache, "vert");
+    context->fragment_shader_module = shader_module_cache_acquire(context->shader_module_cache, "frag");
+
+    //
+    // The pipeline layout is derived from the shaders. Set 0 binding 0 is fed
+    // by the uniform ring and therefore has to be a uniform buffer.
+
+    const struct shader_reflection *const shader_reflections[] = {
+        &context->vertex_shader_module->reflection,
+        &context->fragment_shader_module->reflection
+    };
+
+    struct shader_reflection_layout shader_reflection_layout;
+    shader_reflection_merge_layout(shader_reflections, 2, &shader_reflection_layout);
+
+    const struct shader_reflection_binding *const uniform_binding = shader_reflection_layout_find_binding(&shader_reflection_layout, 0, 0);
+
+    if (shader_reflection_layout.set_count != 1 || uniform_binding == NULL || uniform_binding->descriptor_type != VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER) {
+        fprintf(stderr, "error: shaders must use a single uniform buffer at set 0 binding 0\n");
+        exit(1);
+    }
+
+    context->descriptor_set_layout = shader_reflection_layout_create_descriptor_set_layout(context->device, &shader_reflection_layout, 0, VK_TRUE);
+
+    context->graphics_pipeline_layout = pipeline_layout_create(context->device, 1, &context->descriptor_set_layout, shader_reflection_layout.push_constant_range_count, &shader_reflection_layout.push_constant_range);
+    context->graphics_push_constant_range = shader_reflection_layout.push_constant_range_count ? shader_reflection_layout.push_constant_range : (VkPushConstantRange) {0};
+
+    bool pipeline_cache_loaded = false;
+    context->pipeline_cache = pipeline_cache_create(context->device, context->physical_device_properties, pipeline_cache_path, &pipeline_cache_loaded);
+
+    // Leave one core to the frame loop.
+    const long processor_count = sysconf(_SC_NPROCESSORS_ONLN);
+    const uint32_t pipeline_compiler_thread_count = processor_count > 2 ? (processor_count - 1 < 4 ? processor_count - 1 : 4) : 1;
+    context->pipeline_compiler = pipeline_compiler_create(context->device, context->pipeline_cache, pipeline_compiler_thread_count, use_graphics_pipeline_library, dynamic_state_flags);
+
+    context->pending_vertex_shader_module = NULL;
+    context->pending_fragment_shader_module = NULL;
+    context->pending_graphics_pipeline_future = NULL;
+    context->pending_lighting_vertex_shader_module = NULL;
+    context->pending_lighting_fragment_shader_module = NULL;
+    context->pending_lighting_pipeline_future = NULL;
+    context->retired_shader_module_count = 0U;
+    context->frame_index = 0U;
+    context->completed_frame_count = 0U;
+    context->shader_watcher = NULL;
+    context->pipeline_cache_save_time = context_get_time();
+
+    printf("info: %s start, pipelines compiling on %u threads%s, dynamic state flags 0x%03x, %s, depth format %d%s, %u samples\n",
+        pipeline_cache_loaded ? "warm" : "cold",
+        pipeline_compiler_thread_count,
+        use_graphics_pipeline_library ? " with pipeline libraries" : "",
+        dynamic_state_flags,
+        context->deferred ? "deferred subpasses" : use_dynamic_rendering ? "dynamic rendering" : "render pass objects",
+        context->depth_format,
+        context->depth_prepass ? " with depth pre-pass" : "",
+        context->sample_count);
+}
+
+static VkRenderPass context_get_render_pass(const struct context *const context) {
+    struct render_pass_description render_pass_description;
+
+    // Dynamic rendering has no subpasses to hand the G-buffer over in.
+    if (context->deferred) {
+        render_pass_description_init_deferred(&render_pass_description, CONTEXT_GBUFFER_ALBEDO_FORMAT, context->depth_format, context->surface_format.format);
+        return render_pass_cache_get(context->render_pass_cache, &render_pass_description);
+    }
+
+    if (context->enabled_dynamic_rendering_features.dynamicRendering) {
+        return VK_NULL_HANDLE;
+    }
+
+    render_pass_description_init(&render_pass_description, context->surface_format.format, context->depth_format, context->sample_count);
+
+    return render_pass_cache_get(context->render_pass_cache, &render_pass_description);
+}
+
+static void context_describe_default_graphics_pipeline(struct context *context) {
+    graphics_pipeline_description_init(&context->graphics_pipeline_description);
+    graphics_pipeline_description_set_shaders(&context->graphics_pipeline_description, context->vertex_shader_module, context->fragment_shader_module);
+    context->graphics_pipeline_description.pipeline_layout = context->graphics_pipeline_layout;
+    context->graphics_pipeline_description.render_pass = context->render_pass;
+    context->graphics_pipeline_description.color_attachment_format = context->deferred ? CONTEXT_GBUFFER_ALBEDO_FORMAT : context->surface_format.format;
+    context->graphics_pipeline_description.depth_attachment_format = context->depth_format;
+    context->graphics_pipeline_description.sample_count = context->sample_count;
+    graphics_pipeline_description_set_vertex_input(&context->graphics_pipeline_description, &context->vertex_shader_module->reflection);
+    context->graphics_pipeline_description.cull_mode = VK_CULL_MODE_BACK_BIT;
+    context->graphics_pipeline_description.blend_enable = VK_TRUE;
+    context->graphics_pipeline_description.src_color_blend_factor = VK_BLEND_FACTOR_SRC_ALPHA;
+    context->graphics_pipeline_description.dst_color_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    context->graphics_pipeline_description.depth_test_enable = VK_TRUE;
+    context->graphics_pipeline_description.depth_write_enable = VK_TRUE;
+    context->graphics_pipeline_description.depth_compare_op = VK_COMPARE_OP_LESS_OR_EQUAL;
+}
+
+// What the passes of the render graph record in context_end_frame.
+struct context_frame {
+    struct context *context;
+    const struct draw_queue *draw_queue;
+    const struct command_stream *const *command_streams;
+    uint32_t command_stream_count;
+};
+
+static void context_record_scene_pass(const VkCommandBuffer command_buffer, const struct render_graph *render_graph, void *frame_data) {
+    struct context_frame *frame = frame_data;
+    struct context *context = frame->context;
+    // With dynamic resolution the scene goes into its own image first.
+    const VkImageView target_image_view = context->dynamic_resolution != NULL
+        ? render_graph_get_image_view(render_graph, context->render_graph_scene_image)
+        : context->image_views[context->image_index];
+    const VkImageView depth_image_view = render_graph_get_image_view(render_graph, context->render_graph_depth_image);
+    const bool multisampled = context->sample_count != VK_SAMPLE_COUNT_1_BIT;
+    const VkImageView color_image_view = multisampled ? render_graph_get_image_view(render_graph, context->render_graph_color_image) : target_image_view;
+
+    if (context->render_pass == VK_NULL_HANDLE) {
+        command_buffer_record_rendering(
+            command_buffer,
+            context->render_extent,
+            color_image_view,
+            multisampled ? target_image_view : VK_NULL_HANDLE,
+            depth_image_view,
+            &context->dynamic_rendering_commands,
+            frame->draw_queue,
+            &context->dynamic_state_commands,
+            context->depth_prepass,
+            frame->command_streams,
+            frame->command_stream_count,
+            &context->draw_queue_statistics);
+        return;
+    }
+
+    // Color, depth and, when multisampled, the resolve attachment, in the
+    // order of render_pass_description_init. With deferred shading the draws
+    // go to the albedo image and the lighting subpass writes the target.
+    const VkImageView attachments[] = {
+        context->deferred ? render_graph_get_image_view(render_graph, context->render_graph_albedo_image) : color_image_view,
+        depth_image_view,
+        target_image_view
+    };
+
+    command_buffer_record_render_pass(
+        command_buffer,
+        context->render_extent,
+        context->render_pass,
+        framebuffer_cache_get(context->framebuffer_cache, context->render_pass, multisampled || context->deferred ? 3 : 2, attachments, context->scene_extent),
+        context->deferred_lighting,
+        frame->draw_queue,
+        &context->dynamic_state_commands,
+        context->depth_prepass,
+        frame->command_streams,
+        frame->command_stream_count,
+        &context->draw_queue_statistics);
+}
+
+// Stretches the part of the scene image drawn this frame over the swapchain
+// image.
+static void context_record_upscale_pass(const VkCommandBuffer command_buffer, const struct render_graph *render_graph, void *frame_data) {
+    struct context_frame *frame = frame_data;
+    struct context *context = frame->context;
+
+    const VkImageBlit image_blit = {
+        .srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .srcSubresource.mipLevel = 0,
+        .srcSubresource.baseArrayLayer = 0,
+        .srcSubresource.layerCount = 1,
+        .srcOffsets = {{0, 0, 0}, {(int32_t) context->render_extent.width, (int32_t) context->render_extent.height, 1}},
+        .dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .dstSubresource.mipLevel = 0,
+        .dstSubresource.baseArrayLayer = 0,
+        .dstSubresource.layerCount = 1,
+        .dstOffsets = {{0, 0, 0}, {(int32_t) context->surface_capabilities.currentExtent.width, (int32_t) context->surface_capabilities.currentExtent.height, 1}}
+    };
+
+    vkCmdBlitImage(
+        command_buffer,
+        render_graph_get_image(render_graph, context->render_graph_scene_image), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        render_graph_get_image(render_graph, context->render_graph_swapchain_image), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        1, &image_blit,
+        VK_FILTER_LINEAR);
+}
+
+static void context_record_readback_pass(const VkCommandBuffer command_buffer, const struct render_graph *render_graph, void *frame_data) {
+    struct context_frame *frame = frame_data;
+    struct context *context = frame->context;
+
+    readback_record_copy(context->readback, command_buffer, render_graph_get_image(render_graph, context->render_graph_swapchain_image));
+}
+
+// The swapchain image is imported in the state the acquire semaphore leaves it
+// in, the wait happens at the color attachment output stage, and handed back
+// for presentation. The depth buffer is transient, it is cleared at the start
+// of the scene pass and never stored, so on tilers it may never be backed by
+// memory at all. The same goes for the multisample color image, only its
+// resolve leaves the tile memory.
+//
+// With dynamic resolution the scene attachments are sized for the largest
+// scale and each frame draws into the top left part of them, so a new scale
+// does not rebuild anything. An upscale pass blits that part to the swapchain
+// image.
+//
+// Deferred shading keeps the whole G-buffer, albedo and depth, inside the
+// scene pass. Both are transient and only handed between its two subpasses,
+// so the graph sees them written once and never stored.
+static void context_build_render_graph(struct context *context) {
+    const bool presentable = context->surface != VK_NULL_HANDLE;
+
+    render_graph_reset(context->render_graph);
+
+    const struct render_graph_resource_state swapchain_initial_state = {
+        .stage_mask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        .access_mask = 0,
+        .layout = VK_IMAGE_LAYOUT_UNDEFINED
+    };
+
+    // Offscreen images are left ready to be copied out.
+    const struct render_graph_resource_state swapchain_final_state = {
+        .stage_mask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        .access_mask = 0,
+        .layout = presentable ? VK_IMAGE_LAYOUT_PRESENT_SRC_KHR : VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+    };
+
+    context->render_graph_swapchain_image = render_graph_import_image(context->render_graph, presentable ? "swapchain" : "offscreen", context->surface_format.format, swapchain_initial_state);
+    render_graph_set_output(context->render_graph, context->render_graph_swapchain_image, swapchain_final_state);
+
+    context->scene_extent = context->dynamic_resolution != NULL
+        ? dynamic_resolution_scale_extent(context->surface_capabilities.currentExtent, context->dynamic_resolution->max_scale)
+        : context->surface_capabilities.currentExtent;
+    context->render_extent = context->scene_extent;
+
+    uint32_t target_image = context->render_graph_swapchain_image;
+
+    if (context->dynamic_resolution != NULL) {
+        const struct render_graph_image_description scene_image_description = {
+            .format = context->surface_format.format,
+            .extent = context->scene_extent,
+            .sample_count = VK_SAMPLE_COUNT_1_BIT,
+            .transient_attachment = false
+        };
+
+        context->render_graph_scene_image = render_graph_create_image(context->render_graph, "scene", &scene_image_description);
+        target_image = context->render_graph_scene_image;
+    }
+
+    const struct render_graph_image_description depth_image_description = {
+        .format = context->depth_format,
+        .extent = context->scene_extent,
+        .sample_count = context->sample_count,
+        .transient_attachment = true
+    };
+
+    context->render_graph_depth_image = render_graph_create_image(context->render_graph, "depth", &depth_image_description);
+
+    const uint32_t scene_pass = render_graph_add_pass(context->render_graph, "scene", context_record_scene_pass);
+    render_graph_pass_access(context->render_graph, scene_pass, target_image, RENDER_GRAPH_ACCESS_COLOR_ATTACHMENT_WRITE);
+
+    if (context->deferred) {
+        const struct render_graph_image_description albedo_image_description = {
+            .format = CONTEXT_GBUFFER_ALBEDO_FORMAT,
+            .extent = context->scene_extent,
+            .sample_count = VK_SAMPLE_COUNT_1_BIT,
+            .transient_attachment = true
+        };
+
+        context->render_graph_albedo_image = render_graph_create_image(context->render_graph, "albedo", &albedo_image_description);
+        render_graph_pass_access(context->render_graph, scene_pass, context->render_graph_albedo_image, RENDER_GRAPH_ACCESS_COLOR_INPUT_ATTACHMENT);
+        render_graph_pass_access(context->render_graph, scene_pass, context->render_graph_depth_image, RENDER_GRAPH_ACCESS_DEPTH_INPUT_ATTACHMENT);
+    } else {
+        context->render_graph_albedo_image = UINT32_MAX;
+        render_graph_pass_access(context->render_graph, scene_pass, context->render_graph_depth_image, RENDER_GRAPH_ACCESS_DEPTH_ATTACHMENT_WRITE);
+    }
+
+    if (context->sample_count != VK_SAMPLE_COUNT_1_BIT) {
+        const struct render_graph_image_description color_image_description = {
+            .format = context->surface_format.format,
+            .extent = context->scene_extent,
+            .sample_count = context->sample_count,
+            .transient_attachment = true
+        };
+
+        // The resolve writes the target image at the color attachment output
+        // stage, which the access above already covers.
+        context->render_graph_color_image = render_graph_create_image(context->render_graph, "color", &color_image_description);
+        render_graph_pass_access(context->render_graph, scene_pass, context->render_graph_color_image, RENDER_GRAPH_ACCESS_COLOR_ATTACHMENT_WRITE);
+    }
+
+    if (context->dynamic_resolution != NULL) {
+        const uint32_t upscale_pass = render_graph_add_pass(context->render_graph, "upscale", context_record_upscale_pass);
+        render_graph_pass_access(context->render_graph, upscale_pass, context->render_graph_scene_image, RENDER_GRAPH_ACCESS_TRANSFER_READ);
+        render_graph_pass_access(context->render_graph, upscale_pass, context->render_graph_swapchain_image, RENDER_GRAPH_ACCESS_TRANSFER_WRITE);
+    }
+
+    // The buffer of the current readback slot is set every frame and handed
+    // to the host once the copy is done.
+    if (context->readback != NULL) {
+        const struct render_graph_resource_state readback_initial_state = {
+            .stage_mask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            .access_mask = 0,
+            .layout = VK_IMAGE_LAYOUT_UNDEFINED
+        };
+
+        const struct render_graph_resource_state readback_final_state = {
+            .stage_mask = VK_PIPELINE_STAGE_HOST_BIT,
+            .access_mask = VK_ACCESS_HOST_READ_BIT,
+            .layout = VK_IMAGE_LAYOUT_UNDEFINED
+        };
+
+        context->render_graph_readback_buffer = render_graph_import_buffer(context->render_graph, "readback", VK_NULL_HANDLE, readback_initial_state);
+        render_graph_set_output(context->render_graph, context->render_graph_readback_buffer, readback_final_state);
+
+        const uint32_t readback_pass = render_graph_add_pass(context->render_graph, "readback", context_record_readback_pass);
+        render_graph_pass_access(context->render_graph, readback_pass, context->render_graph_swapchain_image, RENDER_GRAPH_ACCESS_TRANSFER_READ);
+        render_graph_pass_access(context->render_graph, readback_pass, context->render_graph_readback_buffer, RENDER_GRAPH_ACCESS_TRANSFER_WRITE);
+    }
+
+    render_graph_compile(context->render_graph);
+
+    if (context->deferred_lighting != NULL) {
+        deferred_lighting_set_gbuffer(
+            context->deferred_lighting,
+            render_graph_get_image_view(context->render_graph, context->render_graph_albedo_image),
+            render_graph_get_image_view(context->render_graph, context->render_graph_depth_image));
+    }
+}
+
+// The images the render graph creates go away when it is built again.
+static void context_evict_transient_framebuffers(struct context *context) {
+    framebuffer_cache_evict_image_view(context->framebuffer_cache, render_graph_get_image_view(context->render_graph, context->render_graph_depth_image));
+
+    if (context->sample_count != VK_SAMPLE_COUNT_1_BIT) {
+        framebuffer_cache_evict_image_view(context->framebuffer_cache, render_graph_get_image_view(context->render_graph, context->render_graph_color_image));
+    }
+
+    if (context->dynamic_resolution != NULL) {
+        framebuffer_cache_evict_image_view(context->framebuffer_cache, render_graph_get_image_view(context->render_graph, context->render_graph_scene_image));
+    }
+
+    if (context->deferred) {
+        framebuffer_cache_evict_image_view(context->framebuffer_cache, render_graph_get_image_view(context->render_graph, context->render_graph_albedo_image));
+    }
+}
+
+// LEARN_VULKAN_DYNAMIC_RESOLUTION is target_ms[,min_scale[,max_scale]], the
+// GPU time per frame to hold and the bounds of the resolution scale.
+static void context_create_dynamic_resolution(struct context *context) {
+    context->dynamic_resolution = NULL;
+
+    const char *const setting = getenv("LEARN_VULKAN_DYNAMIC_RESOLUTION");
+
+    if (setting == NULL) {
+        return;
+    }
+
+    double target_gpu_time = 0.0;
+    float min_scale = 0.5f;
+    float max_scale = 1.0f;
+
+    if (sscanf(setting, "%lf,%f,%f", &target_gpu_time, &min_scale, &max_scale) < 1 || target_gpu_time <= 0.0 || min_scale <= 0.0f || min_scale > max_scale) {
+        fprintf(stderr, "error: LEARN_VULKAN_DYNAMIC_RESOLUTION must be target_ms[,min_scale[,max_scale]]\n");
+        exit(1);
+    }
+
+    VkFormatProperties format_properties;
+    vkGetPhysicalDeviceFormatProperties(context->physical_device, context->surface_format.format, &format_properties);
+
+    const VkFormatFeatureFlags blit_features = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+
+    const uint32_t timestamp_valid_bits = physical_device_get_queue_family_properties(context->physical_device, context->queue_family_index).timestampValidBits;
+
+    if ((format_properties.optimalTilingFeatures & blit_features) != blit_features
+        || !(context->surface_capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT)
+        || !context->physical_device_properties.limits.timestampComputeAndGraphics
+        || timestamp_valid_bits == 0U) {
+        fprintf(stderr, "warning: dynamic resolution is not supported, rendering at full resolution\n");
+        return;
+    }
+
+    context->dynamic_resolution = dynamic_resolution_create(context->device, context->physical_device_properties, timestamp_valid_bits, context->swapchain_image_count, min_scale, max_scale, target_gpu_time);
+
+    printf("info: dynamic resolution between %.2f and %.2f for %.2f ms of GPU time\n", min_scale, max_scale, target_gpu_time);
+}
+
+// Everything the frame loop needs besides the swapchain or offscreen images
+// and the semaphores that only presentation uses.
+static void context_create_frame_resources(struct context *context) {
+    context->readback = NULL;
+    context_create_dynamic_resolution(context);
+
+    context->render_pass = context_get_render_pass(context);
+    context->framebuffer_cache = framebuffer_cache_create(context->device);
+
+    context->deferred_lighting = context->deferred
+        ? deferred_lighting_create(context->device, context->shader_module_cache, context->pipeline_compiler, context->render_pass)
+        : NULL;
+
+    context->render_graph = render_graph_create(context->device, context->physical_device_properties, context->physical_device_memory_properties);
+    context_build_render_graph(context);
+
+    context->uniform_ring = uniform_ring_create(context->device, context->descriptor_set_layout, context->physical_device_properties, context->physical_device_memory_properties, context->swapchain_image_count, 64U * 1024U, 256U);
+
+    context_describe_default_graphics_pipeline(context);
+    context->graphics_pipeline_future = pipeline_compiler_request_graphics(context->pipeline_compiler, &context->graphics_pipeline_description);
+
+    context->command_pool = command_pool_create(context->device, context->queue_family_index);
+    context->command_buffers = command_buffers_allocate(context->device, context->command_pool, context->swapchain_image_count);
+
+    context->fences = fences_create(context->device, context->swapchain_image_count);
+
+    context->command_arena = command_arena_create(4U * 1024U * 1024U, 16U * 1024U);
+
+    context->draw_queue_statistics = (struct draw_queue_statistics) {0};
+
+    context->image_frame_counts = calloc(context->swapchain_image_count, sizeof *context->image_frame_counts);
+}
+
+struct context *context_create(GLFWwindow *window) {
+    const double create_start_time = context_get_time();
+
+    struct context *context = malloc(sizeof *context);
+
+    uint32_t instance_extension_count = 0;
+    const char *const *const instance_extension_names = glfwGetRequiredInstanceExtensions(&instance_extension_count);
+    context_create_device(context, instance_extension_count, instance_extension_names, true);
 
     context->surface = window_create_surface(window, context->instance);
     context->surface_format = surface_choose_format(context->surface, context->physical_device);
@@ -40,73 +620,574 @@ struct context *context_create(GLFWwindow *window) {
     context->swapchain = swapchain_create(context->physical_device, context->device, context->surface, context->surface_format, context->surface_capabilities, VK_NULL_HANDLE, context->queue_family_index, swapchain_min_image_count);
     context->swapchain_image_count = swapchain_get_image_count(context->swapchain, context->device);
 
+    context->swapchain_images = swapchain_get_images(context->swapchain, context->device, context->swapchain_image_count);
     context->image_views = swapchain_create_image_views(context->swapchain, context->device, context->surface_format, context->swapchain_image_count);
 
-    const VkShaderModule vertex_shader_module = shader_module_create(context->device, "vert.spv");
-    const VkShaderModule fragment_shader_module = shader_module_create(context->device, "frag.spv");
+    context->offscreen_images = NULL;
 
-    context->render_pass = render_pass_create(context->device, context->surface_format);
+    context->semaphore_image_available = semaphore_create(context->device);
+    context->semaphore_image_rendered = semaphore_create(context->device);
 
-    context->graphics_pipeline_layout = pipeline_layout_create(context->device);
-    context->graphics_pipeline = graphics_pipeline_create(context->device, context->surface_capabilities, context->render_pass, vertex_shader_module, fragment_shader_module, context->graphics_pipeline_layout);
+    context_create_frame_resources(context);
 
-    context->framebuffers = framebuffers_create(context->device, context->surface_capabilities, context->image_views, context->render_pass, context->swapchain_image_count);
+    const char *const shader_source_directory = getenv("LEARN_VULKAN_SHADER_SOURCE_DIRECTORY");
+    context->shader_watcher = shader_source_directory ? shader_watcher_create(context->shader_module_cache, shader_source_directory) : NULL;
 
-    context->command_pool = command_pool_create(context->device, context->queue_family_index);
+    if (context->shader_watcher != NULL) {
+        printf("info: reloading shaders from %s on change\n", shader_source_directory);
+    }
 
-    context->queue = device_get_queue(context->device, context->queue_family_index);
+    printf("info: context created in %.2f ms\n", (context_get_time() - create_start_time) * 1e3);
 
-    context->semaphore_image_available = semaphore_create(context->device);
-    context->semaphore_image_rendered = semaphore_create(context->device);
+    return context;
+}
+
+struct context *context_create_headless(const uint32_t width, const uint32_t height, const VkFormat color_format) {
+    const double create_start_time = context_get_time();
+
+    struct context *context = malloc(sizeof *context);
+
+    context_create_device(context, 0, NULL, false);
+
+    // Only the extent of the capabilities is used while recording.
+    context->surface = VK_NULL_HANDLE;
+    context->surface_format = (VkSurfaceFormatKHR) {
+        .format = color_format,
+        .colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR
+    };
+    context->surface_capabilities = (VkSurfaceCapabilitiesKHR) {0};
+    context->surface_capabilities.currentExtent = (VkExtent2D) {width, height};
+    context->surface_capabilities.supportedUsageFlags = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    context->swapchain = VK_NULL_HANDLE;
+
+    context->offscreen_images = offscreen_images_create(context->device, context->physical_device_memory_properties, color_format, context->surface_capabilities.currentExtent, CONTEXT_OFFSCREEN_IMAGE_COUNT);
+    context->swapchain_image_count = context->offscreen_images->image_count;
+    context->swapchain_images = context->offscreen_images->images;
+    context->image_views = context->offscreen_images->image_views;
+
+    context->semaphore_image_available = VK_NULL_HANDLE;
+    context->semaphore_image_rendered = VK_NULL_HANDLE;
+
+    context_create_frame_resources(context);
+
+    printf("info: headless context created in %.2f ms, rendering %ux%u into %u offscreen images\n",
+        (context_get_time() - create_start_time) * 1e3,
+        width,
+        height,
+        context->swapchain_image_count);
 
-    context->fences = fences_create(context->device, context->swapchain_image_count);
     return context;
 }
 
-void context_record_command_buffers(struct context *context, const VkBuffer vertex_buffer, const uint32_t vertex_count) {
-    context->command_buffers = command_buffer_create_draw(
-        context->device,
-        context->surface_capabilities,
-        context->command_pool,
-        context->render_pass,
-        context->framebuffers,
-        context->graphics_pipeline,
-        vertex_buffer,
-        context->swapchain_image_count,
-        vertex_count);
+void context_describe_graphics_pipeline(
+    const struct context *context,
+    const enum context_graphics_pipeline_variant variant,
+    struct graphics_pipeline_description *description
+) {
+    *description = context->graphics_pipeline_description;
+
+    switch (variant) {
+        case CONTEXT_GRAPHICS_PIPELINE_VARIANT_DEFAULT:
+            break;
+        case CONTEXT_GRAPHICS_PIPELINE_VARIANT_GRAYSCALE:
+            graphics_pipeline_description_set_specialization_constant(description, context->fragment_shader_module, "grayscale", VK_TRUE);
+            break;
+        case CONTEXT_GRAPHICS_PIPELINE_VARIANT_DEPTH_PREPASS:
+            description->color_write_mask = 0;
+            description->blend_enable = VK_FALSE;
+            break;
+        default:
+            fprintf(stderr, "error: invalid graphics pipeline variant\n");
+            exit(1);
+    }
+}
+
+// A reloaded shader has to fit the pipeline layout and the vertex buffers that
+// were built for the shaders the context was created with.
+static bool context_shaders_compatible(
+    const struct context *const context,
+    const struct shader_module *const vertex_shader_module,
+    const struct shader_module *const fragment_shader_module
+) {
+    const struct shader_reflection *const current_reflections[] = {
+        &context->vertex_shader_module->reflection,
+        &context->fragment_shader_module->reflection
+    };
+
+    const struct shader_reflection *const reloaded_reflections[] = {
+        &vertex_shader_module->reflection,
+        &fragment_shader_module->reflection
+    };
+
+    struct shader_reflection_layout current_layout;
+    struct shader_reflection_layout reloaded_layout;
+    shader_reflection_merge_layout(current_reflections, 2, &current_layout);
+
+    char message[128];
+
+    if (!shader_reflection_try_merge_layout(reloaded_reflections, 2, &reloaded_layout, message, sizeof message)) {
+        fprintf(stderr, "warning: %s\n", message);
+        return false;
+    }
+
+    if (!shader_reflection_layouts_equal(&current_layout, &reloaded_layout)) {
+        return false;
+    }
+
+    const struct shader_reflection *const current_vertex_reflection = &context->vertex_shader_module->reflection;
+    const struct shader_reflection *const reloaded_vertex_reflection = &vertex_shader_module->reflection;
+
+    if (current_vertex_reflection->input_count != reloaded_vertex_reflection->input_count) {
+        return false;
+    }
+
+    for (uint32_t input_index = 0U; input_index < reloaded_vertex_reflection->input_count; ++input_index) {
+        bool found = false;
+
+        for (uint32_t current_input_index = 0U; current_input_index < current_vertex_reflection->input_count; ++current_input_index) {
+            found = found || (
+                current_vertex_reflection->inputs[current_input_index].location == reloaded_vertex_reflection->inputs[input_index].location &&
+                current_vertex_reflection->inputs[current_input_index].format == reloaded_vertex_reflection->inputs[input_index].format);
+        }
+
+        if (!found) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// The module stays acquired until every pipeline built from it is destroyed.
+static void context_retire_shader_module(struct context *context, struct shader_module *shader_module) {
+    pipeline_compiler_retire_shader(context->pipeline_compiler, shader_module->content_hash[0], context->frame_index);
+    context->retired_shader_modules[context->retired_shader_module_count++] = shader_module;
+}
+
+// Same as context_apply_shader_update for the shaders of the lighting subpass.
+static void context_apply_lighting_shader_update(struct context *context, const struct shader_watcher_update *const update) {
+    struct deferred_lighting *deferred_lighting = context->deferred_lighting;
+    const bool is_vertex_shader = strcmp(update->name, "fullscreen") == 0;
+
+    struct shader_module *vertex_shader_module = context->pending_lighting_vertex_shader_module ? context->pending_lighting_vertex_shader_module : deferred_lighting->vertex_shader_module;
+    struct shader_module *fragment_shader_module = context->pending_lighting_fragment_shader_module ? context->pending_lighting_fragment_shader_module : deferred_lighting->fragment_shader_module;
+
+    if (update->shader_module == (is_vertex_shader ? vertex_shader_module : fragment_shader_module)) {
+        shader_module_cache_release(context->shader_module_cache, update->shader_module);
+        return;
+    }
+
+    if (is_vertex_shader) {
+        vertex_shader_module = update->shader_module;
+    } else {
+        fragment_shader_module = update->shader_module;
+    }
+
+    if (!deferred_lighting_shaders_compatible(deferred_lighting, vertex_shader_module, fragment_shader_module)) {
+        fprintf(stderr, "warning: reloaded %s.glsl does not match the lighting pipeline layout, keeping the previous shader\n", update->name);
+        shader_module_cache_release(context->shader_module_cache, update->shader_module);
+        return;
+    }
+
+    if (context->retired_shader_module_count + 5U > CONTEXT_MAX_RETIRED_SHADER_MODULES) {
+        fprintf(stderr, "warning: too many shader reloads in flight, ignoring %s.glsl\n", update->name);
+        shader_module_cache_release(context->shader_module_cache, update->shader_module);
+        return;
+    }
+
+    struct shader_module **pending_shader_module = is_vertex_shader ? &context->pending_lighting_vertex_shader_module : &context->pending_lighting_fragment_shader_module;
+
+    if (*pending_shader_module != NULL) {
+        context_retire_shader_module(context, *pending_shader_module);
+    }
+
+    *pending_shader_module = update->shader_module;
+
+    context->pending_lighting_pipeline_description = deferred_lighting->pipeline_description;
+    graphics_pipeline_description_set_shaders(&context->pending_lighting_pipeline_description, vertex_shader_module, fragment_shader_module);
+    context->pending_lighting_pipeline_future = pipeline_compiler_request_graphics(context->pipeline_compiler, &context->pending_lighting_pipeline_description);
+}
+
+static void context_apply_shader_update(struct context *context, const struct shader_watcher_update *const update) {
+    if (context->deferred_lighting != NULL && (strcmp(update->name, "fullscreen") == 0 || strcmp(update->name, "lighting") == 0)) {
+        context_apply_lighting_shader_update(context, update);
+        return;
+    }
+
+    const bool is_vertex_shader = strcmp(update->name, "vert") == 0;
+    const bool is_fragment_shader = strcmp(update->name, "frag") == 0;
+
+    struct shader_module *vertex_shader_module = context->pending_vertex_shader_module ? context->pending_vertex_shader_module : context->vertex_shader_module;
+    struct shader_module *fragment_shader_module = context->pending_fragment_shader_module ? context->pending_fragment_shader_module : context->fragment_shader_module;
+
+    // Unrelated shaders and edits that compile to identical SPIR-V change nothing.
+    if ((!is_vertex_shader && !is_fragment_shader) ||
+        update->shader_module == (is_vertex_shader ? vertex_shader_module : fragment_shader_module)) {
+        shader_module_cache_release(context->shader_module_cache, update->shader_module);
+        return;
+    }
+
+    if (is_vertex_shader) {
+        vertex_shader_module = update->shader_module;
+    } else {
+        fragment_shader_module = update->shader_module;
+    }
+
+    if (!context_shaders_compatible(context, vertex_shader_module, fragment_shader_module)) {
+        fprintf(stderr, "warning: reloaded %s.glsl does not match the pipeline layout or vertex input, keeping the previous shader\n", update->name);
+        shader_module_cache_release(context->shader_module_cache, update->shader_module);
+        return;
+    }
+
+    // Besides the superseded module, swapping in retires up to two modules for
+    // each of the scene and the lighting pipeline, see context_reload_shaders.
+    if (context->retired_shader_module_count + 5U > CONTEXT_MAX_RETIRED_SHADER_MODULES) {
+        fprintf(stderr, "warning: too many shader reloads in flight, ignoring %s.glsl\n", update->name);
+        shader_module_cache_release(context->shader_module_cache, update->shader_module);
+        return;
+    }
+
+    // A pending module that has not been swapped in yet is superseded.
+    struct shader_module **pending_shader_module = is_vertex_shader ? &context->pending_vertex_shader_module : &context->pending_fragment_shader_module;
+
+    if (*pending_shader_module != NULL) {
+        context_retire_shader_module(context, *pending_shader_module);
+    }
+
+    *pending_shader_module = update->shader_module;
+
+    context->pending_graphics_pipeline_description = context->graphics_pipeline_description;
+    graphics_pipeline_description_set_shaders(&context->pending_graphics_pipeline_description, vertex_shader_module, fragment_shader_module);
+    context->pending_graphics_pipeline_future = pipeline_compiler_request_graphics(context->pipeline_compiler, &context->pending_graphics_pipeline_description);
+}
+
+static void context_replace_shader_module(struct context *context, struct shader_module **shader_module, struct shader_module *replacement) {
+    if (*shader_module != replacement) {
+        context_retire_shader_module(context, *shader_module);
+    } else {
+        shader_module_cache_release(context->shader_module_cache, replacement);
+    }
+
+    *shader_module = replacement;
+}
+
+// Runs at the frame boundary and never waits: updates of the watcher are
+// turned into pipeline requests, a rebuilt pipeline is swapped in once it is
+// ready and pipelines of replaced shaders are destroyed once unused.
+static void context_reload_shaders(struct context *context) {
+    struct shader_watcher_update update;
+
+    while (shader_watcher_poll(context->shader_watcher, &update)) {
+        context_apply_shader_update(context, &update);
+    }
+
+    if (context->pending_graphics_pipeline_future != NULL && pipeline_future_is_ready(context->pending_graphics_pipeline_future)) {
+        if (context->pending_vertex_shader_module != NULL) {
+            context_replace_shader_module(context, &context->vertex_shader_module, context->pending_vertex_shader_module);
+            context->pending_vertex_shader_module = NULL;
+        }
+
+        if (context->pending_fragment_shader_module != NULL) {
+            context_replace_shader_module(context, &context->fragment_shader_module, context->pending_fragment_shader_module);
+            context->pending_fragment_shader_module = NULL;
+        }
+
+        context->graphics_pipeline_description = context->pending_graphics_pipeline_description;
+        context->graphics_pipeline_future = context->pending_graphics_pipeline_future;
+        context->pending_graphics_pipeline_future = NULL;
+
+        printf("info: shaders reloaded, pipeline rebuilt in %.2f ms\n", context->graphics_pipeline_future->compile_time * 1e3);
+    }
+
+    if (context->pending_lighting_pipeline_future != NULL && pipeline_future_is_ready(context->pending_lighting_pipeline_future)) {
+        struct deferred_lighting *deferred_lighting = context->deferred_lighting;
+
+        if (context->pending_lighting_vertex_shader_module != NULL) {
+            context_replace_shader_module(context, &deferred_lighting->vertex_shader_module, context->pending_lighting_vertex_shader_module);
+            context->pending_lighting_vertex_shader_module = NULL;
+        }
+
+        if (context->pending_lighting_fragment_shader_module != NULL) {
+            context_replace_shader_module(context, &deferred_lighting->fragment_shader_module, context->pending_lighting_fragment_shader_module);
+            context->pending_lighting_fragment_shader_module = NULL;
+        }
+
+        deferred_lighting->pipeline_description = context->pending_lighting_pipeline_description;
+        deferred_lighting->pipeline_future = context->pending_lighting_pipeline_future;
+        context->pending_lighting_pipeline_future = NULL;
+
+        printf("info: lighting shaders reloaded, pipeline rebuilt in %.2f ms\n", deferred_lighting->pipeline_future->compile_time * 1e3);
+    }
+
+    if (pipeline_compiler_collect_retired(context->pipeline_compiler, context->completed_frame_count)) {
+        for (uint32_t module_index = 0U; module_index < context->retired_shader_module_count; ++module_index) {
+            shader_module_cache_release(context->shader_module_cache, context->retired_shader_modules[module_index]);
+        }
+
+        context->retired_shader_module_count = 0U;
+    }
+}
+
+void context_begin_frame(struct context *context) {
+    if (context->swapchain != VK_NULL_HANDLE) {
+        context->image_index = queue_acquire_next_image(context->device, context->swapchain, context->semaphore_image_available, context->fences);
+    } else {
+        context->image_index = (uint32_t) (context->frame_index % context->swapchain_image_count);
+        queue_wait_for_fence(context->device, context->fences[context->image_index]);
+    }
+
+    if (context->dynamic_resolution != NULL) {
+        dynamic_resolution_update(context->dynamic_resolution, context->image_index);
+    }
+
+    if (context->readback != NULL) {
+        readback_poll(context->readback, context->frame_index);
+    }
+
+    // The queue executes in order, so with the fence of this image every
+    // frame up to the one last submitted for it has completed.
+    if (context->image_frame_counts[context->image_index] > context->completed_frame_count) {
+        context->completed_frame_count = context->image_frame_counts[context->image_index];
+    }
+
+    if (context->shader_watcher != NULL) {
+        context_reload_shaders(context);
+    }
+
+    // The fence of this image has been waited on, so its slice of the ring is free again.
+    uniform_ring_begin_frame(context->uniform_ring, context->image_index);
+
+    // Streams of the previous frame were replayed in context_end_frame.
+    command_arena_reset(context->command_arena);
+}
+
+void context_end_frame(
+    struct context *context,
+    const struct draw_queue *const draw_queue,
+    const struct command_stream *const *const command_streams,
+    const uint32_t command_stream_count
+) {
+    const VkCommandBuffer command_buffer = context->command_buffers[context->image_index];
+
+    struct context_frame frame = {
+        .context = context,
+        .draw_queue = draw_queue,
+        .command_streams = command_streams,
+        .command_stream_count = command_stream_count
+    };
+
+    render_graph_set_image(context->render_graph, context->render_graph_swapchain_image, context->swapchain_images[context->image_index], context->image_views[context->image_index]);
+
+    if (context->readback != NULL) {
+        render_graph_set_buffer(context->render_graph, context->render_graph_readback_buffer, readback_begin_frame(context->readback, context->frame_index));
+    }
+
+    command_buffer_begin(command_buffer);
+
+    if (context->dynamic_resolution != NULL) {
+        context->render_extent = dynamic_resolution_scale_extent(context->surface_capabilities.currentExtent, context->dynamic_resolution->scale);
+        dynamic_resolution_record_begin(context->dynamic_resolution, command_buffer, context->image_index);
+    }
+
+    render_graph_execute(context->render_graph, command_buffer, &frame);
+
+    if (context->dynamic_resolution != NULL) {
+        dynamic_resolution_record_end(context->dynamic_resolution, command_buffer, context->image_index);
+    }
+
+    command_buffer_end(command_buffer);
+
+    if (context->swapchain != VK_NULL_HANDLE) {
+        queue_submit_and_present(
+            context->queue,
+            context->swapchain,
+            context->command_buffers[context->image_index],
+            context->semaphore_image_available,
+            context->semaphore_image_rendered,
+            context->fences[context->image_index],
+            context->image_index);
+    } else {
+        queue_submit(
+            context->queue,
+            context->command_buffers[context->image_index],
+            context->fences[context->image_index],
+            context->readback ? context->readback->timeline_semaphore : VK_NULL_HANDLE,
+            context->frame_index + 1U);
+    }
+
+    context->image_frame_counts[context->image_index] = ++context->frame_index;
+
+    // Pipelines compiled while running are kept even if the process is killed
+    // later. The save runs on a compiler thread, headless contexts leave the
+    // cache alone as in context_destroy.
+    if (context->surface != VK_NULL_HANDLE && context_get_time() - context->pipeline_cache_save_time >= pipeline_cache_save_interval) {
+        context->pipeline_cache_save_time = context_get_time();
+        pipeline_compiler_request_cache_save(context->pipeline_compiler, pipeline_cache_path);
+    }
 }
 
 void context_destroy(struct context *context) {
+    const bool presentable = context->surface != VK_NULL_HANDLE;
+
+    if (context->shader_watcher != NULL) {
+        shader_watcher_destroy(context->shader_watcher);
+    }
+
+    pipeline_compiler_destroy(context->pipeline_compiler);
+
+    command_arena_destroy(context->command_arena);
     fences_destroy(context->device, context->fences, context->swapchain_image_count);
-    semaphore_destroy(context->device, context->semaphore_image_rendered);
-    semaphore_destroy(context->device, context->semaphore_image_available);
+
+    if (presentable) {
+        semaphore_destroy(context->device, context->semaphore_image_rendered);
+        semaphore_destroy(context->device, context->semaphore_image_available);
+    }
+
     command_buffers_free(context->device, context->command_pool, context->command_buffers, context->swapchain_image_count);
     command_pool_destroy(context->device, context->command_pool);
-    framebuffers_destroy(context->device, context->framebuffers, context->swapchain_image_count);
-    pipeline_destroy(context->device, context->graphics_pipeline);
+    framebuffer_cache_destroy(context->framebuffer_cache);
+    render_graph_destroy(context->render_graph);
+
+    if (context->dynamic_resolution != NULL) {
+        dynamic_resolution_destroy(context->dynamic_resolution);
+    }
+
+    if (context->deferred_lighting != NULL) {
+        deferred_lighting_destroy(context->deferred_lighting);
+    }
+
     pipeline_layout_destroy(context->graphics_pipeline_layout, context->device);
-    render_pass_destroy(context->render_pass, context->device);
-    swapchain_image_views_destroy(context->image_views, context->device, context->swapchain_image_count);
-    swapchain_destroy(context->swapchain, context->device);
-    surface_destroy(context->surface, context->instance);
+
+    // Headless contexts leave the cache of the application alone, the warm-up
+    // tool saves to a path of its own.
+    if (presentable) {
+        pipeline_cache_save(context->device, context->pipeline_cache, pipeline_cache_path);
+    }
+
+    pipeline_cache_destroy(context->device, context->pipeline_cache);
+    for (uint32_t module_index = 0U; module_index < context->retired_shader_module_count; ++module_index) {
+        shader_module_cache_release(context->shader_module_cache, context->retired_shader_modules[module_index]);
+    }
+
+    if (context->pending_fragment_shader_module != NULL) {
+        shader_module_cache_release(context->shader_module_cache, context->pending_fragment_shader_module);
+    }
+
+    if (context->pending_vertex_shader_module != NULL) {
+        shader_module_cache_release(context->shader_module_cache, context->pending_vertex_shader_module);
+    }
+
+    if (context->pending_lighting_fragment_shader_module != NULL) {
+        shader_module_cache_release(context->shader_module_cache, context->pending_lighting_fragment_shader_module);
+    }
+
+    if (context->pending_lighting_vertex_shader_module != NULL) {
+        shader_module_cache_release(context->shader_module_cache, context->pending_lighting_vertex_shader_module);
+    }
+
+    shader_module_cache_release(context->shader_module_cache, context->fragment_shader_module);
+    shader_module_cache_release(context->shader_module_cache, context->vertex_shader_module);
+    shader_module_cache_destroy(context->shader_module_cache);
+
+    uniform_ring_destroy(context->device, context->uniform_ring);
+
+    vkDestroyDescriptorSetLayout(context->device, context->descriptor_set_layout, NULL);
+    render_pass_cache_destroy(context->render_pass_cache);
+
+    if (presentable) {
+        swapchain_image_views_destroy(context->image_views, context->device, context->swapchain_image_count);
+        free(context->swapchain_images);
+        swapchain_destroy(context->swapchain, context->device);
+        surface_destroy(context->surface, context->instance);
+    } else {
+        offscreen_images_destroy(context->device, context->offscreen_images);
+    }
+
+    free(context->image_frame_counts);
+
     device_destroy(context->device);
     instance_destroy(context->instance);
+    free(context);
+}
+
+void context_attach_readback(struct context *context, struct readback *readback) {
+    if (context->surface != VK_NULL_HANDLE) {
+        fprintf(stderr, "error: readback needs a headless context\n");
+        exit(1);
+    }
+
+    if (!context->enabled_vulkan_12_features.timelineSemaphore) {
+        fprintf(stderr, "error: readback needs timeline semaphores\n");
+        exit(1);
+    }
+
+    vkDeviceWaitIdle(context->device);
+
+    context_evict_transient_framebuffers(context);
+
+    context->readback = readback;
+    context_build_render_graph(context);
+}
+
+// Pipelines built against the previous render pass are retired instead of
+// waited for. Their replacements compile in the background, draws are skipped
+// until they are ready.
+static void context_replace_render_pass(struct context *context, const VkRenderPass render_pass) {
+    if (context->render_pass != VK_NULL_HANDLE) {
+        pipeline_compiler_retire_render_pass(context->pipeline_compiler, context->render_pass, context->frame_index);
+    }
+
+    context->render_pass = render_pass;
+
+    const VkFormat color_attachment_format = context->deferred ? CONTEXT_GBUFFER_ALBEDO_FORMAT : context->surface_format.format;
+
+    context->graphics_pipeline_description.render_pass = render_pass;
+    context->graphics_pipeline_description.color_attachment_format = color_attachment_format;
+    context->graphics_pipeline_future = pipeline_compiler_request_graphics(context->pipeline_compiler, &context->graphics_pipeline_description);
+
+    if (context->pending_graphics_pipeline_future != NULL) {
+        context->pending_graphics_pipeline_description.render_pass = render_pass;
+        context->pending_graphics_pipeline_description.color_attachment_format = color_attachment_format;
+        context->pending_graphics_pipeline_future = pipeline_compiler_request_graphics(context->pipeline_compiler, &context->pending_graphics_pipeline_description);
+    }
+
+    if (context->deferred_lighting != NULL) {
+        context->deferred_lighting->pipeline_description.render_pass = render_pass;
+        context->deferred_lighting->pipeline_future = pipeline_compiler_request_graphics(context->pipeline_compiler, &context->deferred_lighting->pipeline_description);
+
+        if (context->pending_lighting_pipeline_future != NULL) {
+            context->pending_lighting_pipeline_description.render_pass = render_pass;
+            context->pending_lighting_pipeline_future = pipeline_compiler_request_graphics(context->pipeline_compiler, &context->pending_lighting_pipeline_description);
+        }
+    }
 }
 
 void context_recreate_swapchain(struct context *context, const uint32_t width, const uint32_t height) {
     vkDeviceWaitIdle(context->device);
 
+    context->completed_frame_count = context->frame_index;
+
     VkSwapchainKHR old_swapchain = context->swapchain;
 
+    fences_destroy(context->device, context->fences, context->swapchain_image_count);
     command_buffers_free(context->device, context->command_pool, context->command_buffers, context->swapchain_image_count);
     command_pool_destroy(context->device, context->command_pool);
-    framebuffers_destroy(context->device, context->framebuffers, context->swapchain_image_count);
     // pipeline_destroy(context->device, context->graphics_pipeline);
     // pipeline_layout_destroy(context->graphics_pipeline_layout, context->device);
-    render_pass_destroy(context->render_pass, context->device);
+
+    for (uint32_t image_index = 0U; image_index < context->swapchain_image_count; ++image_index) {
+        framebuffer_cache_evict_image_view(context->framebuffer_cache, context->image_views[image_index]);
+    }
+
+    context_evict_transient_framebuffers(context);
+
     swapchain_image_views_destroy(context->image_views, context->device, context->swapchain_image_count);
+    free(context->swapchain_images);
 
     context->surface_capabilities = surface_get_capabilities(context->surface, context->physical_device);
+    // Moving the window to another display can change the preferred format.
+    const VkFormat previous_surface_format = context->surface_format.format;
+    context->surface_format = surface_choose_format(context->surface, context->physical_device);
 
     const uint32_t swapchain_min_image_count = swapchain_choose_min_image_count(context->surface_capabilities);
     context->swapchain = swapchain_create(context->physical_device, context->device,
@@ -114,16 +1195,39 @@ void context_recreate_swapchain(struct context *context, const uint32_t width, c
         old_swapchain, context->queue_family_index, swapchain_min_image_count);
     context->swapchain_image_count = swapchain_get_image_count(context->swapchain, context->device);
 
+    context->swapchain_images = swapchain_get_images(context->swapchain, context->device, context->swapchain_image_count);
     context->image_views = swapchain_create_image_views(context->swapchain, context->device, context->surface_format, context->swapchain_image_count);
 
-    context->render_pass = render_pass_create(context->device, context->surface_format);
+    // With an unchanged surface format the cache returns the render pass the
+    // pipelines were built with and they are kept as they are.
+    const VkRenderPass render_pass = context_get_render_pass(context);
 
-    // context->graphics_pipeline_layout = pipeline_layout_create(context->device);
-    // context->graphics_pipeline = graphics_pipeline_create(context->device, context->surface_capabilities, context->render_pass, vertex_shader_module, fragment_shader_module, context->graphics_pipeline_layout);
+    if (render_pass != context->render_pass || context->surface_format.format != previous_surface_format) {
+        context_replace_render_pass(context, render_pass);
+    }
 
-    context->framebuffers = framebuffers_create(context->device, context->surface_capabilities, context->image_views, context->render_pass, context->swapchain_image_count);
+    // Transient resources follow the new extent.
+    context_build_render_graph(context);
+
+    if (context->dynamic_resolution != NULL) {
+        dynamic_resolution_resize(context->dynamic_resolution, context->swapchain_image_count);
+    }
 
     context->command_pool = command_pool_create(context->device, context->queue_family_index);
+    context->command_buffers = command_buffers_allocate(context->device, context->command_pool, context->swapchain_image_count);
+
+    free(context->image_frame_counts);
+    context->image_frame_counts = calloc(context->swapchain_image_count, sizeof *context->image_frame_counts);
+
+    context->fences = fences_create(context->device, context->swapchain_image_count);
+
+    uniform_ring_resize(context->device, context->physical_device_memory_properties, context->uniform_ring, context->swapchain_image_count);
 
     swapchain_destroy(old_swapchain, context->device);
+
+    printf("info: swapchain recreated, %u render passes created in %u requests, %u framebuffers alive, %u created\n",
+        context->render_pass_cache->statistics.render_pass_count,
+        context->render_pass_cache->statistics.request_count,
+        context->framebuffer_cache->statistics.framebuffer_count,
+        context->framebuffer_cache->statistics.create_count);
 }
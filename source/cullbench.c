@@ -0,0 +1,354 @@
+#include <buffer.h>
+#include <commandbuffer.h>
+#include <culling.h>
+#include <device.h>
+#include <framebuffer.h>
+#include <instance.h>
+#include <offscreen.h>
+#include <pipeline.h>
+#include <renderpass.h>
+#include <shadermodule.h>
+#include <shaderreflection.h>
+#include <uniformring.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Headless benchmark for GPU-driven rendering: the culling pass followed by
+// the indirect-count draw of the visible objects, with the pipeline of the
+// application, into an offscreen image. It needs no window or surface, so it
+// runs on lavapipe. The recorded command buffer is the same for every object
+// count; only the dispatch size, draw count and GPU time grow.
+
+static const uint32_t object_counts[] = {1024, 4096, 16384, 65536, 262144, 1048576};
+static const uint32_t iteration_count = 16;
+
+static double time_get_microseconds(void) {
+    struct timespec timespec;
+    clock_gettime(CLOCK_MONOTONIC, &timespec);
+    return timespec.tv_sec * 1e6 + timespec.tv_nsec / 1e3;
+}
+
+static float random_float(const float minimum, const float maximum) {
+    return minimum + (maximum - minimum) * ((float) rand() / (float) RAND_MAX);
+}
+
+int main() {
+    const VkInstance instance = instance_create(0, NULL, 0, NULL);
+    const VkPhysicalDevice physical_device = instance_choose_physical_device(instance);
+    const VkPhysicalDeviceProperties physical_device_properties = physical_device_get_properties(physical_device);
+    const VkPhysicalDeviceMemoryProperties physical_device_memory_properties = physical_device_get_memory_properties(physical_device);
+    const uint32_t queue_family_index = physical_device_find_queue_family_index(physical_device, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT);
+
+    // The culled commands carry the object index as first instance and are
+    // drawn with a single indirect-count draw.
+    const VkPhysicalDeviceFeatures supported_features = physical_device_get_features(physical_device);
+    const VkPhysicalDeviceVulkan12Features supported_vulkan_12_features = physical_device_get_vulkan_12_features(physical_device);
+
+    if (!supported_features.multiDrawIndirect || !supported_features.drawIndirectFirstInstance || !supported_vulkan_12_features.drawIndirectCount) {
+        fprintf(stderr, "error: GPU-driven draws need multiDrawIndirect, drawIndirectFirstInstance and drawIndirectCount\n");
+        exit(1);
+    }
+
+    VkPhysicalDeviceVulkan12Features enabled_vulkan_12_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+        .pNext = NULL,
+        .drawIndirectCount = VK_TRUE
+    };
+
+    VkPhysicalDeviceFeatures2 enabled_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &enabled_vulkan_12_features,
+        .features.drawIndirectFirstInstance = VK_TRUE,
+        .features.multiDrawIndirect = VK_TRUE
+    };
+
+    const VkDevice device = device_create(physical_device, queue_family_index, 0, NULL, &enabled_features);
+    const VkQueue queue = device_get_queue(device, queue_family_index);
+
+    printf("info: benchmarking culling on %s\n", physical_device_properties.deviceName);
+
+    const uint32_t object_capacity = object_counts[(sizeof object_counts) / (sizeof *object_counts) - 1];
+
+    const VkShaderModule compute_shader_module = shader_module_create(device, "cull");
+    struct culling *culling = culling_create(device, VK_NULL_HANDLE, physical_device_memory_properties, compute_shader_module, object_capacity);
+    vkDestroyShaderModule(device, compute_shader_module, NULL);
+
+    //
+    // The scene pipeline of the application, drawing into an offscreen image.
+
+    const VkFormat color_format = VK_FORMAT_R8G8B8A8_UNORM;
+    const VkExtent2D extent = {.width = 1280, .height = 720};
+
+    struct shader_module_cache *shader_module_cache = shader_module_cache_create(device);
+    struct shader_module *vertex_shader_module = shader_module_cache_acquire(shader_module_cache, "vert");
+    struct shader_module *fragment_shader_module = shader_module_cache_acquire(shader_module_cache, "frag");
+
+    const struct shader_reflection *const shader_reflections[] = {&vertex_shader_module->reflection, &fragment_shader_module->reflection};
+    struct shader_reflection_layout shader_reflection_layout;
+    shader_reflection_merge_layout(shader_reflections, 2, &shader_reflection_layout);
+
+    const VkDescriptorSetLayout descriptor_set_layout = shader_reflection_layout_create_descriptor_set_layout(device, &shader_reflection_layout, 0, VK_TRUE);
+    const VkPipelineLayout pipeline_layout = pipeline_layout_create(device, 1, &descriptor_set_layout, shader_reflection_layout.push_constant_range_count, &shader_reflection_layout.push_constant_range);
+    struct uniform_ring *uniform_ring = uniform_ring_create(device, descriptor_set_layout, physical_device_properties, physical_device_memory_properties, 1, 1024U, 256U);
+
+    const VkSurfaceFormatKHR surface_format = {.format = color_format, .colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR};
+    const VkRenderPass render_pass = render_pass_create(device, surface_format, VK_FORMAT_UNDEFINED, VK_SAMPLE_COUNT_1_BIT);
+
+    struct offscreen_images *offscreen_images = offscreen_images_create(device, physical_device_memory_properties, color_format, extent, 1);
+    const VkFramebuffer framebuffer = framebuffer_create(device, render_pass, 1, offscreen_images->image_views, extent);
+
+    struct graphics_pipeline_description graphics_pipeline_description;
+    graphics_pipeline_description_init(&graphics_pipeline_description);
+    graphics_pipeline_description_set_shaders(&graphics_pipeline_description, vertex_shader_module, fragment_shader_module);
+    graphics_pipeline_description_set_vertex_input(&graphics_pipeline_description, &vertex_shader_module->reflection);
+    graphics_pipeline_description.pipeline_layout = pipeline_layout;
+    graphics_pipeline_description.render_pass = render_pass;
+    graphics_pipeline_description.subpass = 0;
+
+    const VkPipeline graphics_pipeline = graphics_pipeline_create(device, VK_NULL_HANDLE, &graphics_pipeline_description);
+
+    shader_module_cache_release(shader_module_cache, vertex_shader_module);
+    shader_module_cache_release(shader_module_cache, fragment_shader_module);
+
+    // Every object is a small quad (position, color), so the draws cost little
+    // rasterization and the time goes to processing the commands.
+    const float vertices[] = {
+        -0.01f, -0.01f, 1.0f, 1.0f, 1.0f,
+        0.01f, -0.01f, 1.0f, 1.0f, 1.0f,
+        0.01f, 0.01f, 1.0f, 1.0f, 1.0f,
+        -0.01f, 0.01f, 1.0f, 1.0f, 1.0f
+    };
+
+    const uint16_t indices[] = {0, 1, 2, 2, 3, 0};
+
+    const VkMemoryPropertyFlags host_memory_property_flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+    const VkBuffer vertex_buffer = buffer_create(device, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, sizeof vertices);
+    const VkDeviceMemory vertex_buffer_device_memory = buffer_allocate_device_memory(vertex_buffer, device, physical_device_memory_properties, host_memory_property_flags);
+    buffer_upload_data(vertex_buffer, device, vertex_buffer_device_memory, sizeof vertices, vertices);
+
+    const VkBuffer index_buffer = buffer_create(device, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, sizeof indices);
+    const VkDeviceMemory index_buffer_device_memory = buffer_allocate_device_memory(index_buffer, device, physical_device_memory_properties, host_memory_property_flags);
+    buffer_upload_data(index_buffer, device, index_buffer_device_memory, sizeof indices, indices);
+
+    const float tint[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    uniform_ring_begin_frame(uniform_ring, 0);
+    const uint32_t dynamic_offset = uniform_ring_push(uniform_ring, tint, sizeof tint);
+
+    const float transform[16] = {
+        1.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 1.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 1.0f, 0.0f,
+        0.0f, 0.0f, 0.0f, 1.0f
+    };
+
+    const VkCommandPool command_pool = command_pool_create(device, queue_family_index);
+    VkCommandBuffer *command_buffers = command_buffers_allocate(device, command_pool, 1);
+
+    const VkQueryPoolCreateInfo query_pool_create_info = {
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .pNext = NULL,
+        .flags = 0,
+        .queryType = VK_QUERY_TYPE_TIMESTAMP,
+        .queryCount = 3,
+        .pipelineStatistics = 0
+    };
+
+    VkQueryPool query_pool = VK_NULL_HANDLE;
+    VkResult result = vkCreateQueryPool(device, &query_pool_create_info, NULL, &query_pool);
+
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "error: failed to create query pool\n");
+        exit(1);
+    }
+
+    const VkFenceCreateInfo fence_create_info = {
+        .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+        .pNext = NULL,
+        .flags = 0
+    };
+
+    VkFence fence = VK_NULL_HANDLE;
+    result = vkCreateFence(device, &fence_create_info, NULL, &fence);
+
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "error: failed to create fence\n");
+        exit(1);
+    }
+
+    //
+    // Perspective camera at the origin looking down -z, column-major, [0, 1] depth.
+
+    const float field_of_view = 1.0471975512f;
+    const float near = 0.1f;
+    const float far = 100.0f;
+    const float focal_length = 1.0f / tanf(field_of_view / 2.0f);
+
+    const float view_projection[16] = {
+        focal_length, 0.0f, 0.0f, 0.0f,
+        0.0f, focal_length, 0.0f, 0.0f,
+        0.0f, 0.0f, far / (near - far), -1.0f,
+        0.0f, 0.0f, near * far / (near - far), 0.0f
+    };
+
+    float frustum_planes[6][4];
+    culling_extract_frustum_planes(view_projection, frustum_planes);
+
+    struct culling_object *objects = malloc(object_capacity * (sizeof *objects));
+    srand(1);
+
+    for (uint32_t object_index = 0U; object_index < object_capacity; ++object_index) {
+        objects[object_index] = (struct culling_object) {
+            .bounding_sphere = {random_float(-100.0f, 100.0f), random_float(-100.0f, 100.0f), random_float(-100.0f, 100.0f), random_float(0.5f, 2.0f)},
+            .index_count = 6,
+            .first_index = 0,
+            .vertex_offset = 0,
+            .padding = 0
+        };
+    }
+
+    printf("%10s %10s %14s %12s %12s %12s\n", "objects", "visible", "record (us)", "cull (us)", "draw (us)", "gpu (us)");
+
+    for (uint32_t count_index = 0U; count_index < (sizeof object_counts) / (sizeof *object_counts); ++count_index) {
+        const uint32_t object_count = object_counts[count_index];
+        culling_set_objects(culling, objects, object_count);
+
+        double record_time = 0.0;
+        double cull_time = 0.0;
+        double draw_time = 0.0;
+
+        for (uint32_t iteration = 0U; iteration < iteration_count; ++iteration) {
+            const double record_start_time = time_get_microseconds();
+
+            const VkCommandBufferBeginInfo command_buffer_begin_info = {
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                .pNext = NULL,
+                .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+                .pInheritanceInfo = NULL
+            };
+
+            vkResetCommandBuffer(command_buffers[0], 0);
+            vkBeginCommandBuffer(command_buffers[0], &command_buffer_begin_info);
+            vkCmdResetQueryPool(command_buffers[0], query_pool, 0, 3);
+            vkCmdWriteTimestamp(command_buffers[0], VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, query_pool, 0);
+            culling_record_dispatch(command_buffers[0], culling, frustum_planes);
+            vkCmdWriteTimestamp(command_buffers[0], VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, query_pool, 1);
+
+            // The render pass expects its attachment in the attachment layout,
+            // the previous content is not needed.
+            const VkImageMemoryBarrier image_memory_barrier = {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                .pNext = NULL,
+                .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                .newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image = offscreen_images->images[0],
+                .subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .subresourceRange.baseMipLevel = 0,
+                .subresourceRange.levelCount = 1,
+                .subresourceRange.baseArrayLayer = 0,
+                .subresourceRange.layerCount = 1
+            };
+
+            vkCmdPipelineBarrier(command_buffers[0], VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, 0, NULL, 0, NULL, 1, &image_memory_barrier);
+
+            const VkClearValue clear_value = {.color.float32 = {0.0f, 0.0f, 0.0f, 1.0f}};
+
+            const VkRenderPassBeginInfo render_pass_begin_info = {
+                .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+                .pNext = NULL,
+                .renderPass = render_pass,
+                .framebuffer = framebuffer,
+                .renderArea.offset = {0, 0},
+                .renderArea.extent = extent,
+                .clearValueCount = 1,
+                .pClearValues = &clear_value
+            };
+
+            const VkViewport viewport = {
+                .x = 0.0f,
+                .y = 0.0f,
+                .width = (float) extent.width,
+                .height = (float) extent.height,
+                .minDepth = 0.0f,
+                .maxDepth = 1.0f
+            };
+
+            const VkRect2D scissor = {.offset = {0, 0}, .extent = extent};
+            const VkDeviceSize vertex_buffer_offset = 0;
+
+            vkCmdBeginRenderPass(command_buffers[0], &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
+            vkCmdSetViewport(command_buffers[0], 0, 1, &viewport);
+            vkCmdSetScissor(command_buffers[0], 0, 1, &scissor);
+            vkCmdBindPipeline(command_buffers[0], VK_PIPELINE_BIND_POINT_GRAPHICS, graphics_pipeline);
+            vkCmdBindDescriptorSets(command_buffers[0], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, 1, &uniform_ring->descriptor_set, 1, &dynamic_offset);
+            vkCmdPushConstants(command_buffers[0], pipeline_layout, shader_reflection_layout.push_constant_range.stageFlags, 0, sizeof transform, transform);
+            vkCmdBindVertexBuffers(command_buffers[0], 0, 1, &vertex_buffer, &vertex_buffer_offset);
+            vkCmdBindIndexBuffer(command_buffers[0], index_buffer, 0, VK_INDEX_TYPE_UINT16);
+            culling_record_draw(command_buffers[0], culling);
+            vkCmdEndRenderPass(command_buffers[0]);
+
+            vkCmdWriteTimestamp(command_buffers[0], VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, query_pool, 2);
+            vkEndCommandBuffer(command_buffers[0]);
+
+            record_time += time_get_microseconds() - record_start_time;
+
+            const VkSubmitInfo submit_info = {
+                .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                .pNext = NULL,
+                .waitSemaphoreCount = 0,
+                .pWaitSemaphores = NULL,
+                .pWaitDstStageMask = NULL,
+                .commandBufferCount = 1,
+                .pCommandBuffers = &command_buffers[0],
+                .signalSemaphoreCount = 0,
+                .pSignalSemaphores = NULL
+            };
+
+            result = vkQueueSubmit(queue, 1, &submit_info, fence);
+
+            if (result != VK_SUCCESS) {
+                fprintf(stderr, "error: failed to submit to queue\n");
+                exit(1);
+            }
+
+            vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+            vkResetFences(device, 1, &fence);
+
+            uint64_t timestamps[3] = {0, 0, 0};
+            vkGetQueryPoolResults(device, query_pool, 0, 3, sizeof timestamps, timestamps, sizeof *timestamps, VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+            cull_time += (timestamps[1] - timestamps[0]) * physical_device_properties.limits.timestampPeriod / 1e3;
+            draw_time += (timestamps[2] - timestamps[1]) * physical_device_properties.limits.timestampPeriod / 1e3;
+        }
+
+        printf("%10u %10u %14.2f %12.2f %12.2f %12.2f\n", object_count, *culling->draw_count, record_time / iteration_count,
+            cull_time / iteration_count, draw_time / iteration_count, (cull_time + draw_time) / iteration_count);
+    }
+
+    free(objects);
+    vkDestroyFence(device, fence, NULL);
+    vkDestroyQueryPool(device, query_pool, NULL);
+    command_buffers_free(device, command_pool, command_buffers, 1);
+    command_pool_destroy(device, command_pool);
+    buffer_free_memory(device, index_buffer_device_memory);
+    buffer_destroy(device, index_buffer);
+    buffer_free_memory(device, vertex_buffer_device_memory);
+    buffer_destroy(device, vertex_buffer);
+    pipeline_destroy(device, graphics_pipeline);
+    framebuffer_destroy(device, framebuffer);
+    offscreen_images_destroy(device, offscreen_images);
+    render_pass_destroy(render_pass, device);
+    uniform_ring_destroy(device, uniform_ring);
+    pipeline_layout_destroy(pipeline_layout, device);
+    vkDestroyDescriptorSetLayout(device, descriptor_set_layout, NULL);
+    shader_module_cache_destroy(shader_module_cache);
+    culling_destroy(device, culling);
+    device_destroy(device);
+    instance_destroy(instance);
+}
@@ -0,0 +1,267 @@
+#include <culling.h>
+
+#include <buffer.h>
+#include <pipeline.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CULLING_WORKGROUP_SIZE 64U
+
+static void *culling_map_memory(const VkDevice device, const VkDeviceMemory device_memory, const VkDeviceSize size) {
+    void *mapped_data = NULL;
+    VkResult result = vkMapMemory(device, device_memory, 0, size, 0, &mapped_data);
+
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "error: failed to map culling buffer memory\n");
+        exit(1);
+    }
+
+    return mapped_data;
+}
+
+struct culling *culling_create(
+    const VkDevice device,
+    const VkPipelineCache pipeline_cache,
+    const VkPhysicalDeviceMemoryProperties physical_device_memory_properties,
+    const VkShaderModule compute_shader_module,
+    const uint32_t object_capacity
+) {
+    struct culling *culling = malloc(sizeof *culling);
+    culling->object_capacity = object_capacity;
+    culling->object_count = 0;
+
+    //
+    // Buffers. Objects and the draw count are written and read by the host,
+    // the compacted draw commands never leave the device.
+
+    const uint32_t object_buffer_size = object_capacity * sizeof (struct culling_object);
+    culling->object_buffer = buffer_create(device, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, object_buffer_size);
+    culling->object_buffer_device_memory = buffer_allocate_device_memory(culling->object_buffer, device, physical_device_memory_properties, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    culling->objects = culling_map_memory(device, culling->object_buffer_device_memory, object_buffer_size);
+
+    const uint32_t draw_command_buffer_size = object_capacity * sizeof (VkDrawIndexedIndirectCommand);
+    culling->draw_command_buffer = buffer_create(device, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, draw_command_buffer_size);
+    culling->draw_command_buffer_device_memory = buffer_allocate_device_memory(culling->draw_command_buffer, device, physical_device_memory_properties, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    const uint32_t draw_count_buffer_size = sizeof (uint32_t);
+    culling->draw_count_buffer = buffer_create(device, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, draw_count_buffer_size);
+    culling->draw_count_buffer_device_memory = buffer_allocate_device_memory(culling->draw_count_buffer, device, physical_device_memory_properties, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    culling->draw_count = culling_map_memory(device, culling->draw_count_buffer_device_memory, draw_count_buffer_size);
+
+    //
+    // Descriptors.
+
+    const VkDescriptorSetLayoutBinding descriptor_set_layout_bindings[] = {
+        {
+            .binding = 0,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = NULL
+        },
+        {
+            .binding = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = NULL
+        },
+        {
+            .binding = 2,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = NULL
+        }
+    };
+
+    const VkDescriptorSetLayoutCreateInfo descriptor_set_layout_create_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = NULL,
+        .flags = 0,
+        .bindingCount = 3,
+        .pBindings = descriptor_set_layout_bindings
+    };
+
+    VkResult result = vkCreateDescriptorSetLayout(device, &descriptor_set_layout_create_info, NULL, &culling->descriptor_set_layout);
+
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "error: failed to create culling descriptor set layout\n");
+        exit(1);
+    }
+
+    const VkDescriptorPoolSize descriptor_pool_size = {
+        .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .descriptorCount = 3
+    };
+
+    const VkDescriptorPoolCreateInfo descriptor_pool_create_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .pNext = NULL,
+        .flags = 0,
+        .maxSets = 1,
+        .poolSizeCount = 1,
+        .pPoolSizes = &descriptor_pool_size
+    };
+
+    result = vkCreateDescriptorPool(device, &descriptor_pool_create_info, NULL, &culling->descriptor_pool);
+
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "error: failed to create culling descriptor pool\n");
+        exit(1);
+    }
+
+    const VkDescriptorSetAllocateInfo descriptor_set_allocate_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .pNext = NULL,
+        .descriptorPool = culling->descriptor_pool,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &culling->descriptor_set_layout
+    };
+
+    result = vkAllocateDescriptorSets(device, &descriptor_set_allocate_info, &culling->descriptor_set);
+
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "error: failed to allocate culling descriptor set\n");
+        exit(1);
+    }
+
+    const VkDescriptorBufferInfo descriptor_buffer_infos[] = {
+        {.buffer = culling->object_buffer, .offset = 0, .range = VK_WHOLE_SIZE},
+        {.buffer = culling->draw_command_buffer, .offset = 0, .range = VK_WHOLE_SIZE},
+        {.buffer = culling->draw_count_buffer, .offset = 0, .range = VK_WHOLE_SIZE}
+    };
+
+    VkWriteDescriptorSet write_descriptor_sets[3];
+
+    for (uint32_t binding = 0U; binding < 3U; ++binding) {
+        write_descriptor_sets[binding] = (VkWriteDescriptorSet) {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .pNext = NULL,
+            .dstSet = culling->descriptor_set,
+            .dstBinding = binding,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pImageInfo = NULL,
+            .pBufferInfo = &descriptor_buffer_infos[binding],
+            .pTexelBufferView = NULL
+        };
+    }
+
+    vkUpdateDescriptorSets(device, 3, write_descriptor_sets, 0, NULL);
+
+    //
+    // Pipeline.
+
+    const VkPushConstantRange push_constant_range = {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = sizeof (struct culling_push_constants)
+    };
+
+    culling->pipeline_layout = pipeline_layout_create(device, 1, &culling->descriptor_set_layout, 1, &push_constant_range);
+    culling->pipeline = compute_pipeline_create(device, pipeline_cache, compute_shader_module, culling->pipeline_layout);
+
+    return culling;
+}
+
+void culling_destroy(const VkDevice device, struct culling *culling) {
+    pipeline_destroy(device, culling->pipeline);
+    pipeline_layout_destroy(culling->pipeline_layout, device);
+    vkDestroyDescriptorPool(device, culling->descriptor_pool, NULL);
+    vkDestroyDescriptorSetLayout(device, culling->descriptor_set_layout, NULL);
+    vkUnmapMemory(device, culling->draw_count_buffer_device_memory);
+    buffer_destroy(device, culling->draw_count_buffer);
+    buffer_free_memory(device, culling->draw_count_buffer_device_memory);
+    buffer_destroy(device, culling->draw_command_buffer);
+    buffer_free_memory(device, culling->draw_command_buffer_device_memory);
+    vkUnmapMemory(device, culling->object_buffer_device_memory);
+    buffer_destroy(device, culling->object_buffer);
+    buffer_free_memory(device, culling->object_buffer_device_memory);
+    free(culling);
+}
+
+void culling_set_objects(struct culling *culling, const struct culling_object *const objects, const uint32_t object_count) {
+    if (object_count > culling->object_capacity) {
+        fprintf(stderr, "error: culling object count exceeds its capacity\n");
+        exit(1);
+    }
+
+    memcpy(culling->objects, objects, object_count * sizeof *objects);
+    culling->object_count = object_count;
+}
+
+// Gribb and Hartmann plane extraction from a column-major view-projection
+// matrix with a [0, 1] depth range.
+void culling_extract_frustum_planes(const float view_projection[16], float frustum_planes[6][4]) {
+    const float *const m = view_projection;
+
+    for (uint32_t component = 0U; component < 4U; ++component) {
+        const float row_x = m[component * 4 + 0];
+        const float row_y = m[component * 4 + 1];
+        const float row_z = m[component * 4 + 2];
+        const float row_w = m[component * 4 + 3];
+
+        frustum_planes[0][component] = row_w + row_x;
+        frustum_planes[1][component] = row_w - row_x;
+        frustum_planes[2][component] = row_w + row_y;
+        frustum_planes[3][component] = row_w - row_y;
+        frustum_planes[4][component] = row_z;
+        frustum_planes[5][component] = row_w - row_z;
+    }
+
+    for (uint32_t plane_index = 0U; plane_index < 6U; ++plane_index) {
+        float *const plane = frustum_planes[plane_index];
+        const float length = sqrtf(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+
+        if (length > 0.0f) {
+            plane[0] /= length;
+            plane[1] /= length;
+            plane[2] /= length;
+            plane[3] /= length;
+        }
+    }
+}
+
+// Must be recorded outside of a render pass. The recorded commands do not
+// depend on the object count, it is passed through push constants.
+void culling_record_dispatch(const VkCommandBuffer command_buffer, const struct culling *const culling, const float frustum_planes[6][4]) {
+    vkCmdFillBuffer(command_buffer, culling->draw_count_buffer, 0, sizeof (uint32_t), 0U);
+
+    const VkMemoryBarrier fill_memory_barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .pNext = NULL,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+    };
+
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &fill_memory_barrier, 0, NULL, 0, NULL);
+
+    struct culling_push_constants push_constants;
+    memcpy(push_constants.frustum_planes, frustum_planes, sizeof push_constants.frustum_planes);
+    push_constants.object_count = culling->object_count;
+
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, culling->pipeline);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, culling->pipeline_layout, 0, 1, &culling->descriptor_set, 0, NULL);
+    vkCmdPushConstants(command_buffer, culling->pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof push_constants, &push_constants);
+    vkCmdDispatch(command_buffer, (culling->object_count + CULLING_WORKGROUP_SIZE - 1U) / CULLING_WORKGROUP_SIZE, 1, 1);
+
+    const VkMemoryBarrier dispatch_memory_barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .pNext = NULL,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_HOST_READ_BIT
+    };
+
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &dispatch_memory_barrier, 0, NULL, 0, NULL);
+}
+
+// Expects the graphics pipeline, vertex buffer and index buffer to be bound.
+// Requires the drawIndirectCount feature.
+void culling_record_draw(const VkCommandBuffer command_buffer, const struct culling *const culling) {
+    vkCmdDrawIndexedIndirectCount(command_buffer, culling->draw_command_buffer, 0, culling->draw_count_buffer, 0, culling->object_capacity, sizeof (VkDrawIndexedIndirectCommand));
+}
@@ -0,0 +1,160 @@
+#include <deferredlighting.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+struct deferred_lighting *deferred_lighting_create(
+    const VkDevice device,
+    struct shader_module_cache *shader_module_cache,
+    struct pipeline_compiler *pipeline_compiler,
+    const VkRenderPass render_pass
+) {
+    struct deferred_lighting *deferred_lighting = malloc(sizeof *deferred_lighting);
+
+    deferred_lighting->device = device;
+    deferred_lighting->shader_module_cache = shader_module_cache;
+    deferred_lighting->vertex_shader_module = shader_module_cache_acquire(shader_module_cache, "fullscreen");
+    deferred_lighting->fragment_shader_module = shader_module_cache_acquire(shader_module_cache, "lighting");
+
+    const struct shader_reflection *const shader_reflections[] = {
+        &deferred_lighting->vertex_shader_module->reflection,
+        &deferred_lighting->fragment_shader_module->reflection
+    };
+
+    struct shader_reflection_layout *shader_reflection_layout = &deferred_lighting->shader_reflection_layout;
+    shader_reflection_merge_layout(shader_reflections, 2, shader_reflection_layout);
+
+    const struct shader_reflection_binding *const albedo_binding = shader_reflection_layout_find_binding(shader_reflection_layout, 0, 0);
+    const struct shader_reflection_binding *const depth_binding = shader_reflection_layout_find_binding(shader_reflection_layout, 0, 1);
+
+    if (shader_reflection_layout->set_count != 1 || shader_reflection_layout->binding_count != 2 ||
+        albedo_binding == NULL || albedo_binding->descriptor_type != VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT ||
+        depth_binding == NULL || depth_binding->descriptor_type != VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT) {
+        fprintf(stderr, "error: lighting shaders must read two input attachments at set 0 bindings 0 and 1\n");
+        exit(1);
+    }
+
+    deferred_lighting->descriptor_set_layout = shader_reflection_layout_create_descriptor_set_layout(device, shader_reflection_layout, 0, VK_FALSE);
+    deferred_lighting->pipeline_layout = pipeline_layout_create(device, 1, &deferred_lighting->descriptor_set_layout, shader_reflection_layout->push_constant_range_count, &shader_reflection_layout->push_constant_range);
+
+    const VkDescriptorPoolSize descriptor_pool_size = {
+        .type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT,
+        .descriptorCount = 2
+    };
+
+    const VkDescriptorPoolCreateInfo descriptor_pool_create_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .pNext = NULL,
+        .flags = 0,
+        .maxSets = 1,
+        .poolSizeCount = 1,
+        .pPoolSizes = &descriptor_pool_size
+    };
+
+    VkResult result = vkCreateDescriptorPool(device, &descriptor_pool_create_info, NULL, &deferred_lighting->descriptor_pool);
+
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "error: failed to create deferred lighting descriptor pool\n");
+        exit(1);
+    }
+
+    const VkDescriptorSetAllocateInfo descriptor_set_allocate_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .pNext = NULL,
+        .descriptorPool = deferred_lighting->descriptor_pool,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &deferred_lighting->descriptor_set_layout
+    };
+
+    result = vkAllocateDescriptorSets(device, &descriptor_set_allocate_info, &deferred_lighting->descriptor_set);
+
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "error: failed to allocate deferred lighting descriptor set\n");
+        exit(1);
+    }
+
+    struct graphics_pipeline_description *description = &deferred_lighting->pipeline_description;
+    graphics_pipeline_description_init(description);
+    graphics_pipeline_description_set_shaders(description, deferred_lighting->vertex_shader_module, deferred_lighting->fragment_shader_module);
+    description->pipeline_layout = deferred_lighting->pipeline_layout;
+    description->render_pass = render_pass;
+    description->subpass = 1;
+
+    deferred_lighting->dynamic_state = graphics_pipeline_description_get_dynamic_state(description);
+    deferred_lighting->pipeline_future = pipeline_compiler_request_graphics(pipeline_compiler, description);
+
+    return deferred_lighting;
+}
+
+void deferred_lighting_destroy(struct deferred_lighting *deferred_lighting) {
+    shader_module_cache_release(deferred_lighting->shader_module_cache, deferred_lighting->fragment_shader_module);
+    shader_module_cache_release(deferred_lighting->shader_module_cache, deferred_lighting->vertex_shader_module);
+    vkDestroyDescriptorPool(deferred_lighting->device, deferred_lighting->descriptor_pool, NULL);
+    pipeline_layout_destroy(deferred_lighting->pipeline_layout, deferred_lighting->device);
+    vkDestroyDescriptorSetLayout(deferred_lighting->device, deferred_lighting->descriptor_set_layout, NULL);
+    free(deferred_lighting);
+}
+
+void deferred_lighting_set_gbuffer(
+    struct deferred_lighting *deferred_lighting,
+    const VkImageView albedo_image_view,
+    const VkImageView depth_image_view
+) {
+    // The layouts the lighting subpass reads them in.
+    const VkDescriptorImageInfo descriptor_image_infos[] = {
+        {.sampler = VK_NULL_HANDLE, .imageView = albedo_image_view, .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
+        {.sampler = VK_NULL_HANDLE, .imageView = depth_image_view, .imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL}
+    };
+
+    VkWriteDescriptorSet write_descriptor_sets[2];
+
+    for (uint32_t binding = 0U; binding < 2U; ++binding) {
+        write_descriptor_sets[binding] = (VkWriteDescriptorSet) {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .pNext = NULL,
+            .dstSet = deferred_lighting->descriptor_set,
+            .dstBinding = binding,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT,
+            .pImageInfo = &descriptor_image_infos[binding],
+            .pBufferInfo = NULL,
+            .pTexelBufferView = NULL
+        };
+    }
+
+    vkUpdateDescriptorSets(deferred_lighting->device, 2, write_descriptor_sets, 0, NULL);
+}
+
+bool deferred_lighting_shaders_compatible(
+    const struct deferred_lighting *const deferred_lighting,
+    const struct shader_module *const vertex_shader_module,
+    const struct shader_module *const fragment_shader_module
+) {
+    const struct shader_reflection *const reloaded_reflections[] = {
+        &vertex_shader_module->reflection,
+        &fragment_shader_module->reflection
+    };
+
+    struct shader_reflection_layout reloaded_layout;
+    char message[128];
+
+    if (!shader_reflection_try_merge_layout(reloaded_reflections, 2, &reloaded_layout, message, sizeof message)) {
+        fprintf(stderr, "warning: %s\n", message);
+        return false;
+    }
+
+    return shader_reflection_layouts_equal(&deferred_lighting->shader_reflection_layout, &reloaded_layout);
+}
+
+void deferred_lighting_record(const struct deferred_lighting *const deferred_lighting, const VkCommandBuffer command_buffer) {
+    const VkPipeline pipeline = pipeline_future_get(deferred_lighting->pipeline_future, VK_NULL_HANDLE);
+
+    if (pipeline == VK_NULL_HANDLE) {
+        return;
+    }
+
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, deferred_lighting->pipeline_layout, 0, 1, &deferred_lighting->descriptor_set, 0, NULL);
+    vkCmdDraw(command_buffer, 3, 1, 0, 0);
+}
@@ -3,12 +3,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 
-VkDevice device_create(const VkPhysicalDevice physical_device, const uint32_t queue_family_index) {
+VkDevice device_create(
+    const VkPhysicalDevice physical_device,
+    const uint32_t queue_family_index,
+    const uint32_t device_extension_count,
+    const char *const *const device_extension_names,
+    const void *const enabled_features
+) {
     const float queue_priorities[1] = {1.0f};
 
-    const uint32_t device_extension_count = 1;
-    const char *const device_extension_names[] = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
-
     // TODO Create multiple queues from multiple queue families.
 
     const VkDeviceQueueCreateInfo device_queue_create_info = {
@@ -20,9 +23,11 @@ VkDevice device_create(const VkPhysicalDevice physical_device, const uint32_t qu
         .pQueuePriorities = queue_priorities
     };
 
+    // Features are passed as a VkPhysicalDeviceFeatures2 chain, so
+    // pEnabledFeatures has to stay NULL.
     const VkDeviceCreateInfo device_create_info = {
         .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-        .pNext = NULL,
+        .pNext = enabled_features,
         .flags = 0,
         .queueCreateInfoCount = 1,
         .pQueueCreateInfos = &device_queue_create_info,
@@ -54,3 +59,17 @@ VkQueue device_get_queue(const VkDevice device, const uint32_t queue_family_inde
     vkGetDeviceQueue(device, queue_family_index, 0, &queue);
     return queue;
 }
+
+uint32_t device_find_memory_type_index(
+    const VkPhysicalDeviceMemoryProperties physical_device_memory_properties,
+    const uint32_t memory_type_bits,
+    const VkMemoryPropertyFlags memory_property_flags
+) {
+    for (uint32_t memory_type_index = 0U; memory_type_index < physical_device_memory_properties.memoryTypeCount; ++memory_type_index) {
+        if ((memory_type_bits & (1U << memory_type_index)) && (physical_device_memory_properties.memoryTypes[memory_type_index].propertyFlags & memory_property_flags) == memory_property_flags) {
+            return memory_type_index;
+        }
+    }
+
+    return UINT32_MAX;
+}
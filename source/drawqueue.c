@@ -0,0 +1,226 @@
+#include <drawqueue.h>
+
+#include <hash.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void draw_queue_handle_table_init(struct draw_queue_handle_table *handle_table) {
+    handle_table->capacity = 64U;
+    handle_table->count = 0U;
+    handle_table->handles = calloc(handle_table->capacity, sizeof *handle_table->handles);
+    handle_table->ids = calloc(handle_table->capacity, sizeof *handle_table->ids);
+
+    if (handle_table->handles == NULL || handle_table->ids == NULL) {
+        fprintf(stderr, "error: failed to allocate draw queue handle table\n");
+        exit(1);
+    }
+}
+
+static void draw_queue_handle_table_free(struct draw_queue_handle_table *handle_table) {
+    free(handle_table->handles);
+    free(handle_table->ids);
+}
+
+static void draw_queue_handle_table_insert(struct draw_queue_handle_table *handle_table, const uint64_t handle, const uint32_t id) {
+    uint32_t slot = (uint32_t) hash_bytes(&handle, sizeof handle, 0U) & (handle_table->capacity - 1U);
+
+    while (handle_table->handles[slot] != 0U) {
+        slot = (slot + 1U) & (handle_table->capacity - 1U);
+    }
+
+    handle_table->handles[slot] = handle;
+    handle_table->ids[slot] = id;
+}
+
+// Maps a Vulkan handle to a small dense id. Ids are stable for the lifetime of
+// the queue so the same pipeline sorts into the same bucket every frame.
+static uint32_t draw_queue_handle_table_get_id(struct draw_queue_handle_table *handle_table, const uint64_t handle) {
+    if (handle == 0U) {
+        return 0U;
+    }
+
+    uint32_t slot = (uint32_t) hash_bytes(&handle, sizeof handle, 0U) & (handle_table->capacity - 1U);
+
+    while (handle_table->handles[slot] != 0U) {
+        if (handle_table->handles[slot] == handle) {
+            return handle_table->ids[slot];
+        }
+
+        slot = (slot + 1U) & (handle_table->capacity - 1U);
+    }
+
+    if (2U * (handle_table->count + 1U) > handle_table->capacity) {
+        uint64_t *old_handles = handle_table->handles;
+        uint32_t *old_ids = handle_table->ids;
+        const uint32_t old_capacity = handle_table->capacity;
+
+        handle_table->capacity *= 2U;
+        handle_table->handles = calloc(handle_table->capacity, sizeof *handle_table->handles);
+        handle_table->ids = calloc(handle_table->capacity, sizeof *handle_table->ids);
+
+        if (handle_table->handles == NULL || handle_table->ids == NULL) {
+            fprintf(stderr, "error: failed to grow draw queue handle table\n");
+            exit(1);
+        }
+
+        for (uint32_t old_slot = 0U; old_slot < old_capacity; ++old_slot) {
+            if (old_handles[old_slot] != 0U) {
+                draw_queue_handle_table_insert(handle_table, old_handles[old_slot], old_ids[old_slot]);
+            }
+        }
+
+        free(old_handles);
+        free(old_ids);
+    }
+
+    // Id zero is reserved for VK_NULL_HANDLE.
+    const uint32_t id = ++handle_table->count;
+    draw_queue_handle_table_insert(handle_table, handle, id);
+
+    return id;
+}
+
+struct draw_queue *draw_queue_create(void) {
+    struct draw_queue *draw_queue = malloc(sizeof *draw_queue);
+
+    draw_queue->draw_count = 0U;
+    draw_queue->draw_capacity = 256U;
+    draw_queue->skipped_draw_count = 0U;
+    draw_queue->draws = malloc(draw_queue->draw_capacity * (sizeof *draw_queue->draws));
+    draw_queue->entries = malloc(draw_queue->draw_capacity * (sizeof *draw_queue->entries));
+    draw_queue->scratch_entries = malloc(draw_queue->draw_capacity * (sizeof *draw_queue->scratch_entries));
+
+    if (draw_queue->draws == NULL || draw_queue->entries == NULL || draw_queue->scratch_entries == NULL) {
+        fprintf(stderr, "error: failed to allocate draw queue\n");
+        exit(1);
+    }
+
+    draw_queue_handle_table_init(&draw_queue->pipeline_table);
+    draw_queue_handle_table_init(&draw_queue->vertex_buffer_table);
+
+    return draw_queue;
+}
+
+void draw_queue_destroy(struct draw_queue *draw_queue) {
+    draw_queue_handle_table_free(&draw_queue->vertex_buffer_table);
+    draw_queue_handle_table_free(&draw_queue->pipeline_table);
+    free(draw_queue->scratch_entries);
+    free(draw_queue->entries);
+    free(draw_queue->draws);
+    free(draw_queue);
+}
+
+void draw_queue_reset(struct draw_queue *draw_queue) {
+    draw_queue->draw_count = 0U;
+    draw_queue->skipped_draw_count = 0U;
+}
+
+uint64_t draw_queue_make_key(
+    const uint32_t pass,
+    const uint32_t pipeline_id,
+    const uint32_t material_id,
+    const uint32_t vertex_buffer_id,
+    const float depth
+) {
+    const uint64_t depth_max = (1ULL << DRAW_QUEUE_DEPTH_BITS) - 1ULL;
+    const float clamped_depth = depth < 0.0f ? 0.0f : (depth > 1.0f ? 1.0f : depth);
+    const uint64_t quantized_depth = (uint64_t) (clamped_depth * (float) depth_max);
+
+    // Ids beyond the field width wrap around. That only costs redundant binds,
+    // the recorder compares the real handles.
+    uint64_t key = pass & ((1U << DRAW_QUEUE_PASS_BITS) - 1U);
+    key = (key << DRAW_QUEUE_PIPELINE_BITS) | (pipeline_id & ((1U << DRAW_QUEUE_PIPELINE_BITS) - 1U));
+    key = (key << DRAW_QUEUE_MATERIAL_BITS) | (material_id & ((1U << DRAW_QUEUE_MATERIAL_BITS) - 1U));
+    key = (key << DRAW_QUEUE_VERTEX_BUFFER_BITS) | (vertex_buffer_id & ((1U << DRAW_QUEUE_VERTEX_BUFFER_BITS) - 1U));
+    key = (key << DRAW_QUEUE_DEPTH_BITS) | quantized_depth;
+
+    return key;
+}
+
+void draw_queue_submit(
+    struct draw_queue *draw_queue,
+    const uint32_t pass,
+    const uint32_t material_id,
+    const float depth,
+    const struct draw *const draw
+) {
+    if (draw->pipeline == VK_NULL_HANDLE) {
+        draw_queue->skipped_draw_count++;
+        return;
+    }
+
+    if (draw_queue->draw_count == draw_queue->draw_capacity) {
+        draw_queue->draw_capacity *= 2U;
+        draw_queue->draws = realloc(draw_queue->draws, draw_queue->draw_capacity * (sizeof *draw_queue->draws));
+        draw_queue->entries = realloc(draw_queue->entries, draw_queue->draw_capacity * (sizeof *draw_queue->entries));
+        draw_queue->scratch_entries = realloc(draw_queue->scratch_entries, draw_queue->draw_capacity * (sizeof *draw_queue->scratch_entries));
+
+        if (draw_queue->draws == NULL || draw_queue->entries == NULL || draw_queue->scratch_entries == NULL) {
+            fprintf(stderr, "error: failed to grow draw queue\n");
+            exit(1);
+        }
+    }
+
+    const uint32_t pipeline_id = draw_queue_handle_table_get_id(&draw_queue->pipeline_table, (uint64_t) (uintptr_t) draw->pipeline);
+    const uint32_t vertex_buffer_id = draw_queue_handle_table_get_id(&draw_queue->vertex_buffer_table, (uint64_t) (uintptr_t) draw->vertex_buffer);
+
+    const uint32_t draw_index = draw_queue->draw_count++;
+    draw_queue->draws[draw_index] = *draw;
+    draw_queue->entries[draw_index].key = draw_queue_make_key(pass, pipeline_id, material_id, vertex_buffer_id, depth);
+    draw_queue->entries[draw_index].draw_index = draw_index;
+}
+
+// Least significant digit radix sort with 8-bit digits. All eight histograms
+// are built in a single pass, and digits that are equal for every key are
+// skipped, which is common for the pass and id fields.
+void draw_queue_sort(struct draw_queue *draw_queue) {
+    const uint32_t entry_count = draw_queue->draw_count;
+
+    if (entry_count < 2U) {
+        return;
+    }
+
+    uint32_t histograms[8][256];
+    memset(histograms, 0, sizeof histograms);
+
+    for (uint32_t entry_index = 0U; entry_index < entry_count; ++entry_index) {
+        const uint64_t key = draw_queue->entries[entry_index].key;
+
+        for (uint32_t digit = 0U; digit < 8U; ++digit) {
+            histograms[digit][(key >> (8U * digit)) & 0xFFU]++;
+        }
+    }
+
+    struct draw_queue_entry *source_entries = draw_queue->entries;
+    struct draw_queue_entry *destination_entries = draw_queue->scratch_entries;
+
+    for (uint32_t digit = 0U; digit < 8U; ++digit) {
+        const uint32_t first_bucket = (source_entries[0].key >> (8U * digit)) & 0xFFU;
+
+        if (histograms[digit][first_bucket] == entry_count) {
+            continue;
+        }
+
+        uint32_t offsets[256];
+        uint32_t offset = 0U;
+
+        for (uint32_t bucket = 0U; bucket < 256U; ++bucket) {
+            offsets[bucket] = offset;
+            offset += histograms[digit][bucket];
+        }
+
+        for (uint32_t entry_index = 0U; entry_index < entry_count; ++entry_index) {
+            const uint32_t bucket = (source_entries[entry_index].key >> (8U * digit)) & 0xFFU;
+            destination_entries[offsets[bucket]++] = source_entries[entry_index];
+        }
+
+        struct draw_queue_entry *swap_entries = source_entries;
+        source_entries = destination_entries;
+        destination_entries = swap_entries;
+    }
+
+    draw_queue->entries = source_entries;
+    draw_queue->scratch_entries = destination_entries;
+}
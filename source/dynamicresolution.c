@@ -0,0 +1,156 @@
+#include <dynamicresolution.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Under this share of the target the scale is raised again, the gap keeps
+// the controller from bouncing around the target.
+static const double dynamic_resolution_headroom = 0.85;
+
+// Share of the way to the ideal scale taken per frame when raising it.
+static const float dynamic_resolution_increase_rate = 0.05f;
+
+static VkQueryPool dynamic_resolution_create_query_pool(const VkDevice device, const uint32_t slot_count) {
+    const VkQueryPoolCreateInfo query_pool_create_info = {
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .pNext = NULL,
+        .flags = 0,
+        .queryType = VK_QUERY_TYPE_TIMESTAMP,
+        .queryCount = 2U * slot_count,
+        .pipelineStatistics = 0
+    };
+
+    VkQueryPool query_pool = VK_NULL_HANDLE;
+    VkResult result = vkCreateQueryPool(device, &query_pool_create_info, NULL, &query_pool);
+
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "error: failed to create query pool\n");
+        exit(1);
+    }
+
+    return query_pool;
+}
+
+struct dynamic_resolution *dynamic_resolution_create(
+    const VkDevice device,
+    const VkPhysicalDeviceProperties physical_device_properties,
+    const uint32_t timestamp_valid_bits,
+    const uint32_t slot_count,
+    const float min_scale,
+    const float max_scale,
+    const double target_gpu_time
+) {
+    if (!physical_device_properties.limits.timestampComputeAndGraphics || timestamp_valid_bits == 0U) {
+        fprintf(stderr, "error: dynamic resolution needs timestamps on the graphics queue\n");
+        exit(1);
+    }
+
+    struct dynamic_resolution *dynamic_resolution = malloc(sizeof *dynamic_resolution);
+
+    dynamic_resolution->device = device;
+    dynamic_resolution->query_pool = dynamic_resolution_create_query_pool(device, slot_count);
+    dynamic_resolution->slot_count = slot_count;
+    dynamic_resolution->slot_pending = calloc(slot_count, sizeof *dynamic_resolution->slot_pending);
+    dynamic_resolution->timestamp_period = physical_device_properties.limits.timestampPeriod;
+    dynamic_resolution->timestamp_mask = timestamp_valid_bits >= 64U ? UINT64_MAX : (UINT64_C(1) << timestamp_valid_bits) - 1U;
+    dynamic_resolution->min_scale = min_scale;
+    dynamic_resolution->max_scale = max_scale;
+    dynamic_resolution->scale = max_scale;
+    dynamic_resolution->target_gpu_time = target_gpu_time;
+    dynamic_resolution->gpu_time = 0.0;
+    dynamic_resolution->statistics = (struct dynamic_resolution_statistics) {0};
+
+    return dynamic_resolution;
+}
+
+void dynamic_resolution_destroy(struct dynamic_resolution *dynamic_resolution) {
+    vkDestroyQueryPool(dynamic_resolution->device, dynamic_resolution->query_pool, NULL);
+    free(dynamic_resolution->slot_pending);
+    free(dynamic_resolution);
+}
+
+void dynamic_resolution_resize(struct dynamic_resolution *dynamic_resolution, const uint32_t slot_count) {
+    vkDestroyQueryPool(dynamic_resolution->device, dynamic_resolution->query_pool, NULL);
+    free(dynamic_resolution->slot_pending);
+
+    dynamic_resolution->query_pool = dynamic_resolution_create_query_pool(dynamic_resolution->device, slot_count);
+    dynamic_resolution->slot_count = slot_count;
+    dynamic_resolution->slot_pending = calloc(slot_count, sizeof *dynamic_resolution->slot_pending);
+}
+
+void dynamic_resolution_update(struct dynamic_resolution *dynamic_resolution, const uint32_t slot) {
+    if (!dynamic_resolution->slot_pending[slot]) {
+        return;
+    }
+
+    dynamic_resolution->slot_pending[slot] = false;
+
+    uint64_t timestamps[2] = {0, 0};
+    VkResult result = vkGetQueryPoolResults(dynamic_resolution->device, dynamic_resolution->query_pool, 2U * slot, 2, sizeof timestamps, timestamps, sizeof *timestamps, VK_QUERY_RESULT_64_BIT);
+
+    if (result == VK_NOT_READY) {
+        return;
+    }
+
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "error: failed to get query pool results\n");
+        exit(1);
+    }
+
+    const uint64_t begin = timestamps[0] & dynamic_resolution->timestamp_mask;
+    const uint64_t end = timestamps[1] & dynamic_resolution->timestamp_mask;
+
+    if (end < begin) {
+        return;
+    }
+
+    const double gpu_time = (end - begin) * dynamic_resolution->timestamp_period / 1e6;
+
+    dynamic_resolution->gpu_time = gpu_time;
+    dynamic_resolution->statistics.sample_count++;
+
+    if (gpu_time <= 0.0) {
+        return;
+    }
+
+    // GPU time grows with the pixel count, which is the square of the scale.
+    const float ideal_scale = dynamic_resolution->scale * (float) sqrt(dynamic_resolution->target_gpu_time / gpu_time);
+    float scale = dynamic_resolution->scale;
+
+    if (gpu_time > dynamic_resolution->target_gpu_time) {
+        scale = ideal_scale;
+    } else if (gpu_time < dynamic_resolution->target_gpu_time * dynamic_resolution_headroom) {
+        scale += (ideal_scale - scale) * dynamic_resolution_increase_rate;
+    }
+
+    scale = fminf(fmaxf(scale, dynamic_resolution->min_scale), dynamic_resolution->max_scale);
+
+    if (scale < dynamic_resolution->scale) {
+        dynamic_resolution->statistics.scale_decrease_count++;
+    } else if (scale > dynamic_resolution->scale) {
+        dynamic_resolution->statistics.scale_increase_count++;
+    }
+
+    dynamic_resolution->scale = scale;
+}
+
+void dynamic_resolution_record_begin(const struct dynamic_resolution *dynamic_resolution, const VkCommandBuffer command_buffer, const uint32_t slot) {
+    vkCmdResetQueryPool(command_buffer, dynamic_resolution->query_pool, 2U * slot, 2);
+    vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dynamic_resolution->query_pool, 2U * slot);
+}
+
+void dynamic_resolution_record_end(struct dynamic_resolution *dynamic_resolution, const VkCommandBuffer command_buffer, const uint32_t slot) {
+    vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, dynamic_resolution->query_pool, 2U * slot + 1U);
+    dynamic_resolution->slot_pending[slot] = true;
+}
+
+VkExtent2D dynamic_resolution_scale_extent(const VkExtent2D extent, const float scale) {
+    const uint32_t width = (uint32_t) (extent.width * scale);
+    const uint32_t height = (uint32_t) (extent.height * scale);
+
+    return (VkExtent2D) {
+        .width = width > 0U ? width : 1U,
+        .height = height > 0U ? height : 1U
+    };
+}
@@ -1,48 +1,165 @@
 #include <framebuffer.h>
 
+#include <hash.h>
+
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
-VkFramebuffer *framebuffers_create(
+VkFramebuffer framebuffer_create(
     const VkDevice device,
-    const VkSurfaceCapabilitiesKHR surface_capabilities,
-    const VkImageView *const image_views,
     const VkRenderPass render_pass,
-    const uint32_t swapchain_image_count
+    const uint32_t attachment_count,
+    const VkImageView *const attachments,
+    const VkExtent2D extent
 ) {
-    VkFramebuffer *framebuffers = malloc(swapchain_image_count * (sizeof *framebuffers));
-
-    for (uint32_t framebuffer_index = 0U; framebuffer_index < swapchain_image_count; ++framebuffer_index) {
-        const VkFramebufferCreateInfo framebuffer_create_info = {
-            .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-            .pNext = NULL,
-            .flags = 0,
-            .renderPass = render_pass,
-            .attachmentCount = 1,
-            .pAttachments = &image_views[framebuffer_index],
-            .width = surface_capabilities.currentExtent.width,
-            .height = surface_capabilities.currentExtent.height,
-            .layers = 1
-        };
-
-        VkResult result = vkCreateFramebuffer(device, &framebuffer_create_info, NULL, &framebuffers[framebuffer_index]);
-
-        if (result != VK_SUCCESS) {
-            fprintf(stderr, "error: failed to create framebuffer\n");
-            exit(1);
+    const VkFramebufferCreateInfo framebuffer_create_info = {
+        .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+        .pNext = NULL,
+        .flags = 0,
+        .renderPass = render_pass,
+        .attachmentCount = attachment_count,
+        .pAttachments = attachments,
+        .width = extent.width,
+        .height = extent.height,
+        .layers = 1
+    };
+
+    VkFramebuffer framebuffer;
+    VkResult result = vkCreateFramebuffer(device, &framebuffer_create_info, NULL, &framebuffer);
+
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "error: failed to create framebuffer\n");
+        exit(1);
+    }
+
+    return framebuffer;
+}
+
+void framebuffer_destroy(const VkDevice device, const VkFramebuffer framebuffer) {
+    vkDestroyFramebuffer(device, framebuffer, NULL);
+}
+
+struct framebuffer_cache *framebuffer_cache_create(const VkDevice device) {
+    struct framebuffer_cache *framebuffer_cache = malloc(sizeof *framebuffer_cache);
+
+    framebuffer_cache->device = device;
+    framebuffer_cache->entry_capacity = 16U;
+    framebuffer_cache->entries = calloc(framebuffer_cache->entry_capacity, sizeof *framebuffer_cache->entries);
+    framebuffer_cache->statistics = (struct framebuffer_cache_statistics) {0};
+
+    return framebuffer_cache;
+}
+
+void framebuffer_cache_destroy(struct framebuffer_cache *framebuffer_cache) {
+    for (uint32_t slot = 0U; slot < framebuffer_cache->entry_capacity; ++slot) {
+        if (framebuffer_cache->entries[slot].framebuffer != VK_NULL_HANDLE) {
+            framebuffer_destroy(framebuffer_cache->device, framebuffer_cache->entries[slot].framebuffer);
         }
     }
 
-    return framebuffers;
+    free(framebuffer_cache->entries);
+    free(framebuffer_cache);
 }
 
-void framebuffers_destroy(
-    const VkDevice device,
-    VkFramebuffer *framebuffers,
-    const uint32_t framebuffer_count
+static uint32_t framebuffer_cache_find_slot(
+    const struct framebuffer_cache_entry *const entries,
+    const uint32_t entry_capacity,
+    const uint64_t hash,
+    const struct framebuffer_key *const key
+) {
+    uint32_t slot = (uint32_t) hash & (entry_capacity - 1U);
+
+    while (entries[slot].framebuffer != VK_NULL_HANDLE) {
+        if (entries[slot].hash == hash && memcmp(&entries[slot].key, key, sizeof *key) == 0) {
+            break;
+        }
+
+        slot = (slot + 1U) & (entry_capacity - 1U);
+    }
+
+    return slot;
+}
+
+// Moves the entries into a table of entry_capacity slots, destroying those
+// that use evicted_image_view on the way.
+static void framebuffer_cache_rehash(struct framebuffer_cache *framebuffer_cache, const uint32_t entry_capacity, const VkImageView evicted_image_view) {
+    struct framebuffer_cache_entry *entries = calloc(entry_capacity, sizeof *entries);
+
+    for (uint32_t slot = 0U; slot < framebuffer_cache->entry_capacity; ++slot) {
+        const struct framebuffer_cache_entry *const entry = &framebuffer_cache->entries[slot];
+
+        if (entry->framebuffer == VK_NULL_HANDLE) {
+            continue;
+        }
+
+        bool evicted = false;
+
+        for (uint32_t attachment_index = 0U; attachment_index < entry->key.attachment_count; ++attachment_index) {
+            evicted = evicted || (evicted_image_view != VK_NULL_HANDLE && entry->key.attachments[attachment_index] == evicted_image_view);
+        }
+
+        if (evicted) {
+            framebuffer_destroy(framebuffer_cache->device, entry->framebuffer);
+            framebuffer_cache->statistics.framebuffer_count--;
+            continue;
+        }
+
+        entries[framebuffer_cache_find_slot(entries, entry_capacity, entry->hash, &entry->key)] = *entry;
+    }
+
+    free(framebuffer_cache->entries);
+    framebuffer_cache->entries = entries;
+    framebuffer_cache->entry_capacity = entry_capacity;
+}
+
+VkFramebuffer framebuffer_cache_get(
+    struct framebuffer_cache *framebuffer_cache,
+    const VkRenderPass render_pass,
+    const uint32_t attachment_count,
+    const VkImageView *const attachments,
+    const VkExtent2D extent
 ) {
-    for (uint32_t framebuffer_index = 0U; framebuffer_index < framebuffer_count; ++framebuffer_index) {
-        vkDestroyFramebuffer(device, framebuffers[framebuffer_index], NULL);
+    if (attachment_count > FRAMEBUFFER_MAX_ATTACHMENTS) {
+        fprintf(stderr, "error: too many framebuffer attachments\n");
+        exit(1);
     }
-    free(framebuffers);
+
+    struct framebuffer_key key;
+    memset(&key, 0, sizeof key);
+    key.render_pass = render_pass;
+    key.attachment_count = attachment_count;
+    memcpy(key.attachments, attachments, attachment_count * sizeof *attachments);
+    key.extent = extent;
+
+    const uint64_t hash = hash_bytes(&key, sizeof key, 0U);
+
+    framebuffer_cache->statistics.request_count++;
+
+    const uint32_t slot = framebuffer_cache_find_slot(framebuffer_cache->entries, framebuffer_cache->entry_capacity, hash, &key);
+    struct framebuffer_cache_entry *entry = &framebuffer_cache->entries[slot];
+
+    if (entry->framebuffer != VK_NULL_HANDLE) {
+        framebuffer_cache->statistics.hit_count++;
+        return entry->framebuffer;
+    }
+
+    entry->key = key;
+    entry->hash = hash;
+    entry->framebuffer = framebuffer_create(framebuffer_cache->device, render_pass, attachment_count, attachments, extent);
+
+    const VkFramebuffer framebuffer = entry->framebuffer;
+
+    framebuffer_cache->statistics.create_count++;
+
+    if (++framebuffer_cache->statistics.framebuffer_count * 2U > framebuffer_cache->entry_capacity) {
+        framebuffer_cache_rehash(framebuffer_cache, framebuffer_cache->entry_capacity * 2U, VK_NULL_HANDLE);
+    }
+
+    return framebuffer;
+}
+
+void framebuffer_cache_evict_image_view(struct framebuffer_cache *framebuffer_cache, const VkImageView image_view) {
+    framebuffer_cache_rehash(framebuffer_cache, framebuffer_cache->entry_capacity, image_view);
 }
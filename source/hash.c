@@ -0,0 +1,52 @@
+#include <hash.h>
+
+#include <string.h>
+
+// 64-bit multiply-and-rotate hash that consumes eight bytes per step. It is
+// not cryptographic; it is meant for hash tables keyed by plain-data structs.
+
+static const uint64_t hash_prime_1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t hash_prime_2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t hash_prime_3 = 0x165667B19E3779F9ULL;
+
+static uint64_t hash_rotate_left(const uint64_t value, const uint32_t bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static uint64_t hash_mix(uint64_t hash) {
+    hash ^= hash >> 33;
+    hash *= hash_prime_2;
+    hash ^= hash >> 29;
+    hash *= hash_prime_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+uint64_t hash_bytes(const void *const data, const size_t size, const uint64_t seed) {
+    const uint8_t *bytes = data;
+    uint64_t hash = seed ^ (size * hash_prime_1);
+
+    size_t remaining_size = size;
+
+    while (remaining_size >= sizeof (uint64_t)) {
+        uint64_t word;
+        memcpy(&word, bytes, sizeof word);
+        hash ^= hash_rotate_left(word * hash_prime_2, 31) * hash_prime_1;
+        hash = hash_rotate_left(hash, 27) * hash_prime_1 + hash_prime_3;
+        bytes += sizeof (uint64_t);
+        remaining_size -= sizeof (uint64_t);
+    }
+
+    while (remaining_size > 0) {
+        hash ^= (*bytes) * hash_prime_3;
+        hash = hash_rotate_left(hash, 11) * hash_prime_1;
+        bytes++;
+        remaining_size--;
+    }
+
+    return hash_mix(hash);
+}
+
+uint64_t hash_combine(const uint64_t hash, const uint64_t value) {
+    return hash_mix(hash ^ (value + hash_prime_1 + (hash << 6) + (hash >> 2)));
+}
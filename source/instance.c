@@ -2,6 +2,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 VkInstance instance_create(
     const uint32_t enabled_layer_count,
@@ -16,7 +17,7 @@ VkInstance instance_create(
         .applicationVersion = VK_MAKE_VERSION(1, 0, 0),
         .pEngineName = "Vulkan Engine",
         .engineVersion = VK_MAKE_VERSION(1, 0, 0),
-        .apiVersion = VK_API_VERSION_1_0
+        .apiVersion = VK_API_VERSION_1_2
     };
 
     const VkInstanceCreateInfo instance_create_info = {
@@ -85,7 +86,7 @@ VkPhysicalDeviceMemoryProperties physical_device_get_memory_properties(const VkP
     return physical_device_memory_properties;
 }
 
-uint32_t physical_device_find_queue_family_index(const VkPhysicalDevice physical_device, const VkQueueFlagBits queue_flag_bits) {
+uint32_t physical_device_find_queue_family_index(const VkPhysicalDevice physical_device, const VkQueueFlags queue_flags) {
     uint32_t queue_family_count = 0;
     vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, NULL);
     VkQueueFamilyProperties *queue_family_properties = malloc(queue_family_count * (sizeof *queue_family_properties));
@@ -100,7 +101,7 @@ uint32_t physical_device_find_queue_family_index(const VkPhysicalDevice physical
     uint32_t queue_family_found = 0;
 
     for (uint32_t queue_family_properties_index = 0U; queue_family_properties_index < queue_family_count; ++queue_family_properties_index) {
-        if (queue_family_properties[queue_family_properties_index].queueFlags & queue_flag_bits) {
+        if ((queue_family_properties[queue_family_properties_index].queueFlags & queue_flags) == queue_flags) {
             queue_family_index = queue_family_properties_index;
             queue_family_found = 1;
             break;
@@ -110,7 +111,200 @@ uint32_t physical_device_find_queue_family_index(const VkPhysicalDevice physical
     free(queue_family_properties);
 
     if (!queue_family_found) {
-        fprintf(stderr, "error: no graphics queue family is available\n");
+        fprintf(stderr, "error: no queue family with queue flags 0x%x is available\n", (unsigned int) queue_flags);
         exit(1);
     }
+
+    return queue_family_index;
+}
+
+VkQueueFamilyProperties physical_device_get_queue_family_properties(const VkPhysicalDevice physical_device, const uint32_t queue_family_index) {
+    uint32_t queue_family_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, NULL);
+    VkQueueFamilyProperties *queue_family_properties = malloc(queue_family_count * (sizeof *queue_family_properties));
+    vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, queue_family_properties);
+
+    if (queue_family_index >= queue_family_count) {
+        fprintf(stderr, "error: queue family %u is not available\n", queue_family_index);
+        exit(1);
+    }
+
+    const VkQueueFamilyProperties properties = queue_family_properties[queue_family_index];
+    free(queue_family_properties);
+
+    return properties;
+}
+
+VkPhysicalDeviceVulkan12Features physical_device_get_vulkan_12_features(const VkPhysicalDevice physical_device) {
+    VkPhysicalDeviceVulkan12Features physical_device_vulkan_12_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+        .pNext = NULL
+    };
+
+    VkPhysicalDeviceProperties physical_device_properties;
+    vkGetPhysicalDeviceProperties(physical_device, &physical_device_properties);
+
+    // Leave every feature unset on devices that cannot report Vulkan 1.2 features.
+    if (physical_device_properties.apiVersion < VK_API_VERSION_1_2) {
+        return physical_device_vulkan_12_features;
+    }
+
+    VkPhysicalDeviceFeatures2 physical_device_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &physical_device_vulkan_12_features
+    };
+
+    vkGetPhysicalDeviceFeatures2(physical_device, &physical_device_features);
+
+    physical_device_vulkan_12_features.pNext = NULL;
+
+    return physical_device_vulkan_12_features;
+}
+
+VkPhysicalDeviceFeatures physical_device_get_features(const VkPhysicalDevice physical_device) {
+    VkPhysicalDeviceFeatures physical_device_features;
+    vkGetPhysicalDeviceFeatures(physical_device, &physical_device_features);
+    return physical_device_features;
+}
+
+bool physical_device_supports_extension(const VkPhysicalDevice physical_device, const char *const extension_name) {
+    uint32_t extension_count = 0;
+    vkEnumerateDeviceExtensionProperties(physical_device, NULL, &extension_count, NULL);
+
+    VkExtensionProperties *extensions = malloc(extension_count * (sizeof *extensions));
+    vkEnumerateDeviceExtensionProperties(physical_device, NULL, &extension_count, extensions);
+
+    bool supported = false;
+
+    for (uint32_t extension_index = 0; extension_index < extension_count && !supported; ++extension_index) {
+        supported = strcmp(extensions[extension_index].extensionName, extension_name) == 0;
+    }
+
+    free(extensions);
+
+    return supported;
+}
+
+// Fills a single extension feature structure, whose pNext is left NULL.
+static void physical_device_query_extension_features(const VkPhysicalDevice physical_device, VkBaseOutStructure *extension_features) {
+    VkPhysicalDeviceFeatures2 physical_device_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = extension_features
+    };
+
+    vkGetPhysicalDeviceFeatures2(physical_device, &physical_device_features);
+
+    extension_features->pNext = NULL;
+}
+
+VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT physical_device_get_graphics_pipeline_library_features(const VkPhysicalDevice physical_device) {
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT graphics_pipeline_library_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT,
+        .pNext = NULL,
+        .graphicsPipelineLibrary = VK_FALSE
+    };
+
+    VkPhysicalDeviceProperties physical_device_properties;
+    vkGetPhysicalDeviceProperties(physical_device, &physical_device_properties);
+
+    if (physical_device_properties.apiVersion < VK_API_VERSION_1_1 ||
+        !physical_device_supports_extension(physical_device, VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME) ||
+        !physical_device_supports_extension(physical_device, VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME)) {
+        return graphics_pipeline_library_features;
+    }
+
+    physical_device_query_extension_features(physical_device, (VkBaseOutStructure *) &graphics_pipeline_library_features);
+
+    return graphics_pipeline_library_features;
+}
+
+VkPhysicalDeviceExtendedDynamicStateFeaturesEXT physical_device_get_extended_dynamic_state_features(const VkPhysicalDevice physical_device) {
+    VkPhysicalDeviceExtendedDynamicStateFeaturesEXT extended_dynamic_state_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT,
+        .pNext = NULL,
+        .extendedDynamicState = VK_FALSE
+    };
+
+    VkPhysicalDeviceProperties physical_device_properties;
+    vkGetPhysicalDeviceProperties(physical_device, &physical_device_properties);
+
+    if (physical_device_properties.apiVersion < VK_API_VERSION_1_1 ||
+        !physical_device_supports_extension(physical_device, VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME)) {
+        return extended_dynamic_state_features;
+    }
+
+    physical_device_query_extension_features(physical_device, (VkBaseOutStructure *) &extended_dynamic_state_features);
+
+    return extended_dynamic_state_features;
+}
+
+VkPhysicalDeviceExtendedDynamicState3FeaturesEXT physical_device_get_extended_dynamic_state_3_features(const VkPhysicalDevice physical_device) {
+    VkPhysicalDeviceExtendedDynamicState3FeaturesEXT extended_dynamic_state_3_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT,
+        .pNext = NULL
+    };
+
+    VkPhysicalDeviceProperties physical_device_properties;
+    vkGetPhysicalDeviceProperties(physical_device, &physical_device_properties);
+
+    if (physical_device_properties.apiVersion < VK_API_VERSION_1_1 ||
+        !physical_device_supports_extension(physical_device, VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME)) {
+        return extended_dynamic_state_3_features;
+    }
+
+    physical_device_query_extension_features(physical_device, (VkBaseOutStructure *) &extended_dynamic_state_3_features);
+
+    return extended_dynamic_state_3_features;
+}
+
+VkPhysicalDeviceDynamicRenderingFeaturesKHR physical_device_get_dynamic_rendering_features(const VkPhysicalDevice physical_device) {
+    VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamic_rendering_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR,
+        .pNext = NULL,
+        .dynamicRendering = VK_FALSE
+    };
+
+    VkPhysicalDeviceProperties physical_device_properties;
+    vkGetPhysicalDeviceProperties(physical_device, &physical_device_properties);
+
+    // The extension depends on VK_KHR_create_renderpass2 and
+    // VK_KHR_depth_stencil_resolve, which are core in 1.2.
+    if (physical_device_properties.apiVersion < VK_API_VERSION_1_2 ||
+        !physical_device_supports_extension(physical_device, VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME)) {
+        return dynamic_rendering_features;
+    }
+
+    physical_device_query_extension_features(physical_device, (VkBaseOutStructure *) &dynamic_rendering_features);
+
+    return dynamic_rendering_features;
+}
+
+VkFormat physical_device_choose_depth_format(const VkPhysicalDevice physical_device) {
+    const VkFormat depth_formats[] = {VK_FORMAT_D32_SFLOAT, VK_FORMAT_X8_D24_UNORM_PACK32, VK_FORMAT_D24_UNORM_S8_UINT, VK_FORMAT_D16_UNORM};
+
+    for (uint32_t format_index = 0U; format_index < (sizeof depth_formats) / (sizeof *depth_formats); ++format_index) {
+        VkFormatProperties format_properties;
+        vkGetPhysicalDeviceFormatProperties(physical_device, depth_formats[format_index], &format_properties);
+
+        if (format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) {
+            return depth_formats[format_index];
+        }
+    }
+
+    fprintf(stderr, "error: no depth format is supported\n");
+    exit(1);
+}
+
+VkSampleCountFlagBits physical_device_choose_sample_count(const VkPhysicalDeviceProperties physical_device_properties, const uint32_t requested_sample_count) {
+    const VkSampleCountFlags supported_sample_counts = physical_device_properties.limits.framebufferColorSampleCounts & physical_device_properties.limits.framebufferDepthSampleCounts;
+
+    VkSampleCountFlagBits sample_count = VK_SAMPLE_COUNT_1_BIT;
+
+    for (uint32_t candidate = 2U; candidate <= requested_sample_count && candidate <= VK_SAMPLE_COUNT_64_BIT; candidate *= 2U) {
+        if (supported_sample_counts & candidate) {
+            sample_count = (VkSampleCountFlagBits) candidate;
+        }
+    }
+
+    return sample_count;
 }
@@ -2,10 +2,16 @@
 
 #include <window.h>
 #include <buffer.h>
+#include <drawqueue.h>
+#include <mesh.h>
 #include <queue.h>
+#include <readback.h>
 
+#include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <time.h>
 
 const float vertex_data[] = {
     -0.5f, -0.5f,       // Position #1 // Vertex #1
@@ -28,58 +34,341 @@ const float vertex_data[] = {
 };
 
 const uint32_t vertex_count = 6;
+const uint32_t vertex_stride = 2 * sizeof (float) + 3 * sizeof (float);
 
 struct context *context = NULL;
+struct mesh *mesh = NULL;
 VkBuffer vertex_buffer = NULL;
+VkBuffer index_buffer = NULL;
+
+// GLFW is not initialized in headless runs, so its timer cannot be used.
+double time_get_seconds(void) {
+    struct timespec timespec;
+    clock_gettime(CLOCK_MONOTONIC, &timespec);
+    return timespec.tv_sec + timespec.tv_nsec / 1e9;
+}
+
+// Stands in for encoding or uploading the frame, every byte is read once.
+void on_frame_read_back(const void *const pixels, const VkExtent2D extent, const uint64_t frame_index, void *user_data) {
+    const uint32_t *const texels = pixels;
+    uint32_t *checksum = user_data;
+
+    for (uint32_t texel_index = 0U; texel_index < extent.width * extent.height; ++texel_index) {
+        *checksum ^= texels[texel_index];
+    }
+}
 
 void on_window_resize(GLFWwindow *window, int width, int height) {
     if (width == 0 || height == 0) return;
 
     context_recreate_swapchain(context, width, height);
-    context_record_command_buffers(context, vertex_buffer, vertex_count);
+}
+
+VkBuffer create_device_local_buffer(
+    const VkBufferUsageFlags buffer_usage_flags,
+    const uint32_t buffer_size,
+    const void *buffer_data,
+    VkDeviceMemory *buffer_device_memory
+) {
+    const VkBuffer staging_buffer = buffer_create(context->device, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, buffer_size);
+
+    const VkDeviceMemory staging_buffer_device_memory = buffer_allocate_device_memory(staging_buffer, context->device, context->physical_device_memory_properties, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    buffer_upload_data(staging_buffer, context->device, staging_buffer_device_memory, buffer_size, buffer_data);
+
+    const VkBuffer buffer = buffer_create(context->device, VK_BUFFER_USAGE_TRANSFER_DST_BIT | buffer_usage_flags, buffer_size);
+    *buffer_device_memory = buffer_allocate_device_memory(buffer, context->device, context->physical_device_memory_properties, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    buffer_copy_data(staging_buffer, buffer, context->device, context->command_pool, context->queue, buffer_size);
+
+    buffer_destroy(context->device, staging_buffer);
+    buffer_free_memory(context->device, staging_buffer_device_memory);
+
+    return buffer;
 }
 
 int main() {
-    if (!glfwInit()) {
-        fprintf(stderr, "error: failed to initialize GLFW.\n");
-        exit(1);
+    // With LEARN_VULKAN_HEADLESS_FRAMES set, that many frames are rendered
+    // offscreen without a window and the frame rate is reported.
+    const char *const headless_frame_count_string = getenv("LEARN_VULKAN_HEADLESS_FRAMES");
+    const uint64_t headless_frame_count = headless_frame_count_string ? strtoull(headless_frame_count_string, NULL, 10) : 0U;
+
+    GLFWwindow *window = NULL;
+
+    if (headless_frame_count == 0U) {
+        if (!glfwInit()) {
+            fprintf(stderr, "error: failed to initialize GLFW.\n");
+            exit(1);
+        }
+
+        window = window_create(1280, 720);
     }
 
-    GLFWwindow *window = window_create(1280, 720);
+    const double start_time = time_get_seconds();
 
-    context = context_create(window);
+    context = window ? context_create(window) : context_create_headless(1280U, 720U, VK_FORMAT_R8G8B8A8_UNORM);
 
-    const uint32_t buffer_size = vertex_count * (2 * sizeof (float) + 3 * sizeof (float));
+    // LEARN_VULKAN_READBACK_FRAMES is how many frames a headless run keeps in
+    // flight for readback, at least one per offscreen image.
+    const char *const readback_slot_count_string = window ? NULL : getenv("LEARN_VULKAN_READBACK_FRAMES");
+    struct readback *readback = NULL;
+    uint32_t readback_checksum = 0U;
 
-    const VkBuffer staging_buffer = buffer_create(context->device, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, buffer_size);
+    if (readback_slot_count_string != NULL) {
+        const uint32_t requested_slot_count = (uint32_t) strtoul(readback_slot_count_string, NULL, 10);
+        const uint32_t slot_count = requested_slot_count > context->swapchain_image_count ? requested_slot_count : context->swapchain_image_count;
 
-    const VkDeviceMemory staging_buffer_device_memory = buffer_allocate_device_memory(staging_buffer, context->device, context->physical_device_memory_properties, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        readback = readback_create(context->device, context->physical_device_memory_properties, context->surface_capabilities.currentExtent, context->surface_format.format, slot_count, on_frame_read_back, &readback_checksum);
+        context_attach_readback(context, readback);
+    }
 
-    buffer_upload_data(staging_buffer, context->device, staging_buffer_device_memory, buffer_size, vertex_data);
+    //
+    // Weld the triangle soup into unique vertices and indices.
+
+    mesh = mesh_create_welded(vertex_data, vertex_count, vertex_stride);
 
     //
-    // Create a vertex buffer.
+    // Create a vertex buffer and an index buffer.
 
-    vertex_buffer = buffer_create(context->device, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, buffer_size);
-    const VkDeviceMemory vertex_buffer_device_memory = buffer_allocate_device_memory(vertex_buffer, context->device, context->physical_device_memory_properties, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    VkDeviceMemory vertex_buffer_device_memory = VK_NULL_HANDLE;
+    vertex_buffer = create_device_local_buffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, mesh_get_vertex_data_size(mesh), mesh->vertex_data, &vertex_buffer_device_memory);
 
-    buffer_copy_data(staging_buffer, vertex_buffer, context->device, context->command_pool, context->queue, buffer_size);
+    VkDeviceMemory index_buffer_device_memory = VK_NULL_HANDLE;
+    index_buffer = create_device_local_buffer(VK_BUFFER_USAGE_INDEX_BUFFER_BIT, mesh_get_index_data_size(mesh), mesh->index_data, &index_buffer_device_memory);
 
-    buffer_destroy(context->device, staging_buffer);
-    buffer_free_memory(context->device, staging_buffer_device_memory);
+    struct draw_queue *draw_queue = draw_queue_create();
+
+    struct draw quad_draw = {
+        .pipeline = VK_NULL_HANDLE,
+        .depth_prepass_pipeline = VK_NULL_HANDLE,
+        .pipeline_layout = context->graphics_pipeline_layout,
+        .descriptor_set = context->uniform_ring->descriptor_set,
+        .dynamic_offset = 0,
+        .push_constant_stage_flags = context->graphics_push_constant_range.stageFlags,
+        .push_constant_size = context->graphics_push_constant_range.size,
+        .vertex_buffer = vertex_buffer,
+        .index_buffer = index_buffer,
+        .index_type = mesh->index_type,
+        .element_count = mesh->index_count,
+        .first_element = 0,
+        .vertex_offset = 0,
+        .dynamic_state = graphics_pipeline_description_get_dynamic_state(&context->graphics_pipeline_description)
+    };
+
+    if (window != NULL) {
+        glfwSetWindowSizeCallback(window, on_window_resize);
+    }
+
+    // A grayscale variant of the quad pipeline is drawn while G is held. It
+    // differs only in a specialization constant and is requested again
+    // whenever the context requests a new base pipeline, after a resize or a
+    // shader reload.
+    struct pipeline_future *grayscale_pipeline_future = NULL;
+    struct pipeline_future *grayscale_base_pipeline_future = NULL;
+    VkPipeline grayscale_pipeline = VK_NULL_HANDLE;
 
-    context_record_command_buffers(context, vertex_buffer, vertex_count);
+    // The depth pre-pass variant follows the base pipeline the same way.
+    struct pipeline_future *depth_prepass_pipeline_future = NULL;
 
-    glfwSetWindowSizeCallback(window, on_window_resize);
+    // A smaller quad orbiting the first one is encoded into a command stream
+    // instead of the draw queue and replayed after it.
+    struct command_stream *orbit_command_stream = command_stream_create(context->command_arena);
+    double statistics_encode_time = 0.0;
+    uint32_t statistics_encode_count = 0U;
 
-    while (!glfwWindowShouldClose(window)) {
-        glfwPollEvents();
-        queue_draw(context->queue, context->device, context->swapchain, context->command_buffers, context->semaphore_image_available, context->semaphore_image_rendered, context->fences);
+    double statistics_time = time_get_seconds();
+    const double loop_start_time = statistics_time;
+    uint64_t statistics_readback_byte_count = 0U;
+
+    while (window ? !glfwWindowShouldClose(window) : context->frame_index < headless_frame_count) {
+        if (window != NULL) {
+            glfwPollEvents();
+        }
+
+        context_begin_frame(context);
+
+        //
+        // Per-draw data: the transform goes through push constants, larger
+        // blocks are copied into the uniform ring and addressed by offset.
+
+        const float time = (float) (time_get_seconds() - start_time);
+
+        const float transform[16] = {
+            cosf(time), sinf(time), 0.0f, 0.0f,
+            -sinf(time), cosf(time), 0.0f, 0.0f,
+            0.0f, 0.0f, 1.0f, 0.0f,
+            0.0f, 0.0f, 0.0f, 1.0f
+        };
+
+        const float tint[4] = {0.75f + 0.25f * sinf(time), 1.0f, 1.0f, 1.0f};
+
+        memcpy(quad_draw.push_constant_data, transform, sizeof transform);
+        quad_draw.dynamic_offset = uniform_ring_push(context->uniform_ring, tint, sizeof tint);
+
+        // Until the pipeline has been compiled in the background the quad is
+        // skipped, also after a resize that changed the render pass.
+        if (quad_draw.pipeline == VK_NULL_HANDLE && pipeline_future_is_ready(context->graphics_pipeline_future)) {
+            const struct pipeline_compiler_statistics pipeline_compiler_statistics = pipeline_compiler_get_statistics(context->pipeline_compiler);
+            printf("info: graphics pipeline ready after %.2f ms, %u requests, %u hits, %u compiles taking %.2f ms\n",
+                (time_get_seconds() - start_time) * 1e3,
+                pipeline_compiler_statistics.request_count,
+                pipeline_compiler_statistics.hit_count,
+                pipeline_compiler_statistics.compile_count,
+                pipeline_compiler_statistics.compile_time * 1e3);
+        }
+
+        if (grayscale_base_pipeline_future != context->graphics_pipeline_future) {
+            struct graphics_pipeline_description grayscale_pipeline_description;
+            context_describe_graphics_pipeline(context, CONTEXT_GRAPHICS_PIPELINE_VARIANT_GRAYSCALE, &grayscale_pipeline_description);
+            grayscale_pipeline_future = pipeline_compiler_request_graphics(context->pipeline_compiler, &grayscale_pipeline_description);
+            grayscale_base_pipeline_future = context->graphics_pipeline_future;
+
+            // After a shader reload or a render pass change the previous
+            // pipelines may be destroyed.
+            quad_draw.pipeline = VK_NULL_HANDLE;
+            grayscale_pipeline = VK_NULL_HANDLE;
+
+            if (context->depth_prepass) {
+                struct graphics_pipeline_description depth_prepass_pipeline_description;
+                context_describe_graphics_pipeline(context, CONTEXT_GRAPHICS_PIPELINE_VARIANT_DEPTH_PREPASS, &depth_prepass_pipeline_description);
+                depth_prepass_pipeline_future = pipeline_compiler_request_graphics(context->pipeline_compiler, &depth_prepass_pipeline_description);
+                quad_draw.depth_prepass_pipeline = VK_NULL_HANDLE;
+            }
+        }
+
+        quad_draw.pipeline = pipeline_future_get(context->graphics_pipeline_future, quad_draw.pipeline);
+        // With pipeline libraries the variant only builds its fragment shader part.
+        if (grayscale_pipeline == VK_NULL_HANDLE && pipeline_future_is_ready(grayscale_pipeline_future)) {
+            const struct pipeline_compiler_statistics pipeline_compiler_statistics = pipeline_compiler_get_statistics(context->pipeline_compiler);
+            printf("info: grayscale variant compiled in %.3f ms, %u pipeline library parts built, %u reused, %u optimized links\n",
+                grayscale_pipeline_future->compile_time * 1e3,
+                pipeline_compiler_statistics.library_count,
+                pipeline_compiler_statistics.library_hit_count,
+                pipeline_compiler_statistics.optimized_link_count);
+        }
+
+        grayscale_pipeline = pipeline_future_get(grayscale_pipeline_future, grayscale_pipeline);
+
+        if (depth_prepass_pipeline_future != NULL) {
+            quad_draw.depth_prepass_pipeline = pipeline_future_get(depth_prepass_pipeline_future, quad_draw.depth_prepass_pipeline);
+        }
+
+        struct draw shown_quad_draw = quad_draw;
+
+        if (window != NULL && glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS && grayscale_pipeline != VK_NULL_HANDLE) {
+            shown_quad_draw.pipeline = grayscale_pipeline;
+        }
+
+        draw_queue_reset(draw_queue);
+        draw_queue_submit(draw_queue, 0, 0, 0.5f, &shown_quad_draw);
+        draw_queue_sort(draw_queue);
+
+        const double encode_start_time = time_get_seconds();
+
+        command_stream_reset(orbit_command_stream);
+
+        if (shown_quad_draw.pipeline != VK_NULL_HANDLE) {
+            const float orbit_transform[16] = {
+                0.25f * cosf(-2.0f * time), 0.25f * sinf(-2.0f * time), 0.0f, 0.0f,
+                -0.25f * sinf(-2.0f * time), 0.25f * cosf(-2.0f * time), 0.0f, 0.0f,
+                0.0f, 0.0f, 1.0f, 0.0f,
+                0.6f * cosf(time), 0.6f * sinf(time), 0.0f, 1.0f
+            };
+
+            uint8_t orbit_push_constant_data[DRAW_PUSH_CONSTANT_SIZE] = {0};
+            memcpy(orbit_push_constant_data, orbit_transform, sizeof orbit_transform);
+
+            const float orbit_tint[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+            const uint32_t orbit_dynamic_offset = uniform_ring_push(context->uniform_ring, orbit_tint, sizeof orbit_tint);
+
+            command_stream_bind_pipeline(orbit_command_stream, VK_PIPELINE_BIND_POINT_GRAPHICS, shown_quad_draw.pipeline);
+            command_stream_set_dynamic_state(orbit_command_stream, &shown_quad_draw.dynamic_state);
+            command_stream_bind_descriptor_set(orbit_command_stream, VK_PIPELINE_BIND_POINT_GRAPHICS, shown_quad_draw.pipeline_layout, 0, shown_quad_draw.descriptor_set, 1, orbit_dynamic_offset);
+            command_stream_push_constants(orbit_command_stream, shown_quad_draw.pipeline_layout, shown_quad_draw.push_constant_stage_flags, 0, shown_quad_draw.push_constant_size, orbit_push_constant_data);
+            command_stream_bind_vertex_buffer(orbit_command_stream, 0, vertex_buffer, 0);
+            command_stream_bind_index_buffer(orbit_command_stream, index_buffer, 0, mesh->index_type);
+            command_stream_draw_indexed(orbit_command_stream, mesh->index_count, 1, 0, 0, 0);
+        }
+
+        statistics_encode_time += time_get_seconds() - encode_start_time;
+        statistics_encode_count++;
+
+        const struct command_stream *const command_streams[] = {orbit_command_stream};
+        context_end_frame(context, draw_queue, command_streams, 1);
+
+        if (time_get_seconds() - statistics_time >= 1.0) {
+            statistics_time = time_get_seconds();
+            printf("info: %u draws, %u skipped, %u pipeline binds, %u vertex buffer binds, %u index buffer binds, %u descriptor set binds, %u dynamic state updates, %u binds avoided per frame\n",
+                context->draw_queue_statistics.draw_count,
+                context->draw_queue_statistics.draws_skipped,
+                context->draw_queue_statistics.pipeline_binds,
+                context->draw_queue_statistics.vertex_buffer_binds,
+                context->draw_queue_statistics.index_buffer_binds,
+                context->draw_queue_statistics.descriptor_set_binds,
+                context->draw_queue_statistics.dynamic_state_updates,
+                context->draw_queue_statistics.binds_avoided);
+            printf("info: command stream %u packets encoded in %.3f us per frame\n",
+                orbit_command_stream->packet_count,
+                statistics_encode_time / statistics_encode_count * 1e6);
+            statistics_encode_time = 0.0;
+            statistics_encode_count = 0U;
+            printf("info: render graph %u passes, %u culled, %u barrier batches, %u image barriers, %u buffer barriers, %u transient resources in %llu bytes, %llu without aliasing\n",
+                context->render_graph->statistics.pass_count,
+                context->render_graph->statistics.culled_pass_count,
+                context->render_graph->statistics.barrier_batch_count,
+                context->render_graph->statistics.image_barrier_count,
+                context->render_graph->statistics.buffer_barrier_count,
+                context->render_graph->statistics.transient_resource_count,
+                (unsigned long long) context->render_graph->statistics.transient_memory_size,
+                (unsigned long long) context->render_graph->statistics.unaliased_memory_size);
+
+            if (readback != NULL) {
+                const struct readback_statistics readback_statistics = readback->statistics;
+                printf("info: readback %.1f MB/s, %llu frames, %.2f frames latency, %u stalls, checksum 0x%08x\n",
+                    (readback_statistics.byte_count - statistics_readback_byte_count) / 1e6,
+                    (unsigned long long) readback_statistics.frame_count,
+                    readback_statistics.frame_count ? (double) readback_statistics.latency_frame_count / readback_statistics.frame_count : 0.0,
+                    readback_statistics.stall_count,
+                    readback_checksum);
+                statistics_readback_byte_count = readback_statistics.byte_count;
+            }
+
+            if (context->dynamic_resolution != NULL) {
+                printf("info: dynamic resolution scale %.2f, %ux%u, gpu %.2f ms of %.2f ms target, %u decreases, %u increases\n",
+                    context->dynamic_resolution->scale,
+                    context->render_extent.width,
+                    context->render_extent.height,
+                    context->dynamic_resolution->gpu_time,
+                    context->dynamic_resolution->target_gpu_time,
+                    context->dynamic_resolution->statistics.scale_decrease_count,
+                    context->dynamic_resolution->statistics.scale_increase_count);
+            }
+        }
     }
 
     vkDeviceWaitIdle(context->device);
 
+    if (window == NULL) {
+        const double loop_time = time_get_seconds() - loop_start_time;
+        printf("info: %llu headless frames in %.2f s, %.1f frames per second\n",
+            (unsigned long long) context->frame_index,
+            loop_time,
+            context->frame_index / loop_time);
+
+        if (readback != NULL) {
+            printf("info: %llu frames read back, %.1f MB/s sustained\n",
+                (unsigned long long) readback->statistics.frame_count,
+                readback->statistics.byte_count / 1e6 / loop_time);
+            readback_destroy(readback);
+        }
+    }
+
+    command_stream_destroy(orbit_command_stream);
+    draw_queue_destroy(draw_queue);
+    buffer_free_memory(context->device, index_buffer_device_memory);
+    buffer_destroy(context->device, index_buffer);
     buffer_free_memory(context->device, vertex_buffer_device_memory);
     buffer_destroy(context->device, vertex_buffer);
+    mesh_destroy(mesh);
     context_destroy(context);
 }
@@ -0,0 +1,124 @@
+#include <mesh.h>
+
+#include <hash.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Vertices are welded when their bytes are identical, so two vertices that
+// only differ in the sign of a zero component are kept apart. This is fine
+// for the data we generate and avoids interpreting the vertex layout here.
+
+static uint32_t mesh_hash_table_capacity(const uint32_t vertex_count) {
+    // The largest power of two that fits holds 2^30 vertices at half load.
+    if (vertex_count > (UINT32_MAX / 2U + 1U) / 2U) {
+        fprintf(stderr, "error: %u vertices are too many to weld\n", vertex_count);
+        exit(1);
+    }
+
+    uint32_t capacity = 16U;
+
+    while (capacity < 2U * vertex_count) {
+        capacity <<= 1U;
+    }
+
+    return capacity;
+}
+
+struct mesh *mesh_create_welded(
+    const void *const vertex_data,
+    const uint32_t vertex_count,
+    const uint32_t vertex_stride
+) {
+    if (vertex_count == 0U || vertex_stride == 0U) {
+        fprintf(stderr, "error: cannot weld an empty mesh\n");
+        exit(1);
+    }
+
+    const uint8_t *const source_vertices = vertex_data;
+
+    uint8_t *unique_vertices = malloc((size_t) vertex_count * vertex_stride);
+    uint32_t *indices = malloc(vertex_count * (sizeof *indices));
+
+    // Each slot stores a unique vertex index plus one so zero marks an empty slot.
+    const uint32_t hash_table_capacity = mesh_hash_table_capacity(vertex_count);
+    uint32_t *hash_table = calloc(hash_table_capacity, sizeof *hash_table);
+
+    if (unique_vertices == NULL || indices == NULL || hash_table == NULL) {
+        fprintf(stderr, "error: failed to allocate memory for vertex welding\n");
+        exit(1);
+    }
+
+    uint32_t unique_vertex_count = 0U;
+
+    for (uint32_t vertex_index = 0U; vertex_index < vertex_count; ++vertex_index) {
+        const uint8_t *const vertex = source_vertices + (size_t) vertex_index * vertex_stride;
+        uint32_t slot = (uint32_t) hash_bytes(vertex, vertex_stride, 0U) & (hash_table_capacity - 1U);
+
+        while (hash_table[slot] != 0U) {
+            const uint32_t unique_vertex_index = hash_table[slot] - 1U;
+
+            if (memcmp(unique_vertices + (size_t) unique_vertex_index * vertex_stride, vertex, vertex_stride) == 0) {
+                break;
+            }
+
+            slot = (slot + 1U) & (hash_table_capacity - 1U);
+        }
+
+        if (hash_table[slot] == 0U) {
+            memcpy(unique_vertices + (size_t) unique_vertex_count * vertex_stride, vertex, vertex_stride);
+            hash_table[slot] = ++unique_vertex_count;
+        }
+
+        indices[vertex_index] = hash_table[slot] - 1U;
+    }
+
+    free(hash_table);
+
+    struct mesh *mesh = malloc(sizeof *mesh);
+    mesh->vertex_count = unique_vertex_count;
+    mesh->vertex_stride = vertex_stride;
+    mesh->index_count = vertex_count;
+    mesh->index_type = mesh_choose_index_type(unique_vertex_count);
+    mesh->vertex_data = realloc(unique_vertices, (size_t) unique_vertex_count * vertex_stride);
+
+    if (mesh->index_type == VK_INDEX_TYPE_UINT16) {
+        uint16_t *short_indices = malloc(vertex_count * (sizeof *short_indices));
+
+        for (uint32_t index = 0U; index < vertex_count; ++index) {
+            short_indices[index] = (uint16_t) indices[index];
+        }
+
+        free(indices);
+        mesh->index_data = short_indices;
+    }
+    else {
+        mesh->index_data = indices;
+    }
+
+    return mesh;
+}
+
+void mesh_destroy(struct mesh *mesh) {
+    free(mesh->index_data);
+    free(mesh->vertex_data);
+    free(mesh);
+}
+
+VkIndexType mesh_choose_index_type(const uint32_t vertex_count) {
+    // 0xFFFF is kept free so primitive restart can be enabled without re-indexing.
+    return vertex_count <= UINT16_MAX ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+}
+
+uint32_t mesh_get_index_size(const VkIndexType index_type) {
+    return index_type == VK_INDEX_TYPE_UINT16 ? sizeof (uint16_t) : sizeof (uint32_t);
+}
+
+uint32_t mesh_get_vertex_data_size(const struct mesh *const mesh) {
+    return mesh->vertex_count * mesh->vertex_stride;
+}
+
+uint32_t mesh_get_index_data_size(const struct mesh *const mesh) {
+    return mesh->index_count * mesh_get_index_size(mesh->index_type);
+}
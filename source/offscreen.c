@@ -0,0 +1,117 @@
+#include <offscreen.h>
+
+#include <device.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+struct offscreen_images *offscreen_images_create(
+    const VkDevice device,
+    const VkPhysicalDeviceMemoryProperties physical_device_memory_properties,
+    const VkFormat format,
+    const VkExtent2D extent,
+    const uint32_t image_count
+) {
+    struct offscreen_images *offscreen_images = malloc(sizeof *offscreen_images);
+
+    offscreen_images->image_count = image_count;
+    offscreen_images->images = malloc(image_count * (sizeof *offscreen_images->images));
+    offscreen_images->image_views = malloc(image_count * (sizeof *offscreen_images->image_views));
+    offscreen_images->device_memories = malloc(image_count * (sizeof *offscreen_images->device_memories));
+
+    for (uint32_t image_index = 0U; image_index < image_count; ++image_index) {
+        const VkImageCreateInfo image_create_info = {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            .pNext = NULL,
+            .flags = 0,
+            .imageType = VK_IMAGE_TYPE_2D,
+            .format = format,
+            .extent = {extent.width, extent.height, 1},
+            .mipLevels = 1,
+            .arrayLayers = 1,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .tiling = VK_IMAGE_TILING_OPTIMAL,
+            .usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+            .queueFamilyIndexCount = 0,
+            .pQueueFamilyIndices = NULL,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
+        };
+
+        VkResult result = vkCreateImage(device, &image_create_info, NULL, &offscreen_images->images[image_index]);
+
+        if (result != VK_SUCCESS) {
+            fprintf(stderr, "error: failed to create offscreen image\n");
+            exit(1);
+        }
+
+        VkMemoryRequirements memory_requirements;
+        vkGetImageMemoryRequirements(device, offscreen_images->images[image_index], &memory_requirements);
+
+        const VkMemoryAllocateInfo memory_allocate_info = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            .pNext = NULL,
+            .allocationSize = memory_requirements.size,
+            .memoryTypeIndex = device_find_memory_type_index(physical_device_memory_properties, memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+        };
+
+        if (memory_allocate_info.memoryTypeIndex == UINT32_MAX) {
+            fprintf(stderr, "error: no device local memory for offscreen image\n");
+            exit(1);
+        }
+
+        result = vkAllocateMemory(device, &memory_allocate_info, NULL, &offscreen_images->device_memories[image_index]);
+
+        if (result != VK_SUCCESS) {
+            fprintf(stderr, "error: failed to allocate offscreen image memory\n");
+            exit(1);
+        }
+
+        result = vkBindImageMemory(device, offscreen_images->images[image_index], offscreen_images->device_memories[image_index], 0);
+
+        if (result != VK_SUCCESS) {
+            fprintf(stderr, "error: failed to bind offscreen image memory\n");
+            exit(1);
+        }
+
+        const VkImageViewCreateInfo image_view_create_info = {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .pNext = NULL,
+            .flags = 0,
+            .image = offscreen_images->images[image_index],
+            .viewType = VK_IMAGE_VIEW_TYPE_2D,
+            .format = format,
+            .components.r = VK_COMPONENT_SWIZZLE_IDENTITY,
+            .components.g = VK_COMPONENT_SWIZZLE_IDENTITY,
+            .components.b = VK_COMPONENT_SWIZZLE_IDENTITY,
+            .components.a = VK_COMPONENT_SWIZZLE_IDENTITY,
+            .subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .subresourceRange.baseMipLevel = 0,
+            .subresourceRange.levelCount = 1,
+            .subresourceRange.baseArrayLayer = 0,
+            .subresourceRange.layerCount = 1
+        };
+
+        result = vkCreateImageView(device, &image_view_create_info, NULL, &offscreen_images->image_views[image_index]);
+
+        if (result != VK_SUCCESS) {
+            fprintf(stderr, "error: failed to create image view\n");
+            exit(1);
+        }
+    }
+
+    return offscreen_images;
+}
+
+void offscreen_images_destroy(const VkDevice device, struct offscreen_images *offscreen_images) {
+    for (uint32_t image_index = 0U; image_index < offscreen_images->image_count; ++image_index) {
+        vkDestroyImageView(device, offscreen_images->image_views[image_index], NULL);
+        vkDestroyImage(device, offscreen_images->images[image_index], NULL);
+        vkFreeMemory(device, offscreen_images->device_memories[image_index], NULL);
+    }
+
+    free(offscreen_images->device_memories);
+    free(offscreen_images->image_views);
+    free(offscreen_images->images);
+    free(offscreen_images);
+}
@@ -1,17 +1,26 @@
 #include <pipeline.h>
 
+#include <hash.h>
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
-VkPipelineLayout pipeline_layout_create(const VkDevice device) {
+VkPipelineLayout pipeline_layout_create(
+    const VkDevice device,
+    const uint32_t descriptor_set_layout_count,
+    const VkDescriptorSetLayout *const descriptor_set_layouts,
+    const uint32_t push_constant_range_count,
+    const VkPushConstantRange *const push_constant_ranges
+) {
     const VkPipelineLayoutCreateInfo pipeline_layout_create_info = {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
         .pNext = NULL,
         .flags = 0,
-        .setLayoutCount = 0,
-        .pSetLayouts = NULL,
-        .pushConstantRangeCount = 0,
-        .pPushConstantRanges = NULL
+        .setLayoutCount = descriptor_set_layout_count,
+        .pSetLayouts = descriptor_set_layouts,
+        .pushConstantRangeCount = push_constant_range_count,
+        .pPushConstantRanges = push_constant_ranges
     };
 
     VkPipelineLayout pipeline_layout;
@@ -29,59 +38,370 @@ void pipeline_layout_destroy(const VkPipelineLayout pipeline_layout, const VkDev
     vkDestroyPipelineLayout(device, pipeline_layout, NULL);
 }
 
-VkPipeline graphics_pipeline_create(
-    const VkDevice device,
-    const VkSurfaceCapabilitiesKHR surface_capabilities,
-    const VkRenderPass render_pass,
-    const VkShaderModule vertex_shader_module,
-    const VkShaderModule fragment_shader_module,
-    const VkPipelineLayout graphics_pipeline_layout
+void graphics_pipeline_description_init(struct graphics_pipeline_description *description) {
+    // Zeroed first so padding never reaches the hash or the comparison.
+    memset(description, 0, sizeof *description);
+
+    description->topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    description->polygon_mode = VK_POLYGON_MODE_FILL;
+    description->cull_mode = VK_CULL_MODE_NONE;
+    description->front_face = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    description->sample_count = VK_SAMPLE_COUNT_1_BIT;
+    description->blend_enable = VK_FALSE;
+    description->src_color_blend_factor = VK_BLEND_FACTOR_ONE;
+    description->dst_color_blend_factor = VK_BLEND_FACTOR_ZERO;
+    description->color_blend_op = VK_BLEND_OP_ADD;
+    description->src_alpha_blend_factor = VK_BLEND_FACTOR_ONE;
+    description->dst_alpha_blend_factor = VK_BLEND_FACTOR_ZERO;
+    description->alpha_blend_op = VK_BLEND_OP_ADD;
+    description->color_write_mask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    description->depth_test_enable = VK_FALSE;
+    description->depth_write_enable = VK_FALSE;
+    description->depth_compare_op = VK_COMPARE_OP_LESS_OR_EQUAL;
+}
+
+void graphics_pipeline_description_set_dynamic_states(
+    struct graphics_pipeline_description *description,
+    const uint32_t dynamic_state_flags
+) {
+    description->dynamic_state_flags = dynamic_state_flags;
+
+    if (dynamic_state_flags & GRAPHICS_PIPELINE_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_BIT) {
+        switch (description->topology) {
+            case VK_PRIMITIVE_TOPOLOGY_POINT_LIST:
+            case VK_PRIMITIVE_TOPOLOGY_PATCH_LIST:
+                break;
+            case VK_PRIMITIVE_TOPOLOGY_LINE_LIST:
+            case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP:
+            case VK_PRIMITIVE_TOPOLOGY_LINE_LIST_WITH_ADJACENCY:
+            case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP_WITH_ADJACENCY:
+                description->topology = VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+                break;
+            default:
+                description->topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+                break;
+        }
+    }
+
+    if (dynamic_state_flags & GRAPHICS_PIPELINE_DYNAMIC_STATE_POLYGON_MODE_BIT) {
+        description->polygon_mode = VK_POLYGON_MODE_FILL;
+    }
+
+    if (dynamic_state_flags & GRAPHICS_PIPELINE_DYNAMIC_STATE_CULL_MODE_BIT) {
+        description->cull_mode = VK_CULL_MODE_NONE;
+    }
+
+    if (dynamic_state_flags & GRAPHICS_PIPELINE_DYNAMIC_STATE_FRONT_FACE_BIT) {
+        description->front_face = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    }
+
+    if (dynamic_state_flags & GRAPHICS_PIPELINE_DYNAMIC_STATE_COLOR_BLEND_ENABLE_BIT) {
+        description->blend_enable = VK_FALSE;
+    }
+
+    if (dynamic_state_flags & GRAPHICS_PIPELINE_DYNAMIC_STATE_COLOR_BLEND_EQUATION_BIT) {
+        description->src_color_blend_factor = VK_BLEND_FACTOR_ONE;
+        description->dst_color_blend_factor = VK_BLEND_FACTOR_ZERO;
+        description->color_blend_op = VK_BLEND_OP_ADD;
+        description->src_alpha_blend_factor = VK_BLEND_FACTOR_ONE;
+        description->dst_alpha_blend_factor = VK_BLEND_FACTOR_ZERO;
+        description->alpha_blend_op = VK_BLEND_OP_ADD;
+    }
+
+    if (dynamic_state_flags & GRAPHICS_PIPELINE_DYNAMIC_STATE_DEPTH_TEST_ENABLE_BIT) {
+        description->depth_test_enable = VK_FALSE;
+    }
+
+    if (dynamic_state_flags & GRAPHICS_PIPELINE_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_BIT) {
+        description->depth_write_enable = VK_FALSE;
+    }
+
+    if (dynamic_state_flags & GRAPHICS_PIPELINE_DYNAMIC_STATE_DEPTH_COMPARE_OP_BIT) {
+        description->depth_compare_op = VK_COMPARE_OP_LESS_OR_EQUAL;
+    }
+}
+
+struct graphics_pipeline_dynamic_state graphics_pipeline_description_get_dynamic_state(
+    const struct graphics_pipeline_description *const description
+) {
+    return (struct graphics_pipeline_dynamic_state) {
+        .topology = description->topology,
+        .polygon_mode = description->polygon_mode,
+        .cull_mode = description->cull_mode,
+        .front_face = description->front_face,
+        .blend_enable = description->blend_enable,
+        .color_blend_equation.srcColorBlendFactor = description->src_color_blend_factor,
+        .color_blend_equation.dstColorBlendFactor = description->dst_color_blend_factor,
+        .color_blend_equation.colorBlendOp = description->color_blend_op,
+        .color_blend_equation.srcAlphaBlendFactor = description->src_alpha_blend_factor,
+        .color_blend_equation.dstAlphaBlendFactor = description->dst_alpha_blend_factor,
+        .color_blend_equation.alphaBlendOp = description->alpha_blend_op,
+        .depth_test_enable = description->depth_test_enable,
+        .depth_write_enable = description->depth_write_enable,
+        .depth_compare_op = description->depth_compare_op
+    };
+}
+
+void graphics_pipeline_description_set_shaders(
+    struct graphics_pipeline_description *description,
+    const struct shader_module *const vertex_shader_module,
+    const struct shader_module *const fragment_shader_module
+) {
+    description->vertex_shader_module = vertex_shader_module->handle;
+    description->fragment_shader_module = fragment_shader_module->handle;
+    description->vertex_shader_content_hash = vertex_shader_module->content_hash[0];
+    description->fragment_shader_content_hash = fragment_shader_module->content_hash[0];
+}
+
+void graphics_pipeline_description_set_specialization_constant(
+    struct graphics_pipeline_description *description,
+    const struct shader_module *const shader_module,
+    const char *const name,
+    const uint32_t value
+) {
+    const struct shader_reflection *const reflection = &shader_module->reflection;
+    const struct shader_reflection_specialization_constant *constant = NULL;
+
+    for (uint32_t constant_index = 0U; constant_index < reflection->specialization_constant_count; ++constant_index) {
+        if (strcmp(reflection->specialization_constants[constant_index].name, name) == 0) {
+            constant = &reflection->specialization_constants[constant_index];
+            break;
+        }
+    }
+
+    if (constant == NULL) {
+        fprintf(stderr, "error: shader has no specialization constant named %s\n", name);
+        exit(1);
+    }
+
+    struct graphics_pipeline_specialization *specialization;
+
+    if (reflection->stage == VK_SHADER_STAGE_VERTEX_BIT) {
+        specialization = &description->vertex_specialization;
+    } else if (reflection->stage == VK_SHADER_STAGE_FRAGMENT_BIT) {
+        specialization = &description->fragment_specialization;
+    } else {
+        fprintf(stderr, "error: specialization constant %s is not in a graphics shader stage\n", name);
+        exit(1);
+    }
+
+    uint32_t insert_index = 0U;
+
+    for (; insert_index < specialization->constant_count && specialization->constant_ids[insert_index] < constant->constant_id; ++insert_index);
+
+    if (insert_index < specialization->constant_count && specialization->constant_ids[insert_index] == constant->constant_id) {
+        specialization->values[insert_index] = value;
+        return;
+    }
+
+    if (specialization->constant_count == GRAPHICS_PIPELINE_MAX_SPECIALIZATION_CONSTANTS) {
+        fprintf(stderr, "error: too many specialization constants\n");
+        exit(1);
+    }
+
+    for (uint32_t constant_index = specialization->constant_count; constant_index > insert_index; --constant_index) {
+        specialization->constant_ids[constant_index] = specialization->constant_ids[constant_index - 1U];
+        specialization->values[constant_index] = specialization->values[constant_index - 1U];
+    }
+
+    specialization->constant_ids[insert_index] = constant->constant_id;
+    specialization->values[insert_index] = value;
+    ++specialization->constant_count;
+}
+
+void graphics_pipeline_description_set_vertex_input(
+    struct graphics_pipeline_description *description,
+    const struct shader_reflection *const vertex_shader_reflection
 ) {
-    // Refernce structure of vertex data array. It is actually created in the
-    // vertex buffer section.
+    if (vertex_shader_reflection->input_count > GRAPHICS_PIPELINE_MAX_VERTEX_ATTRIBUTES) {
+        fprintf(stderr, "error: vertex shader has too many inputs\n");
+        exit(1);
+    }
 
-    // const float vertex_data[] = {
-    //     0.0f, -0.5f,       // Position #1 // Vertex #1
-    //     1.0f,  0.0f, 0.0f, // Color #1    //
+    struct shader_reflection_input inputs[SHADER_REFLECTION_MAX_INPUTS];
+    memcpy(inputs, vertex_shader_reflection->inputs, vertex_shader_reflection->input_count * (sizeof *inputs));
 
-    //    -0.5f,  0.5f,       // Position #2 // Vertex #2
-    //     0.0f,  1.0f, 0.0f, // Color #2    //
+    for (uint32_t input_index = 1U; input_index < vertex_shader_reflection->input_count; ++input_index) {
+        const struct shader_reflection_input input = inputs[input_index];
+        uint32_t insert_index = input_index;
 
-    //     0.5f,  0.5f,       // Position #3 // Vertex #3
-    //     0.0f,  0.0f, 1.0f  // Color #3    //
-    // };
+        for (; insert_index > 0U && inputs[insert_index - 1U].location > input.location; --insert_index) {
+            inputs[insert_index] = inputs[insert_index - 1U];
+        }
 
-    // TODO Not a hard-coded vertex buffer layout (offset and stride).
+        inputs[insert_index] = input;
+    }
+
+    uint32_t offset = 0U;
+
+    for (uint32_t input_index = 0U; input_index < vertex_shader_reflection->input_count; ++input_index) {
+        if (inputs[input_index].format == VK_FORMAT_UNDEFINED) {
+            fprintf(stderr, "error: vertex shader input at location %u has an unsupported type\n", inputs[input_index].location);
+            exit(1);
+        }
 
-    const VkVertexInputBindingDescription vertex_input_bindings_description = {
+        description->vertex_attributes[input_index] = (struct graphics_pipeline_vertex_attribute) {
+            .location = inputs[input_index].location,
+            .format = inputs[input_index].format,
+            .offset = offset
+        };
+
+        offset += inputs[input_index].size;
+    }
+
+    description->vertex_attribute_count = vertex_shader_reflection->input_count;
+    description->vertex_stride = offset;
+}
+
+uint64_t graphics_pipeline_description_hash(const struct graphics_pipeline_description *const description) {
+    return hash_bytes(description, sizeof *description, 0U);
+}
+
+bool graphics_pipeline_description_equal(
+    const struct graphics_pipeline_description *const description_a,
+    const struct graphics_pipeline_description *const description_b
+) {
+    return memcmp(description_a, description_b, sizeof *description_a) == 0;
+}
+
+static void graphics_pipeline_specialization_info_fill(
+    const struct graphics_pipeline_specialization *const specialization,
+    VkSpecializationMapEntry *map_entries,
+    VkSpecializationInfo *specialization_info
+) {
+    for (uint32_t constant_index = 0U; constant_index < specialization->constant_count; ++constant_index) {
+        map_entries[constant_index] = (VkSpecializationMapEntry) {
+            .constantID = specialization->constant_ids[constant_index],
+            .offset = constant_index * (uint32_t) sizeof (uint32_t),
+            .size = sizeof (uint32_t)
+        };
+    }
+
+    *specialization_info = (VkSpecializationInfo) {
+        .mapEntryCount = specialization->constant_count,
+        .pMapEntries = map_entries,
+        .dataSize = specialization->constant_count * sizeof (uint32_t),
+        .pData = specialization->values
+    };
+}
+
+void graphics_pipeline_description_get_library_part(
+    const struct graphics_pipeline_description *const description,
+    const VkGraphicsPipelineLibraryFlagBitsEXT library_part,
+    struct graphics_pipeline_description *part_description
+) {
+    graphics_pipeline_description_init(part_description);
+
+    part_description->dynamic_state_flags = description->dynamic_state_flags;
+
+    switch (library_part) {
+        case VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT:
+            part_description->vertex_stride = description->vertex_stride;
+            part_description->vertex_attribute_count = description->vertex_attribute_count;
+            memcpy(part_description->vertex_attributes, description->vertex_attributes, sizeof description->vertex_attributes);
+            part_description->topology = description->topology;
+            break;
+        case VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT:
+            part_description->vertex_shader_module = description->vertex_shader_module;
+            part_description->vertex_shader_content_hash = description->vertex_shader_content_hash;
+            part_description->vertex_specialization = description->vertex_specialization;
+            part_description->pipeline_layout = description->pipeline_layout;
+            part_description->render_pass = description->render_pass;
+            part_description->subpass = description->subpass;
+            part_description->color_attachment_format = description->color_attachment_format;
+            part_description->depth_attachment_format = description->depth_attachment_format;
+            part_description->polygon_mode = description->polygon_mode;
+            part_description->cull_mode = description->cull_mode;
+            part_description->front_face = description->front_face;
+            break;
+        case VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT:
+            part_description->fragment_shader_module = description->fragment_shader_module;
+            part_description->fragment_shader_content_hash = description->fragment_shader_content_hash;
+            part_description->fragment_specialization = description->fragment_specialization;
+            part_description->pipeline_layout = description->pipeline_layout;
+            part_description->render_pass = description->render_pass;
+            part_description->subpass = description->subpass;
+            part_description->color_attachment_format = description->color_attachment_format;
+            part_description->depth_attachment_format = description->depth_attachment_format;
+            part_description->sample_count = description->sample_count;
+            part_description->depth_test_enable = description->depth_test_enable;
+            part_description->depth_write_enable = description->depth_write_enable;
+            part_description->depth_compare_op = description->depth_compare_op;
+            break;
+        case VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT:
+            part_description->render_pass = description->render_pass;
+            part_description->subpass = description->subpass;
+            part_description->color_attachment_format = description->color_attachment_format;
+            part_description->depth_attachment_format = description->depth_attachment_format;
+            part_description->sample_count = description->sample_count;
+            part_description->blend_enable = description->blend_enable;
+            part_description->src_color_blend_factor = description->src_color_blend_factor;
+            part_description->dst_color_blend_factor = description->dst_color_blend_factor;
+            part_description->color_blend_op = description->color_blend_op;
+            part_description->src_alpha_blend_factor = description->src_alpha_blend_factor;
+            part_description->dst_alpha_blend_factor = description->dst_alpha_blend_factor;
+            part_description->alpha_blend_op = description->alpha_blend_op;
+            part_description->color_write_mask = description->color_write_mask;
+            break;
+        default:
+            fprintf(stderr, "error: invalid graphics pipeline library part\n");
+            exit(1);
+    }
+}
+
+// Creates the complete pipeline when library_parts is 0 and otherwise a
+// library holding just the given parts. State that does not belong to the
+// parts is left out.
+static VkPipeline graphics_pipeline_create_parts(
+    const VkDevice device,
+    const VkPipelineCache pipeline_cache,
+    const struct graphics_pipeline_description *const description,
+    const VkGraphicsPipelineLibraryFlagsEXT library_parts
+) {
+    const VkGraphicsPipelineLibraryFlagsEXT parts = library_parts ? library_parts :
+        VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT |
+        VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT |
+        VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT |
+        VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT;
+
+    const bool has_vertex_input = parts & VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT;
+    const bool has_pre_rasterization = parts & VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT;
+    const bool has_fragment_shader = parts & VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT;
+    const bool has_fragment_output = parts & VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT;
+
+    VkSpecializationMapEntry vertex_specialization_map_entries[GRAPHICS_PIPELINE_MAX_SPECIALIZATION_CONSTANTS];
+    VkSpecializationMapEntry fragment_specialization_map_entries[GRAPHICS_PIPELINE_MAX_SPECIALIZATION_CONSTANTS];
+    VkSpecializationInfo vertex_specialization_info;
+    VkSpecializationInfo fragment_specialization_info;
+
+    graphics_pipeline_specialization_info_fill(&description->vertex_specialization, vertex_specialization_map_entries, &vertex_specialization_info);
+    graphics_pipeline_specialization_info_fill(&description->fragment_specialization, fragment_specialization_map_entries, &fragment_specialization_info);
+
+    const VkVertexInputBindingDescription vertex_input_binding_description = {
         .binding = 0,
-        .stride = 2 * sizeof (float) + 3 * sizeof (float),
+        .stride = description->vertex_stride,
         .inputRate = VK_VERTEX_INPUT_RATE_VERTEX
     };
 
-    const VkVertexInputAttributeDescription vertex_input_attribute_description[] = {
-        {
-            .location = 0,
-            .binding = 0,
-            .format = VK_FORMAT_R32G32_SFLOAT,
-            .offset = 0 * sizeof (float),
-        },
-        {
-            .location = 1,
+    VkVertexInputAttributeDescription vertex_input_attribute_descriptions[GRAPHICS_PIPELINE_MAX_VERTEX_ATTRIBUTES];
+
+    for (uint32_t attribute_index = 0U; attribute_index < description->vertex_attribute_count; ++attribute_index) {
+        vertex_input_attribute_descriptions[attribute_index] = (VkVertexInputAttributeDescription) {
+            .location = description->vertex_attributes[attribute_index].location,
             .binding = 0,
-            .format = VK_FORMAT_R32G32B32_SFLOAT,
-            .offset = 2 * sizeof (float),
-        },
-    };
+            .format = description->vertex_attributes[attribute_index].format,
+            .offset = description->vertex_attributes[attribute_index].offset
+        };
+    }
 
     const VkPipelineShaderStageCreateInfo graphics_pipeline_vertex_shader_stage_create_info = {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
         .pNext = NULL,
         .flags = 0,
         .stage = VK_SHADER_STAGE_VERTEX_BIT,
-        .module = vertex_shader_module,
+        .module = description->vertex_shader_module,
         .pName = "main",
-        .pSpecializationInfo = NULL
+        .pSpecializationInfo = description->vertex_specialization.constant_count ? &vertex_specialization_info : NULL
     };
 
     const VkPipelineShaderStageCreateInfo graphics_pipeline_fragment_shader_stage_create_info = {
@@ -89,71 +409,85 @@ VkPipeline graphics_pipeline_create(
         .pNext = NULL,
         .flags = 0,
         .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
-        .module = fragment_shader_module,
+        .module = description->fragment_shader_module,
         .pName = "main",
-        .pSpecializationInfo = NULL
+        .pSpecializationInfo = description->fragment_specialization.constant_count ? &fragment_specialization_info : NULL
     };
 
-    const VkPipelineShaderStageCreateInfo graphics_pipeline_shader_stage_create_infos[] = {
-        graphics_pipeline_vertex_shader_stage_create_info,
-        graphics_pipeline_fragment_shader_stage_create_info
-    };
+    VkPipelineShaderStageCreateInfo graphics_pipeline_shader_stage_create_infos[2];
+    uint32_t graphics_pipeline_shader_stage_count = 0U;
+
+    if (has_pre_rasterization) {
+        graphics_pipeline_shader_stage_create_infos[graphics_pipeline_shader_stage_count++] = graphics_pipeline_vertex_shader_stage_create_info;
+    }
+
+    if (has_fragment_shader) {
+        graphics_pipeline_shader_stage_create_infos[graphics_pipeline_shader_stage_count++] = graphics_pipeline_fragment_shader_stage_create_info;
+    }
 
     const VkPipelineVertexInputStateCreateInfo graphics_pipeline_vertex_input_state_create_info = {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
         .pNext = NULL,
         .flags = 0,
-        .vertexBindingDescriptionCount = 1,
-        .pVertexBindingDescriptions = &vertex_input_bindings_description,
-        .vertexAttributeDescriptionCount = 2,
-        .pVertexAttributeDescriptions = vertex_input_attribute_description
+        .vertexBindingDescriptionCount = description->vertex_attribute_count > 0 ? 1 : 0,
+        .pVertexBindingDescriptions = &vertex_input_binding_description,
+        .vertexAttributeDescriptionCount = description->vertex_attribute_count,
+        .pVertexAttributeDescriptions = vertex_input_attribute_descriptions
     };
 
     const VkPipelineInputAssemblyStateCreateInfo graphics_pipeline_input_assembly_state_create_info = {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
         .pNext = NULL,
         .flags = 0,
-        .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+        .topology = description->topology,
         .primitiveRestartEnable = VK_FALSE
     };
 
-    const VkDynamicState dynamic_states[] = {
+    static const struct {
+        uint32_t flag;
+        VkDynamicState dynamic_state;
+    } extended_dynamic_states[] = {
+        {GRAPHICS_PIPELINE_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_BIT, VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_EXT},
+        {GRAPHICS_PIPELINE_DYNAMIC_STATE_CULL_MODE_BIT, VK_DYNAMIC_STATE_CULL_MODE_EXT},
+        {GRAPHICS_PIPELINE_DYNAMIC_STATE_FRONT_FACE_BIT, VK_DYNAMIC_STATE_FRONT_FACE_EXT},
+        {GRAPHICS_PIPELINE_DYNAMIC_STATE_DEPTH_TEST_ENABLE_BIT, VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE_EXT},
+        {GRAPHICS_PIPELINE_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_BIT, VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_EXT},
+        {GRAPHICS_PIPELINE_DYNAMIC_STATE_DEPTH_COMPARE_OP_BIT, VK_DYNAMIC_STATE_DEPTH_COMPARE_OP_EXT},
+        {GRAPHICS_PIPELINE_DYNAMIC_STATE_POLYGON_MODE_BIT, VK_DYNAMIC_STATE_POLYGON_MODE_EXT},
+        {GRAPHICS_PIPELINE_DYNAMIC_STATE_COLOR_BLEND_ENABLE_BIT, VK_DYNAMIC_STATE_COLOR_BLEND_ENABLE_EXT},
+        {GRAPHICS_PIPELINE_DYNAMIC_STATE_COLOR_BLEND_EQUATION_BIT, VK_DYNAMIC_STATE_COLOR_BLEND_EQUATION_EXT}
+    };
+
+    VkDynamicState dynamic_states[2U + (sizeof extended_dynamic_states) / (sizeof *extended_dynamic_states)] = {
         VK_DYNAMIC_STATE_VIEWPORT,
         VK_DYNAMIC_STATE_SCISSOR
     };
 
+    uint32_t dynamic_state_count = 2U;
+
+    for (size_t state_index = 0; state_index < (sizeof extended_dynamic_states) / (sizeof *extended_dynamic_states); ++state_index) {
+        if (description->dynamic_state_flags & extended_dynamic_states[state_index].flag) {
+            dynamic_states[dynamic_state_count++] = extended_dynamic_states[state_index].dynamic_state;
+        }
+    }
+
     const VkPipelineDynamicStateCreateInfo graphics_pipeline_dynamic_state_create_info = {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
         .pNext = NULL,
         .flags = 0,
-        .dynamicStateCount = 2,
+        .dynamicStateCount = dynamic_state_count,
         .pDynamicStates = dynamic_states,
     };
 
-    const VkViewport graphics_pipeline_viewport = {
-        .x = 0,
-        .y = 0,
-        .width = surface_capabilities.currentExtent.width,
-        .height = surface_capabilities.currentExtent.height,
-        .minDepth = 0.0f,
-        .maxDepth = 1.0f
-    };
-
-    const VkRect2D graphics_pipeline_scissor = {
-        .offset.x = 0,
-        .offset.y = 0,
-        .extent.width = surface_capabilities.currentExtent.width,
-        .extent.height = surface_capabilities.currentExtent.height
-    };
-
+    // Viewport and scissor are dynamic, only their counts are used.
     const VkPipelineViewportStateCreateInfo graphics_pipeline_viewport_state_create_info = {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
         .pNext = NULL,
         .flags = 0,
         .viewportCount = 1,
-        .pViewports = &graphics_pipeline_viewport,
+        .pViewports = NULL,
         .scissorCount = 1,
-        .pScissors = &graphics_pipeline_scissor
+        .pScissors = NULL
     };
 
     const VkPipelineRasterizationStateCreateInfo graphics_pipeline_restirazion_state_create_info = {
@@ -162,9 +496,9 @@ VkPipeline graphics_pipeline_create(
         .flags = 0,
         .depthClampEnable = VK_FALSE,
         .rasterizerDiscardEnable = VK_FALSE,
-        .polygonMode = VK_POLYGON_MODE_FILL,
-        .cullMode = VK_CULL_MODE_BACK_BIT,
-        .frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE,
+        .polygonMode = description->polygon_mode,
+        .cullMode = description->cull_mode,
+        .frontFace = description->front_face,
         .depthBiasEnable = VK_FALSE,
         .depthBiasConstantFactor = 0.0f,
         .depthBiasClamp = 0.0f,
@@ -176,7 +510,7 @@ VkPipeline graphics_pipeline_create(
         .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
         .pNext = NULL,
         .flags = 0,
-        .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+        .rasterizationSamples = description->sample_count,
         .sampleShadingEnable = VK_FALSE,
         .minSampleShading = 1.0f,
         .pSampleMask = NULL,
@@ -184,15 +518,28 @@ VkPipeline graphics_pipeline_create(
         .alphaToOneEnable = VK_FALSE
     };
 
+    const VkPipelineDepthStencilStateCreateInfo graphics_pipeline_depth_stencil_state_create_info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+        .pNext = NULL,
+        .flags = 0,
+        .depthTestEnable = description->depth_test_enable,
+        .depthWriteEnable = description->depth_write_enable,
+        .depthCompareOp = description->depth_compare_op,
+        .depthBoundsTestEnable = VK_FALSE,
+        .stencilTestEnable = VK_FALSE,
+        .minDepthBounds = 0.0f,
+        .maxDepthBounds = 1.0f
+    };
+
     const VkPipelineColorBlendAttachmentState graphics_pipeline_color_blend_attachment_state = {
-        .blendEnable = VK_TRUE,
-        .srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA,
-        .dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
-        .colorBlendOp = VK_BLEND_OP_ADD,
-        .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
-        .dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
-        .alphaBlendOp = VK_BLEND_OP_ADD,
-        .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT
+        .blendEnable = description->blend_enable,
+        .srcColorBlendFactor = description->src_color_blend_factor,
+        .dstColorBlendFactor = description->dst_color_blend_factor,
+        .colorBlendOp = description->color_blend_op,
+        .srcAlphaBlendFactor = description->src_alpha_blend_factor,
+        .dstAlphaBlendFactor = description->dst_alpha_blend_factor,
+        .alphaBlendOp = description->alpha_blend_op,
+        .colorWriteMask = description->color_write_mask
     };
 
     const VkPipelineColorBlendStateCreateInfo graphics_pipeline_color_blend_state_create_info = {
@@ -209,42 +556,162 @@ VkPipeline graphics_pipeline_create(
         .blendConstants[3] = 0.0f
     };
 
+    const VkGraphicsPipelineLibraryCreateInfoEXT graphics_pipeline_library_create_info = {
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT,
+        .pNext = NULL,
+        .flags = library_parts
+    };
+
+    const bool uses_attachments = has_pre_rasterization || has_fragment_shader || has_fragment_output;
+
+    const VkPipelineRenderingCreateInfoKHR pipeline_rendering_create_info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR,
+        .pNext = library_parts ? &graphics_pipeline_library_create_info : NULL,
+        .viewMask = 0,
+        .colorAttachmentCount = 1,
+        .pColorAttachmentFormats = &description->color_attachment_format,
+        .depthAttachmentFormat = description->depth_attachment_format,
+        .stencilAttachmentFormat = VK_FORMAT_UNDEFINED
+    };
+
+    const void *graphics_pipeline_create_info_next = library_parts ? &graphics_pipeline_library_create_info : NULL;
+
+    if (uses_attachments && description->render_pass == VK_NULL_HANDLE) {
+        graphics_pipeline_create_info_next = &pipeline_rendering_create_info;
+    }
+
+    // Dynamic state outside of the parts of a library is ignored.
     const VkGraphicsPipelineCreateInfo graphics_pipeline_create_info = {
         .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-        .pNext = NULL,
-        .flags = 0,
-        .stageCount = (sizeof graphics_pipeline_shader_stage_create_infos) / (sizeof *graphics_pipeline_shader_stage_create_infos),
+        .pNext = graphics_pipeline_create_info_next,
+        .flags = library_parts ? VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT : 0,
+        .stageCount = graphics_pipeline_shader_stage_count,
         .pStages = graphics_pipeline_shader_stage_create_infos,
-        .pVertexInputState = &graphics_pipeline_vertex_input_state_create_info,
-        .pInputAssemblyState = &graphics_pipeline_input_assembly_state_create_info,
+        .pVertexInputState = has_vertex_input ? &graphics_pipeline_vertex_input_state_create_info : NULL,
+        .pInputAssemblyState = has_vertex_input ? &graphics_pipeline_input_assembly_state_create_info : NULL,
         .pTessellationState = NULL,
-        .pViewportState = &graphics_pipeline_viewport_state_create_info,
-        .pRasterizationState = &graphics_pipeline_restirazion_state_create_info,
-        .pMultisampleState = &graphics_pipeline_multisample_state_create_info,
-        .pDepthStencilState = NULL,
-        .pColorBlendState = &graphics_pipeline_color_blend_state_create_info,
+        .pViewportState = has_pre_rasterization ? &graphics_pipeline_viewport_state_create_info : NULL,
+        .pRasterizationState = has_pre_rasterization ? &graphics_pipeline_restirazion_state_create_info : NULL,
+        .pMultisampleState = has_fragment_shader || has_fragment_output ? &graphics_pipeline_multisample_state_create_info : NULL,
+        .pDepthStencilState = has_fragment_shader ? &graphics_pipeline_depth_stencil_state_create_info : NULL,
+        .pColorBlendState = has_fragment_output ? &graphics_pipeline_color_blend_state_create_info : NULL,
         .pDynamicState = &graphics_pipeline_dynamic_state_create_info,
-        .layout = graphics_pipeline_layout,
-        .renderPass = render_pass,
-        .subpass = 0,
+        .layout = has_pre_rasterization || has_fragment_shader ? description->pipeline_layout : VK_NULL_HANDLE,
+        .renderPass = uses_attachments ? description->render_pass : VK_NULL_HANDLE,
+        .subpass = description->subpass,
         .basePipelineHandle = VK_NULL_HANDLE,
         .basePipelineIndex = -1
     };
 
     VkPipeline graphics_pipeline = VK_NULL_HANDLE;
-    VkResult result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &graphics_pipeline_create_info, NULL, &graphics_pipeline);
+    VkResult result = vkCreateGraphicsPipelines(device, pipeline_cache, 1, &graphics_pipeline_create_info, NULL, &graphics_pipeline);
 
     if (result != VK_SUCCESS) {
-        fprintf(stderr, "error: failed to create graphics pipeline\n");
+        fprintf(stderr, library_parts ? "error: failed to create graphics pipeline library\n" : "error: failed to create graphics pipeline\n");
         exit(1);
     }
 
-    vkDestroyShaderModule(device, fragment_shader_module, NULL);
-    vkDestroyShaderModule(device, vertex_shader_module, NULL);
+    return graphics_pipeline;
+}
+
+VkPipeline graphics_pipeline_create(
+    const VkDevice device,
+    const VkPipelineCache pipeline_cache,
+    const struct graphics_pipeline_description *const description
+) {
+    return graphics_pipeline_create_parts(device, pipeline_cache, description, 0);
+}
+
+VkPipeline graphics_pipeline_library_create(
+    const VkDevice device,
+    const VkPipelineCache pipeline_cache,
+    const struct graphics_pipeline_description *const description,
+    const VkGraphicsPipelineLibraryFlagBitsEXT library_part
+) {
+    return graphics_pipeline_create_parts(device, pipeline_cache, description, library_part);
+}
+
+VkPipeline graphics_pipeline_library_link(
+    const VkDevice device,
+    const VkPipelineCache pipeline_cache,
+    const VkPipelineLayout pipeline_layout,
+    const uint32_t library_count,
+    const VkPipeline *const libraries,
+    const bool optimize
+) {
+    const VkPipelineLibraryCreateInfoKHR pipeline_library_create_info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR,
+        .pNext = NULL,
+        .libraryCount = library_count,
+        .pLibraries = libraries
+    };
+
+    const VkGraphicsPipelineCreateInfo graphics_pipeline_create_info = {
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .pNext = &pipeline_library_create_info,
+        .flags = optimize ? VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT : 0,
+        .stageCount = 0,
+        .pStages = NULL,
+        .pVertexInputState = NULL,
+        .pInputAssemblyState = NULL,
+        .pTessellationState = NULL,
+        .pViewportState = NULL,
+        .pRasterizationState = NULL,
+        .pMultisampleState = NULL,
+        .pDepthStencilState = NULL,
+        .pColorBlendState = NULL,
+        .pDynamicState = NULL,
+        .layout = pipeline_layout,
+        .renderPass = VK_NULL_HANDLE,
+        .subpass = 0,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = -1
+    };
+
+    VkPipeline graphics_pipeline = VK_NULL_HANDLE;
+    VkResult result = vkCreateGraphicsPipelines(device, pipeline_cache, 1, &graphics_pipeline_create_info, NULL, &graphics_pipeline);
+
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "error: failed to link graphics pipeline\n");
+        exit(1);
+    }
 
     return graphics_pipeline;
 }
 
+VkPipeline compute_pipeline_create(
+    const VkDevice device,
+    const VkPipelineCache pipeline_cache,
+    const VkShaderModule compute_shader_module,
+    const VkPipelineLayout compute_pipeline_layout
+) {
+    const VkComputePipelineCreateInfo compute_pipeline_create_info = {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .pNext = NULL,
+        .flags = 0,
+        .stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+        .stage.pNext = NULL,
+        .stage.flags = 0,
+        .stage.stage = VK_SHADER_STAGE_COMPUTE_BIT,
+        .stage.module = compute_shader_module,
+        .stage.pName = "main",
+        .stage.pSpecializationInfo = NULL,
+        .layout = compute_pipeline_layout,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = -1
+    };
+
+    VkPipeline compute_pipeline = VK_NULL_HANDLE;
+    VkResult result = vkCreateComputePipelines(device, pipeline_cache, 1, &compute_pipeline_create_info, NULL, &compute_pipeline);
+
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "error: failed to create compute pipeline\n");
+        exit(1);
+    }
+
+    return compute_pipeline;
+}
+
 void pipeline_destroy(const VkDevice device, const VkPipeline pipeline) {
     vkDestroyPipeline(device, pipeline, NULL);
 }
@@ -0,0 +1,159 @@
+#include <pipelinecache.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static bool pipeline_cache_data_is_compatible(
+    const void *const data,
+    const size_t data_size,
+    const VkPhysicalDeviceProperties physical_device_properties
+) {
+    VkPipelineCacheHeaderVersionOne header;
+
+    if (data_size < sizeof header) {
+        return false;
+    }
+
+    memcpy(&header, data, sizeof header);
+
+    return header.headerSize >= sizeof header
+        && header.headerSize <= data_size
+        && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+        && header.vendorID == physical_device_properties.vendorID
+        && header.deviceID == physical_device_properties.deviceID
+        && memcmp(header.pipelineCacheUUID, physical_device_properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+static void *pipeline_cache_read_file(const char *const path, size_t *const size) {
+    FILE *file = fopen(path, "rb");
+
+    if (!file) {
+        return NULL;
+    }
+
+    fseek(file, 0L, SEEK_END);
+    const long file_size = ftell(file);
+    fseek(file, 0L, SEEK_SET);
+
+    if (file_size <= 0) {
+        fclose(file);
+        return NULL;
+    }
+
+    void *data = malloc(file_size);
+
+    if (fread(data, file_size, 1, file) != 1) {
+        free(data);
+        fclose(file);
+        return NULL;
+    }
+
+    fclose(file);
+
+    *size = file_size;
+    return data;
+}
+
+VkPipelineCache pipeline_cache_create(
+    const VkDevice device,
+    const VkPhysicalDeviceProperties physical_device_properties,
+    const char *const path,
+    bool *const loaded
+) {
+    size_t initial_data_size = 0;
+    void *initial_data = pipeline_cache_read_file(path, &initial_data_size);
+
+    if (initial_data && !pipeline_cache_data_is_compatible(initial_data, initial_data_size, physical_device_properties)) {
+        printf("info: discarding pipeline cache '%s' written by another driver or device\n", path);
+        free(initial_data);
+        initial_data = NULL;
+        initial_data_size = 0;
+    }
+
+    const VkPipelineCacheCreateInfo pipeline_cache_create_info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .pNext = NULL,
+        .flags = 0,
+        .initialDataSize = initial_data_size,
+        .pInitialData = initial_data
+    };
+
+    VkPipelineCache pipeline_cache = VK_NULL_HANDLE;
+    VkResult result = vkCreatePipelineCache(device, &pipeline_cache_create_info, NULL, &pipeline_cache);
+
+    if (loaded) {
+        *loaded = initial_data != NULL;
+    }
+
+    free(initial_data);
+
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "error: failed to create pipeline cache\n");
+        exit(1);
+    }
+
+    return pipeline_cache;
+}
+
+size_t pipeline_cache_get_data_size(const VkDevice device, const VkPipelineCache pipeline_cache) {
+    size_t data_size = 0;
+    VkResult result = vkGetPipelineCacheData(device, pipeline_cache, &data_size, NULL);
+
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "error: failed to query pipeline cache data size\n");
+        exit(1);
+    }
+
+    return data_size;
+}
+
+void pipeline_cache_save(const VkDevice device, const VkPipelineCache pipeline_cache, const char *const path) {
+    size_t data_size = 0;
+    void *data = NULL;
+    VkResult result = VK_INCOMPLETE;
+
+    // Compiler threads may add pipelines between the size query and the copy,
+    // in which case the copy is incomplete and the size is queried again.
+    while (result == VK_INCOMPLETE) {
+        free(data);
+        data_size = pipeline_cache_get_data_size(device, pipeline_cache);
+        data = malloc(data_size);
+        result = vkGetPipelineCacheData(device, pipeline_cache, &data_size, data);
+    }
+
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "error: failed to get pipeline cache data\n");
+        exit(1);
+    }
+
+    const size_t temporary_path_size = strlen(path) + sizeof ".tmp";
+    char *temporary_path = malloc(temporary_path_size);
+    snprintf(temporary_path, temporary_path_size, "%s.tmp", path);
+
+    FILE *file = fopen(temporary_path, "wb");
+
+    // A cache that cannot be written only costs compile time on the next start.
+    if (!file) {
+        fprintf(stderr, "warning: failed to open '%s' for writing\n", temporary_path);
+        free(temporary_path);
+        free(data);
+        return;
+    }
+
+    const bool written = fwrite(data, data_size, 1, file) == 1 && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    fclose(file);
+
+    if (!written || rename(temporary_path, path) != 0) {
+        fprintf(stderr, "warning: failed to write pipeline cache '%s'\n", path);
+        remove(temporary_path);
+    }
+
+    free(temporary_path);
+    free(data);
+}
+
+void pipeline_cache_destroy(const VkDevice device, const VkPipelineCache pipeline_cache) {
+    vkDestroyPipelineCache(device, pipeline_cache, NULL);
+}
@@ -0,0 +1,662 @@
+#include <pipelinecompiler.h>
+
+#include <hash.h>
+#include <pipeline.h>
+#include <pipelinecache.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static const VkGraphicsPipelineLibraryFlagBitsEXT pipeline_compiler_library_parts[PIPELINE_COMPILER_LIBRARY_PART_COUNT] = {
+    VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT,
+    VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT,
+    VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT,
+    VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT
+};
+
+static double pipeline_compiler_get_time(void) {
+    struct timespec timespec;
+    clock_gettime(CLOCK_MONOTONIC, &timespec);
+    return timespec.tv_sec + timespec.tv_nsec / 1e9;
+}
+
+static struct pipeline_future *pipeline_future_create(
+    const struct graphics_pipeline_description *const description,
+    const VkGraphicsPipelineLibraryFlagBitsEXT library_part
+) {
+    struct pipeline_future *pipeline_future = malloc(sizeof *pipeline_future);
+
+    atomic_init(&pipeline_future->state, PIPELINE_FUTURE_STATE_PENDING);
+    atomic_init(&pipeline_future->pipeline, VK_NULL_HANDLE);
+    pipeline_future->fast_linked_pipeline = VK_NULL_HANDLE;
+    pipeline_future->compile_time = 0.0;
+    pipeline_future->description = *description;
+    pipeline_future->library_part = library_part;
+    pipeline_future->reference_count = 0U;
+    pipeline_future->job_count = 0U;
+    pipeline_future->next_job = NULL;
+    pipeline_future->next_retired = NULL;
+    pipeline_future->retire_frame = 0U;
+    pthread_mutex_init(&pipeline_future->mutex, NULL);
+    pthread_cond_init(&pipeline_future->condition, NULL);
+
+    for (uint32_t part_index = 0U; part_index < PIPELINE_COMPILER_LIBRARY_PART_COUNT; ++part_index) {
+        pipeline_future->libraries[part_index] = NULL;
+    }
+
+    return pipeline_future;
+}
+
+static void pipeline_future_destroy(const VkDevice device, struct pipeline_future *pipeline_future) {
+    const VkPipeline pipeline = atomic_load_explicit(&pipeline_future->pipeline, memory_order_relaxed);
+
+    if (pipeline_future->fast_linked_pipeline != pipeline) {
+        pipeline_destroy(device, pipeline_future->fast_linked_pipeline);
+    }
+
+    pipeline_destroy(device, pipeline);
+    pthread_cond_destroy(&pipeline_future->condition);
+    pthread_mutex_destroy(&pipeline_future->mutex);
+    free(pipeline_future);
+}
+
+static void pipeline_future_complete(struct pipeline_future *pipeline_future, const VkPipeline pipeline, const double compile_time) {
+    pthread_mutex_lock(&pipeline_future->mutex);
+    atomic_store_explicit(&pipeline_future->pipeline, pipeline, memory_order_relaxed);
+    pipeline_future->compile_time = compile_time;
+    atomic_store_explicit(&pipeline_future->state, PIPELINE_FUTURE_STATE_READY, memory_order_release);
+    pthread_cond_broadcast(&pipeline_future->condition);
+    pthread_mutex_unlock(&pipeline_future->mutex);
+}
+
+static void pipeline_compiler_insert_entry(
+    struct pipeline_compiler_entry *entries,
+    const uint32_t entry_capacity,
+    const struct pipeline_compiler_entry entry
+) {
+    uint32_t slot = (uint32_t) entry.hash & (entry_capacity - 1U);
+
+    while (entries[slot].future != NULL) {
+        slot = (slot + 1U) & (entry_capacity - 1U);
+    }
+
+    entries[slot] = entry;
+}
+
+static void pipeline_compiler_grow_entries(struct pipeline_compiler_entry **entries, uint32_t *entry_capacity) {
+    const uint32_t grown_entry_capacity = *entry_capacity * 2U;
+    struct pipeline_compiler_entry *grown_entries = calloc(grown_entry_capacity, sizeof *grown_entries);
+
+    for (uint32_t entry_index = 0U; entry_index < *entry_capacity; ++entry_index) {
+        if ((*entries)[entry_index].future != NULL) {
+            pipeline_compiler_insert_entry(grown_entries, grown_entry_capacity, (*entries)[entry_index]);
+        }
+    }
+
+    free(*entries);
+    *entries = grown_entries;
+    *entry_capacity = grown_entry_capacity;
+}
+
+// Returns the slot of the matching entry, or the empty slot it would go into.
+static uint32_t pipeline_compiler_find_entry(
+    const struct pipeline_compiler_entry *const entries,
+    const uint32_t entry_capacity,
+    const uint64_t hash,
+    const struct graphics_pipeline_description *const description,
+    const VkGraphicsPipelineLibraryFlagBitsEXT library_part
+) {
+    uint32_t slot = (uint32_t) hash & (entry_capacity - 1U);
+
+    while (entries[slot].future != NULL) {
+        if (entries[slot].hash == hash &&
+            entries[slot].future->library_part == library_part &&
+            graphics_pipeline_description_equal(&entries[slot].future->description, description)) {
+            break;
+        }
+
+        slot = (slot + 1U) & (entry_capacity - 1U);
+    }
+
+    return slot;
+}
+
+// Called with the compiler mutex held, the library is referenced by the
+// caller until the caller is destroyed.
+static struct pipeline_future *pipeline_compiler_acquire_library(
+    struct pipeline_compiler *pipeline_compiler,
+    const struct graphics_pipeline_description *const description,
+    const VkGraphicsPipelineLibraryFlagBitsEXT library_part,
+    bool *created
+) {
+    struct graphics_pipeline_description part_description;
+    graphics_pipeline_description_get_library_part(description, library_part, &part_description);
+
+    const uint64_t hash = hash_bytes(&part_description, sizeof part_description, library_part);
+    const uint32_t slot = pipeline_compiler_find_entry(pipeline_compiler->library_entries, pipeline_compiler->library_entry_capacity, hash, &part_description, library_part);
+
+    struct pipeline_future *library = pipeline_compiler->library_entries[slot].future;
+    *created = library == NULL;
+
+    if (library == NULL) {
+        library = pipeline_future_create(&part_description, library_part);
+        pipeline_compiler->library_entries[slot] = (struct pipeline_compiler_entry) {.hash = hash, .future = library};
+        pipeline_compiler->statistics.library_count++;
+
+        if (++pipeline_compiler->library_entry_count * 2U > pipeline_compiler->library_entry_capacity) {
+            pipeline_compiler_grow_entries(&pipeline_compiler->library_entries, &pipeline_compiler->library_entry_capacity);
+        }
+    } else {
+        pipeline_compiler->statistics.library_hit_count++;
+    }
+
+    library->reference_count++;
+
+    return library;
+}
+
+// Builds the parts that no other request has built yet and links them.
+// Parts another worker is still building are waited for.
+static VkPipeline pipeline_compiler_fast_link(struct pipeline_compiler *pipeline_compiler, struct pipeline_future *job) {
+    bool created[PIPELINE_COMPILER_LIBRARY_PART_COUNT];
+
+    pthread_mutex_lock(&pipeline_compiler->mutex);
+
+    for (uint32_t part_index = 0U; part_index < PIPELINE_COMPILER_LIBRARY_PART_COUNT; ++part_index) {
+        job->libraries[part_index] = pipeline_compiler_acquire_library(pipeline_compiler, &job->description, pipeline_compiler_library_parts[part_index], &created[part_index]);
+    }
+
+    pthread_mutex_unlock(&pipeline_compiler->mutex);
+
+    for (uint32_t part_index = 0U; part_index < PIPELINE_COMPILER_LIBRARY_PART_COUNT; ++part_index) {
+        struct pipeline_future *library = job->libraries[part_index];
+
+        if (created[part_index]) {
+            const double start_time = pipeline_compiler_get_time();
+            const VkPipeline pipeline = graphics_pipeline_library_create(pipeline_compiler->device, pipeline_compiler->pipeline_cache, &library->description, library->library_part);
+            pipeline_future_complete(library, pipeline, pipeline_compiler_get_time() - start_time);
+        }
+    }
+
+    // Waiting only after building our own parts keeps workers from waiting on each other in a cycle.
+    VkPipeline libraries[PIPELINE_COMPILER_LIBRARY_PART_COUNT];
+
+    for (uint32_t part_index = 0U; part_index < PIPELINE_COMPILER_LIBRARY_PART_COUNT; ++part_index) {
+        libraries[part_index] = pipeline_future_wait(job->libraries[part_index]);
+    }
+
+    job->fast_linked_pipeline = graphics_pipeline_library_link(
+        pipeline_compiler->device,
+        pipeline_compiler->pipeline_cache,
+        job->description.pipeline_layout,
+        PIPELINE_COMPILER_LIBRARY_PART_COUNT,
+        libraries,
+        false);
+
+    return job->fast_linked_pipeline;
+}
+
+static void pipeline_compiler_optimize_link(struct pipeline_compiler *pipeline_compiler, struct pipeline_future *job) {
+    VkPipeline libraries[PIPELINE_COMPILER_LIBRARY_PART_COUNT];
+
+    for (uint32_t part_index = 0U; part_index < PIPELINE_COMPILER_LIBRARY_PART_COUNT; ++part_index) {
+        libraries[part_index] = atomic_load_explicit(&job->libraries[part_index]->pipeline, memory_order_relaxed);
+    }
+
+    const double start_time = pipeline_compiler_get_time();
+
+    const VkPipeline pipeline = graphics_pipeline_library_link(
+        pipeline_compiler->device,
+        pipeline_compiler->pipeline_cache,
+        job->description.pipeline_layout,
+        PIPELINE_COMPILER_LIBRARY_PART_COUNT,
+        libraries,
+        true);
+
+    const double link_time = pipeline_compiler_get_time() - start_time;
+
+    // The fast linked pipeline may still be recorded, it stays alive with the future.
+    atomic_store_explicit(&job->pipeline, pipeline, memory_order_release);
+
+    pthread_mutex_lock(&pipeline_compiler->mutex);
+
+    pipeline_compiler->statistics.optimized_link_count++;
+    pipeline_compiler->statistics.optimized_link_time += link_time;
+
+    job->job_count--;
+
+    if (--pipeline_compiler->pending_job_count == 0U) {
+        pthread_cond_broadcast(&pipeline_compiler->idle_condition);
+    }
+
+    pthread_mutex_unlock(&pipeline_compiler->mutex);
+}
+
+// Called with the compiler mutex held. Saves run one at a time, so the saved
+// size and the temporary file are only used by one worker.
+static bool pipeline_compiler_save_waiting(const struct pipeline_compiler *const pipeline_compiler) {
+    return pipeline_compiler->pipeline_cache_save_path != NULL && !pipeline_compiler->pipeline_cache_saving;
+}
+
+static void pipeline_compiler_save_cache(struct pipeline_compiler *pipeline_compiler, const char *const path) {
+    const size_t pipeline_cache_size = pipeline_cache_get_data_size(pipeline_compiler->device, pipeline_compiler->pipeline_cache);
+
+    if (pipeline_cache_size != pipeline_compiler->pipeline_cache_saved_size) {
+        pipeline_cache_save(pipeline_compiler->device, pipeline_compiler->pipeline_cache, path);
+        pipeline_compiler->pipeline_cache_saved_size = pipeline_cache_size;
+    }
+
+    pthread_mutex_lock(&pipeline_compiler->mutex);
+
+    pipeline_compiler->pipeline_cache_saving = false;
+
+    if (pipeline_compiler->pipeline_cache_save_path != NULL) {
+        pthread_cond_signal(&pipeline_compiler->condition);
+    }
+
+    if (--pipeline_compiler->pending_job_count == 0U) {
+        pthread_cond_broadcast(&pipeline_compiler->idle_condition);
+    }
+
+    pthread_mutex_unlock(&pipeline_compiler->mutex);
+}
+
+static void *pipeline_compiler_run(void *argument) {
+    struct pipeline_compiler *pipeline_compiler = argument;
+
+    for (;;) {
+        pthread_mutex_lock(&pipeline_compiler->mutex);
+
+        while (pipeline_compiler->job_head == NULL && pipeline_compiler->optimize_job_head == NULL && !pipeline_compiler_save_waiting(pipeline_compiler) && !pipeline_compiler->stopping) {
+            pthread_cond_wait(&pipeline_compiler->condition, &pipeline_compiler->mutex);
+        }
+
+        // Saves wait for compiles too, the pipelines they add are worth keeping.
+        if (pipeline_compiler->job_head == NULL && pipeline_compiler_save_waiting(pipeline_compiler) && !pipeline_compiler->stopping) {
+            const char *const path = pipeline_compiler->pipeline_cache_save_path;
+            pipeline_compiler->pipeline_cache_save_path = NULL;
+            pipeline_compiler->pipeline_cache_saving = true;
+
+            pthread_mutex_unlock(&pipeline_compiler->mutex);
+
+            pipeline_compiler_save_cache(pipeline_compiler, path);
+            continue;
+        }
+
+        // Optimized links only run once no compile is waiting for a worker.
+        if (pipeline_compiler->job_head == NULL && pipeline_compiler->optimize_job_head != NULL && !pipeline_compiler->stopping) {
+            struct pipeline_future *job = pipeline_compiler->optimize_job_head;
+            pipeline_compiler->optimize_job_head = job->next_job;
+
+            if (pipeline_compiler->optimize_job_head == NULL) {
+                pipeline_compiler->optimize_job_tail = NULL;
+            }
+
+            pthread_mutex_unlock(&pipeline_compiler->mutex);
+
+            pipeline_compiler_optimize_link(pipeline_compiler, job);
+            continue;
+        }
+
+        struct pipeline_future *job = pipeline_compiler->job_head;
+
+        if (job == NULL) {
+            pthread_mutex_unlock(&pipeline_compiler->mutex);
+            return NULL;
+        }
+
+        pipeline_compiler->job_head = job->next_job;
+
+        if (pipeline_compiler->job_head == NULL) {
+            pipeline_compiler->job_tail = NULL;
+        }
+
+        pthread_mutex_unlock(&pipeline_compiler->mutex);
+
+        const double start_time = pipeline_compiler_get_time();
+        const VkPipeline pipeline = pipeline_compiler->use_graphics_pipeline_library ?
+            pipeline_compiler_fast_link(pipeline_compiler, job) :
+            graphics_pipeline_create(pipeline_compiler->device, pipeline_compiler->pipeline_cache, &job->description);
+        const double compile_time = pipeline_compiler_get_time() - start_time;
+
+        pipeline_future_complete(job, pipeline, compile_time);
+
+        pthread_mutex_lock(&pipeline_compiler->mutex);
+
+        pipeline_compiler->statistics.compile_count++;
+        pipeline_compiler->statistics.compile_time += compile_time;
+
+        if (compile_time > pipeline_compiler->statistics.max_compile_time) {
+            pipeline_compiler->statistics.max_compile_time = compile_time;
+        }
+
+        if (pipeline_compiler->use_graphics_pipeline_library) {
+            job->next_job = NULL;
+
+            if (pipeline_compiler->optimize_job_tail == NULL) {
+                pipeline_compiler->optimize_job_head = job;
+            } else {
+                pipeline_compiler->optimize_job_tail->next_job = job;
+            }
+
+            pipeline_compiler->optimize_job_tail = job;
+            pipeline_compiler->pending_job_count++;
+            job->job_count++;
+            pthread_cond_signal(&pipeline_compiler->condition);
+        }
+
+        job->job_count--;
+
+        if (--pipeline_compiler->pending_job_count == 0U) {
+            pthread_cond_broadcast(&pipeline_compiler->idle_condition);
+        }
+
+        pthread_mutex_unlock(&pipeline_compiler->mutex);
+    }
+}
+
+struct pipeline_compiler *pipeline_compiler_create(
+    const VkDevice device,
+    const VkPipelineCache pipeline_cache,
+    const uint32_t thread_count,
+    const bool use_graphics_pipeline_library,
+    const uint32_t dynamic_state_flags
+) {
+    struct pipeline_compiler *pipeline_compiler = malloc(sizeof *pipeline_compiler);
+
+    pipeline_compiler->device = device;
+    pipeline_compiler->pipeline_cache = pipeline_cache;
+    pipeline_compiler->use_graphics_pipeline_library = use_graphics_pipeline_library;
+    pipeline_compiler->dynamic_state_flags = dynamic_state_flags;
+    pipeline_compiler->thread_count = thread_count;
+    pipeline_compiler->threads = malloc(thread_count * (sizeof *pipeline_compiler->threads));
+    pipeline_compiler->job_head = NULL;
+    pipeline_compiler->job_tail = NULL;
+    pipeline_compiler->optimize_job_head = NULL;
+    pipeline_compiler->optimize_job_tail = NULL;
+    pipeline_compiler->pending_job_count = 0U;
+    pipeline_compiler->entry_capacity = 64U;
+    pipeline_compiler->entry_count = 0U;
+    pipeline_compiler->entries = calloc(pipeline_compiler->entry_capacity, sizeof *pipeline_compiler->entries);
+    pipeline_compiler->library_entry_capacity = 64U;
+    pipeline_compiler->library_entry_count = 0U;
+    pipeline_compiler->library_entries = calloc(pipeline_compiler->library_entry_capacity, sizeof *pipeline_compiler->library_entries);
+    pipeline_compiler->retired_head = NULL;
+    pipeline_compiler->pipeline_cache_save_path = NULL;
+    pipeline_compiler->pipeline_cache_saving = false;
+    pipeline_compiler->pipeline_cache_saved_size = pipeline_cache_get_data_size(device, pipeline_cache);
+    pipeline_compiler->statistics = (struct pipeline_compiler_statistics) {0};
+    pipeline_compiler->stopping = false;
+
+    pthread_mutex_init(&pipeline_compiler->mutex, NULL);
+    pthread_cond_init(&pipeline_compiler->condition, NULL);
+    pthread_cond_init(&pipeline_compiler->idle_condition, NULL);
+
+    for (uint32_t thread_index = 0U; thread_index < thread_count; ++thread_index) {
+        if (pthread_create(&pipeline_compiler->threads[thread_index], NULL, pipeline_compiler_run, pipeline_compiler) != 0) {
+            fprintf(stderr, "error: failed to create pipeline compiler thread\n");
+            exit(1);
+        }
+    }
+
+    return pipeline_compiler;
+}
+
+void pipeline_compiler_destroy(struct pipeline_compiler *pipeline_compiler) {
+    pthread_mutex_lock(&pipeline_compiler->mutex);
+    pipeline_compiler->stopping = true;
+    pthread_cond_broadcast(&pipeline_compiler->condition);
+    pthread_mutex_unlock(&pipeline_compiler->mutex);
+
+    for (uint32_t thread_index = 0U; thread_index < pipeline_compiler->thread_count; ++thread_index) {
+        pthread_join(pipeline_compiler->threads[thread_index], NULL);
+    }
+
+    // Linked pipelines go before the libraries they were linked from.
+    for (uint32_t entry_index = 0U; entry_index < pipeline_compiler->entry_capacity; ++entry_index) {
+        if (pipeline_compiler->entries[entry_index].future != NULL) {
+            pipeline_future_destroy(pipeline_compiler->device, pipeline_compiler->entries[entry_index].future);
+        }
+    }
+
+    struct pipeline_future *retired_libraries = NULL;
+
+    while (pipeline_compiler->retired_head != NULL) {
+        struct pipeline_future *pipeline_future = pipeline_compiler->retired_head;
+        pipeline_compiler->retired_head = pipeline_future->next_retired;
+
+        if (pipeline_future->library_part == 0) {
+            pipeline_future_destroy(pipeline_compiler->device, pipeline_future);
+        } else {
+            pipeline_future->next_retired = retired_libraries;
+            retired_libraries = pipeline_future;
+        }
+    }
+
+    for (uint32_t entry_index = 0U; entry_index < pipeline_compiler->library_entry_capacity; ++entry_index) {
+        if (pipeline_compiler->library_entries[entry_index].future != NULL) {
+            pipeline_future_destroy(pipeline_compiler->device, pipeline_compiler->library_entries[entry_index].future);
+        }
+    }
+
+    while (retired_libraries != NULL) {
+        struct pipeline_future *pipeline_future = retired_libraries;
+        retired_libraries = pipeline_future->next_retired;
+        pipeline_future_destroy(pipeline_compiler->device, pipeline_future);
+    }
+
+    pthread_cond_destroy(&pipeline_compiler->idle_condition);
+    pthread_cond_destroy(&pipeline_compiler->condition);
+    pthread_mutex_destroy(&pipeline_compiler->mutex);
+    free(pipeline_compiler->library_entries);
+    free(pipeline_compiler->entries);
+    free(pipeline_compiler->threads);
+    free(pipeline_compiler);
+}
+
+struct pipeline_future *pipeline_compiler_request_graphics(
+    struct pipeline_compiler *pipeline_compiler,
+    const struct graphics_pipeline_description *const requested_description
+) {
+    struct graphics_pipeline_description dynamic_description = *requested_description;
+    graphics_pipeline_description_set_dynamic_states(&dynamic_description, pipeline_compiler->dynamic_state_flags);
+
+    const struct graphics_pipeline_description *const description = &dynamic_description;
+    const uint64_t hash = graphics_pipeline_description_hash(description);
+
+    pthread_mutex_lock(&pipeline_compiler->mutex);
+
+    pipeline_compiler->statistics.request_count++;
+
+    const uint32_t slot = pipeline_compiler_find_entry(pipeline_compiler->entries, pipeline_compiler->entry_capacity, hash, description, 0);
+
+    if (pipeline_compiler->entries[slot].future != NULL) {
+        struct pipeline_future *pipeline_future = pipeline_compiler->entries[slot].future;
+        pipeline_compiler->statistics.hit_count++;
+        pthread_mutex_unlock(&pipeline_compiler->mutex);
+        return pipeline_future;
+    }
+
+    struct pipeline_future *pipeline_future = pipeline_future_create(description, 0);
+    pipeline_future->job_count = 1U;
+
+    pipeline_compiler->entries[slot] = (struct pipeline_compiler_entry) {.hash = hash, .future = pipeline_future};
+
+    if (++pipeline_compiler->entry_count * 2U > pipeline_compiler->entry_capacity) {
+        pipeline_compiler_grow_entries(&pipeline_compiler->entries, &pipeline_compiler->entry_capacity);
+    }
+
+    if (pipeline_compiler->job_tail == NULL) {
+        pipeline_compiler->job_head = pipeline_future;
+    } else {
+        pipeline_compiler->job_tail->next_job = pipeline_future;
+    }
+
+    pipeline_compiler->job_tail = pipeline_future;
+    pipeline_compiler->pending_job_count++;
+    pthread_cond_signal(&pipeline_compiler->condition);
+    pthread_mutex_unlock(&pipeline_compiler->mutex);
+
+    return pipeline_future;
+}
+
+// Rebuilt rather than deleted from in place, which keeps the probe sequences
+// of the remaining entries intact.
+static void pipeline_compiler_retire_entries(
+    struct pipeline_compiler *pipeline_compiler,
+    struct pipeline_compiler_entry **entries,
+    const uint32_t entry_capacity,
+    uint32_t *entry_count,
+    bool (*retires)(const struct graphics_pipeline_description *const description, const void *const key),
+    const void *const key,
+    const uint64_t frame
+) {
+    struct pipeline_compiler_entry *kept_entries = calloc(entry_capacity, sizeof *kept_entries);
+
+    for (uint32_t entry_index = 0U; entry_index < entry_capacity; ++entry_index) {
+        struct pipeline_future *pipeline_future = (*entries)[entry_index].future;
+
+        if (pipeline_future == NULL) {
+            continue;
+        }
+
+        if (retires(&pipeline_future->description, key)) {
+            pipeline_future->retire_frame = frame;
+            pipeline_future->next_retired = pipeline_compiler->retired_head;
+            pipeline_compiler->retired_head = pipeline_future;
+            (*entry_count)--;
+        } else {
+            pipeline_compiler_insert_entry(kept_entries, entry_capacity, (*entries)[entry_index]);
+        }
+    }
+
+    free(*entries);
+    *entries = kept_entries;
+}
+
+static void pipeline_compiler_retire_matching(
+    struct pipeline_compiler *pipeline_compiler,
+    bool (*retires)(const struct graphics_pipeline_description *const description, const void *const key),
+    const void *const key,
+    const uint64_t frame
+) {
+    pthread_mutex_lock(&pipeline_compiler->mutex);
+
+    pipeline_compiler_retire_entries(pipeline_compiler, &pipeline_compiler->entries, pipeline_compiler->entry_capacity, &pipeline_compiler->entry_count, retires, key, frame);
+    pipeline_compiler_retire_entries(pipeline_compiler, &pipeline_compiler->library_entries, pipeline_compiler->library_entry_capacity, &pipeline_compiler->library_entry_count, retires, key, frame);
+
+    pthread_mutex_unlock(&pipeline_compiler->mutex);
+}
+
+static bool pipeline_compiler_uses_shader(const struct graphics_pipeline_description *const description, const void *const key) {
+    const uint64_t shader_content_hash = *(const uint64_t *) key;
+
+    return description->vertex_shader_content_hash == shader_content_hash ||
+        description->fragment_shader_content_hash == shader_content_hash;
+}
+
+static bool pipeline_compiler_uses_render_pass(const struct graphics_pipeline_description *const description, const void *const key) {
+    return description->render_pass == *(const VkRenderPass *) key;
+}
+
+void pipeline_compiler_retire_shader(
+    struct pipeline_compiler *pipeline_compiler,
+    const uint64_t shader_content_hash,
+    const uint64_t frame
+) {
+    pipeline_compiler_retire_matching(pipeline_compiler, pipeline_compiler_uses_shader, &shader_content_hash, frame);
+}
+
+void pipeline_compiler_retire_render_pass(
+    struct pipeline_compiler *pipeline_compiler,
+    const VkRenderPass render_pass,
+    const uint64_t frame
+) {
+    pipeline_compiler_retire_matching(pipeline_compiler, pipeline_compiler_uses_render_pass, &render_pass, frame);
+}
+
+bool pipeline_compiler_collect_retired(struct pipeline_compiler *pipeline_compiler, const uint64_t completed_frame_count) {
+    pthread_mutex_lock(&pipeline_compiler->mutex);
+
+    struct pipeline_future **link = &pipeline_compiler->retired_head;
+
+    // Libraries are only destroyed once no pipeline linked from them is left,
+    // those are collected on a later call.
+    while (*link != NULL) {
+        struct pipeline_future *pipeline_future = *link;
+
+        if (pipeline_future->retire_frame <= completed_frame_count &&
+            pipeline_future->job_count == 0U &&
+            pipeline_future->reference_count == 0U &&
+            pipeline_future_is_ready(pipeline_future)) {
+            *link = pipeline_future->next_retired;
+
+            for (uint32_t part_index = 0U; part_index < PIPELINE_COMPILER_LIBRARY_PART_COUNT; ++part_index) {
+                if (pipeline_future->libraries[part_index] != NULL) {
+                    pipeline_future->libraries[part_index]->reference_count--;
+                }
+            }
+
+            pipeline_future_destroy(pipeline_compiler->device, pipeline_future);
+        } else {
+            link = &pipeline_future->next_retired;
+        }
+    }
+
+    const bool empty = pipeline_compiler->retired_head == NULL;
+
+    pthread_mutex_unlock(&pipeline_compiler->mutex);
+
+    return empty;
+}
+
+void pipeline_compiler_request_cache_save(struct pipeline_compiler *pipeline_compiler, const char *const path) {
+    pthread_mutex_lock(&pipeline_compiler->mutex);
+
+    if (pipeline_compiler->pipeline_cache_save_path == NULL) {
+        pipeline_compiler->pipeline_cache_save_path = path;
+        pipeline_compiler->pending_job_count++;
+        pthread_cond_signal(&pipeline_compiler->condition);
+    }
+
+    pthread_mutex_unlock(&pipeline_compiler->mutex);
+}
+
+void pipeline_compiler_wait_idle(struct pipeline_compiler *pipeline_compiler) {
+    pthread_mutex_lock(&pipeline_compiler->mutex);
+
+    while (pipeline_compiler->pending_job_count > 0U) {
+        pthread_cond_wait(&pipeline_compiler->idle_condition, &pipeline_compiler->mutex);
+    }
+
+    pthread_mutex_unlock(&pipeline_compiler->mutex);
+}
+
+struct pipeline_compiler_statistics pipeline_compiler_get_statistics(struct pipeline_compiler *pipeline_compiler) {
+    pthread_mutex_lock(&pipeline_compiler->mutex);
+    const struct pipeline_compiler_statistics statistics = pipeline_compiler->statistics;
+    pthread_mutex_unlock(&pipeline_compiler->mutex);
+
+    return statistics;
+}
+
+bool pipeline_future_is_ready(const struct pipeline_future *const pipeline_future) {
+    return atomic_load_explicit(&pipeline_future->state, memory_order_acquire) == PIPELINE_FUTURE_STATE_READY;
+}
+
+VkPipeline pipeline_future_get(const struct pipeline_future *const pipeline_future, const VkPipeline fallback_pipeline) {
+    return pipeline_future_is_ready(pipeline_future) ? atomic_load_explicit(&pipeline_future->pipeline, memory_order_acquire) : fallback_pipeline;
+}
+
+VkPipeline pipeline_future_wait(struct pipeline_future *pipeline_future) {
+    pthread_mutex_lock(&pipeline_future->mutex);
+
+    while (!pipeline_future_is_ready(pipeline_future)) {
+        pthread_cond_wait(&pipeline_future->condition, &pipeline_future->mutex);
+    }
+
+    pthread_mutex_unlock(&pipeline_future->mutex);
+
+    return atomic_load_explicit(&pipeline_future->pipeline, memory_order_acquire);
+}
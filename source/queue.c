@@ -1,5 +1,6 @@
 #include <queue.h>
 
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -53,37 +54,50 @@ void fences_destroy(const VkDevice device, VkFence *fences, const uint32_t swapc
     free(fences);
 }
 
-void queue_draw(
-    const VkQueue queue,
-    const VkDevice device,
-    const VkSwapchainKHR swapchain,
-    const VkCommandBuffer *command_buffers,
-    const VkSemaphore semaphore_image_available,
-    const VkSemaphore semaphore_image_rendered,
-    const VkFence *fences
-) {
-    uint32_t image_index = 0;
-    VkResult result = vkAcquireNextImageKHR(device, swapchain, UINT64_MAX, semaphore_image_available, VK_NULL_HANDLE, &image_index);
+void queue_wait_for_fence(const VkDevice device, const VkFence fence) {
+    VkResult result = vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
 
     if (result != VK_SUCCESS) {
-        fprintf(stderr, "error: failed to acquire next image\n");
+        fprintf(stderr, "error: failed to wait for fence\n");
         exit(1);
     }
 
-    result = vkWaitForFences(device, 1, &fences[image_index], VK_TRUE, UINT64_MAX);
+    result = vkResetFences(device, 1, &fence);
 
     if (result != VK_SUCCESS) {
-        fprintf(stderr, "error: failed to wait for fence\n");
+        fprintf(stderr, "error: failed to reset fence\n");
         exit(1);
     }
+}
 
-    result = vkResetFences(device, 1, &fences[image_index]);
+uint32_t queue_acquire_next_image(
+    const VkDevice device,
+    const VkSwapchainKHR swapchain,
+    const VkSemaphore semaphore_image_available,
+    const VkFence *fences
+) {
+    uint32_t image_index = 0;
+    VkResult result = vkAcquireNextImageKHR(device, swapchain, UINT64_MAX, semaphore_image_available, VK_NULL_HANDLE, &image_index);
 
     if (result != VK_SUCCESS) {
-        fprintf(stderr, "error: failed to reset fence\n");
+        fprintf(stderr, "error: failed to acquire next image\n");
         exit(1);
     }
 
+    queue_wait_for_fence(device, fences[image_index]);
+
+    return image_index;
+}
+
+void queue_submit_and_present(
+    const VkQueue queue,
+    const VkSwapchainKHR swapchain,
+    const VkCommandBuffer command_buffer,
+    const VkSemaphore semaphore_image_available,
+    const VkSemaphore semaphore_image_rendered,
+    const VkFence fence,
+    const uint32_t image_index
+) {
     const VkPipelineStageFlags pipeline_stage_flags = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
 
     const VkSubmitInfo submit_info = {
@@ -93,12 +107,12 @@ void queue_draw(
         .pWaitSemaphores = &semaphore_image_available,
         .pWaitDstStageMask = &pipeline_stage_flags,
         .commandBufferCount = 1,
-        .pCommandBuffers = &command_buffers[image_index],
+        .pCommandBuffers = &command_buffer,
         .signalSemaphoreCount = 1,
         .pSignalSemaphores = &semaphore_image_rendered
     };
 
-    result = vkQueueSubmit(queue, 1, &submit_info, fences[image_index]);
+    VkResult result = vkQueueSubmit(queue, 1, &submit_info, fence);
 
     if (result != VK_SUCCESS) {
         fprintf(stderr, "error: failed to submit to queue\n");
@@ -126,3 +140,41 @@ void queue_draw(
         exit(1);
     }
 }
+
+void queue_submit(
+    const VkQueue queue,
+    const VkCommandBuffer command_buffer,
+    const VkFence fence,
+    const VkSemaphore timeline_semaphore,
+    const uint64_t timeline_value
+) {
+    const bool signals = timeline_semaphore != VK_NULL_HANDLE;
+
+    const VkTimelineSemaphoreSubmitInfo timeline_semaphore_submit_info = {
+        .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+        .pNext = NULL,
+        .waitSemaphoreValueCount = 0,
+        .pWaitSemaphoreValues = NULL,
+        .signalSemaphoreValueCount = 1,
+        .pSignalSemaphoreValues = &timeline_value
+    };
+
+    const VkSubmitInfo submit_info = {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .pNext = signals ? &timeline_semaphore_submit_info : NULL,
+        .waitSemaphoreCount = 0,
+        .pWaitSemaphores = NULL,
+        .pWaitDstStageMask = NULL,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &command_buffer,
+        .signalSemaphoreCount = signals ? 1 : 0,
+        .pSignalSemaphores = signals ? &timeline_semaphore : NULL
+    };
+
+    VkResult result = vkQueueSubmit(queue, 1, &submit_info, fence);
+
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "error: failed to submit to queue\n");
+        exit(1);
+    }
+}
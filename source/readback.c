@@ -0,0 +1,226 @@
+#include <readback.h>
+
+#include <buffer.h>
+#include <device.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static uint32_t readback_get_texel_size(const VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+        case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+            return 4U;
+        case VK_FORMAT_R16G16B16A16_SFLOAT:
+            return 8U;
+        case VK_FORMAT_R32G32B32A32_SFLOAT:
+            return 16U;
+        default:
+            fprintf(stderr, "error: unsupported readback format\n");
+            exit(1);
+    }
+}
+
+static VkSemaphore readback_create_timeline_semaphore(const VkDevice device) {
+    const VkSemaphoreTypeCreateInfo semaphore_type_create_info = {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .pNext = NULL,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue = 0U
+    };
+
+    const VkSemaphoreCreateInfo semaphore_create_info = {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = &semaphore_type_create_info,
+        .flags = 0
+    };
+
+    VkSemaphore semaphore;
+    VkResult result = vkCreateSemaphore(device, &semaphore_create_info, NULL, &semaphore);
+
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "error: failed to create timeline semaphore\n");
+        exit(1);
+    }
+
+    return semaphore;
+}
+
+struct readback *readback_create(
+    const VkDevice device,
+    const VkPhysicalDeviceMemoryProperties physical_device_memory_properties,
+    const VkExtent2D extent,
+    const VkFormat format,
+    const uint32_t slot_count,
+    const readback_consumer_function consumer,
+    void *user_data
+) {
+    struct readback *readback = malloc(sizeof *readback);
+
+    readback->device = device;
+    readback->timeline_semaphore = readback_create_timeline_semaphore(device);
+    readback->extent = extent;
+    readback->frame_size = (VkDeviceSize) extent.width * extent.height * readback_get_texel_size(format);
+    readback->slot_count = slot_count;
+    readback->slots = calloc(slot_count, sizeof *readback->slots);
+    readback->slot_index = 0U;
+    readback->consumer = consumer;
+    readback->user_data = user_data;
+    readback->statistics = (struct readback_statistics) {0};
+
+    for (uint32_t slot_index = 0U; slot_index < slot_count; ++slot_index) {
+        struct readback_slot *slot = &readback->slots[slot_index];
+
+        slot->buffer = buffer_create(device, VK_BUFFER_USAGE_TRANSFER_DST_BIT, (uint32_t) readback->frame_size);
+
+        VkMemoryRequirements memory_requirements;
+        vkGetBufferMemoryRequirements(device, slot->buffer, &memory_requirements);
+
+        // The CPU reads every byte, which is slow from write-combined memory.
+        VkMemoryPropertyFlags memory_property_flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+        uint32_t memory_type_index = device_find_memory_type_index(physical_device_memory_properties, memory_requirements.memoryTypeBits, memory_property_flags);
+
+        if (memory_type_index == UINT32_MAX) {
+            memory_property_flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+            memory_type_index = device_find_memory_type_index(physical_device_memory_properties, memory_requirements.memoryTypeBits, memory_property_flags);
+        }
+
+        if (memory_type_index == UINT32_MAX) {
+            fprintf(stderr, "error: no host visible memory for readback\n");
+            exit(1);
+        }
+
+        readback->host_coherent = physical_device_memory_properties.memoryTypes[memory_type_index].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+        const VkMemoryAllocateInfo memory_allocate_info = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            .pNext = NULL,
+            .allocationSize = memory_requirements.size,
+            .memoryTypeIndex = memory_type_index
+        };
+
+        VkResult result = vkAllocateMemory(device, &memory_allocate_info, NULL, &slot->device_memory);
+
+        if (result != VK_SUCCESS) {
+            fprintf(stderr, "error: failed to allocate readback memory\n");
+            exit(1);
+        }
+
+        vkBindBufferMemory(device, slot->buffer, slot->device_memory, 0);
+
+        // Mapped for the lifetime of the ring.
+        result = vkMapMemory(device, slot->device_memory, 0, VK_WHOLE_SIZE, 0, &slot->mapped_data);
+
+        if (result != VK_SUCCESS) {
+            fprintf(stderr, "error: failed to map readback memory\n");
+            exit(1);
+        }
+    }
+
+    return readback;
+}
+
+void readback_destroy(struct readback *readback) {
+    for (uint32_t slot_index = 0U; slot_index < readback->slot_count; ++slot_index) {
+        vkUnmapMemory(readback->device, readback->slots[slot_index].device_memory);
+        buffer_destroy(readback->device, readback->slots[slot_index].buffer);
+        buffer_free_memory(readback->device, readback->slots[slot_index].device_memory);
+    }
+
+    vkDestroySemaphore(readback->device, readback->timeline_semaphore, NULL);
+
+    free(readback->slots);
+    free(readback);
+}
+
+static void readback_deliver(struct readback *readback, struct readback_slot *slot, const uint64_t current_frame_index) {
+    if (!readback->host_coherent) {
+        const VkMappedMemoryRange mapped_memory_range = {
+            .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+            .pNext = NULL,
+            .memory = slot->device_memory,
+            .offset = 0,
+            .size = VK_WHOLE_SIZE
+        };
+
+        vkInvalidateMappedMemoryRanges(readback->device, 1, &mapped_memory_range);
+    }
+
+    readback->consumer(slot->mapped_data, readback->extent, slot->frame_index, readback->user_data);
+
+    slot->pending = false;
+
+    readback->statistics.frame_count++;
+    readback->statistics.byte_count += readback->frame_size;
+    readback->statistics.latency_frame_count += current_frame_index - slot->frame_index;
+}
+
+VkBuffer readback_begin_frame(struct readback *readback, const uint64_t frame_index) {
+    readback->slot_index = (uint32_t) (frame_index % readback->slot_count);
+
+    struct readback_slot *slot = &readback->slots[readback->slot_index];
+
+    // Only with fewer slots than frames in flight, the copy is waited for.
+    if (slot->pending) {
+        const uint64_t signal_value = slot->frame_index + 1U;
+
+        const VkSemaphoreWaitInfo semaphore_wait_info = {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+            .pNext = NULL,
+            .flags = 0,
+            .semaphoreCount = 1,
+            .pSemaphores = &readback->timeline_semaphore,
+            .pValues = &signal_value
+        };
+
+        if (vkWaitSemaphores(readback->device, &semaphore_wait_info, UINT64_MAX) != VK_SUCCESS) {
+            fprintf(stderr, "error: failed to wait for readback\n");
+            exit(1);
+        }
+
+        readback->statistics.stall_count++;
+        readback_deliver(readback, slot, frame_index);
+    }
+
+    slot->frame_index = frame_index;
+    slot->pending = true;
+
+    return slot->buffer;
+}
+
+void readback_record_copy(const struct readback *readback, const VkCommandBuffer command_buffer, const VkImage image) {
+    const VkBufferImageCopy buffer_image_copy = {
+        .bufferOffset = 0,
+        .bufferRowLength = 0,
+        .bufferImageHeight = 0,
+        .imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .imageSubresource.mipLevel = 0,
+        .imageSubresource.baseArrayLayer = 0,
+        .imageSubresource.layerCount = 1,
+        .imageOffset = {0, 0, 0},
+        .imageExtent = {readback->extent.width, readback->extent.height, 1}
+    };
+
+    vkCmdCopyImageToBuffer(command_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback->slots[readback->slot_index].buffer, 1, &buffer_image_copy);
+}
+
+void readback_poll(struct readback *readback, const uint64_t frame_index) {
+    uint64_t completed_value = 0U;
+
+    if (vkGetSemaphoreCounterValue(readback->device, readback->timeline_semaphore, &completed_value) != VK_SUCCESS) {
+        fprintf(stderr, "error: failed to get readback progress\n");
+        exit(1);
+    }
+
+    // Slots are delivered in frame order, the oldest sits after the current one.
+    for (uint32_t slot_offset = 1U; slot_offset <= readback->slot_count; ++slot_offset) {
+        struct readback_slot *slot = &readback->slots[(readback->slot_index + slot_offset) % readback->slot_count];
+
+        if (slot->pending && slot->frame_index + 1U <= completed_value) {
+            readback_deliver(readback, slot, frame_index);
+        }
+    }
+}
@@ -0,0 +1,908 @@
+#include <rendergraph.h>
+
+#include <device.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const struct {
+    VkPipelineStageFlags stage_mask;
+    VkAccessFlags access_mask;
+    VkImageLayout layout;
+    VkImageUsageFlags image_usage;
+    VkBufferUsageFlags buffer_usage;
+    bool write;
+} render_graph_access_types[RENDER_GRAPH_ACCESS_TYPE_COUNT] = {
+    [RENDER_GRAPH_ACCESS_COLOR_ATTACHMENT_WRITE] = {
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, 0, true
+    },
+    [RENDER_GRAPH_ACCESS_DEPTH_ATTACHMENT_WRITE] = {
+        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, 0, true
+    },
+    [RENDER_GRAPH_ACCESS_DEPTH_ATTACHMENT_READ] = {
+        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+        VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, 0, false
+    },
+    [RENDER_GRAPH_ACCESS_INPUT_ATTACHMENT_READ] = {
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        VK_ACCESS_INPUT_ATTACHMENT_READ_BIT,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT, 0, false
+    },
+    [RENDER_GRAPH_ACCESS_COLOR_INPUT_ATTACHMENT] = {
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_INPUT_ATTACHMENT_READ_BIT,
+        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT, 0, true
+    },
+    [RENDER_GRAPH_ACCESS_DEPTH_INPUT_ATTACHMENT] = {
+        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_INPUT_ATTACHMENT_READ_BIT,
+        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT, 0, true
+    },
+    [RENDER_GRAPH_ACCESS_FRAGMENT_SAMPLED_READ] = {
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        VK_ACCESS_SHADER_READ_BIT,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT, 0, false
+    },
+    [RENDER_GRAPH_ACCESS_COMPUTE_SAMPLED_READ] = {
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_ACCESS_SHADER_READ_BIT,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT, 0, false
+    },
+    [RENDER_GRAPH_ACCESS_COMPUTE_STORAGE_READ] = {
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_ACCESS_SHADER_READ_BIT,
+        VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, false
+    },
+    [RENDER_GRAPH_ACCESS_COMPUTE_STORAGE_WRITE] = {
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true
+    },
+    [RENDER_GRAPH_ACCESS_TRANSFER_READ] = {
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_ACCESS_TRANSFER_READ_BIT,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, false
+    },
+    [RENDER_GRAPH_ACCESS_TRANSFER_WRITE] = {
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_BUFFER_USAGE_TRANSFER_DST_BIT, true
+    },
+    [RENDER_GRAPH_ACCESS_VERTEX_BUFFER_READ] = {
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+        VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
+        VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, false
+    },
+    [RENDER_GRAPH_ACCESS_INDEX_BUFFER_READ] = {
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+        VK_ACCESS_INDEX_READ_BIT,
+        VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, false
+    },
+    [RENDER_GRAPH_ACCESS_INDIRECT_BUFFER_READ] = {
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+        VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+        VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, false
+    }
+};
+
+// Where a resource stands while the barriers are computed. Reads since the
+// last write are collected, so a following write or layout change waits for
+// all of them.
+struct render_graph_tracked_state {
+    bool accessed;
+    VkImageLayout layout;
+    VkPipelineStageFlags write_stage_mask;
+    VkAccessFlags write_access_mask;
+    VkPipelineStageFlags read_stage_mask;
+    VkPipelineStageFlags visible_stage_mask;
+};
+
+static VkImageAspectFlags render_graph_format_aspect(const VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_D16_UNORM:
+        case VK_FORMAT_X8_D24_UNORM_PACK32:
+        case VK_FORMAT_D32_SFLOAT:
+            return VK_IMAGE_ASPECT_DEPTH_BIT;
+        case VK_FORMAT_D16_UNORM_S8_UINT:
+        case VK_FORMAT_D24_UNORM_S8_UINT:
+        case VK_FORMAT_D32_SFLOAT_S8_UINT:
+            return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+        case VK_FORMAT_S8_UINT:
+            return VK_IMAGE_ASPECT_STENCIL_BIT;
+        default:
+            return VK_IMAGE_ASPECT_COLOR_BIT;
+    }
+}
+
+static uint32_t render_graph_add_resource(struct render_graph *render_graph, const char *const name) {
+    if (render_graph->compiled) {
+        fprintf(stderr, "error: render graph is already compiled\n");
+        exit(1);
+    }
+
+    if (render_graph->resource_count == RENDER_GRAPH_MAX_RESOURCES) {
+        fprintf(stderr, "error: too many render graph resources\n");
+        exit(1);
+    }
+
+    const uint32_t resource_index = render_graph->resource_count++;
+    struct render_graph_resource *resource = &render_graph->resources[resource_index];
+
+    memset(resource, 0, sizeof *resource);
+    snprintf(resource->name, sizeof resource->name, "%s", name);
+    resource->initial_state = (struct render_graph_resource_state) {
+        .stage_mask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+        .access_mask = 0,
+        .layout = VK_IMAGE_LAYOUT_UNDEFINED
+    };
+    resource->first_pass = UINT32_MAX;
+    resource->last_pass = 0U;
+
+    return resource_index;
+}
+
+struct render_graph *render_graph_create(
+    const VkDevice device,
+    const VkPhysicalDeviceProperties physical_device_properties,
+    const VkPhysicalDeviceMemoryProperties physical_device_memory_properties
+) {
+    struct render_graph *render_graph = malloc(sizeof *render_graph);
+
+    render_graph->device = device;
+    render_graph->physical_device_memory_properties = physical_device_memory_properties;
+    render_graph->buffer_image_granularity = physical_device_properties.limits.bufferImageGranularity;
+    render_graph->resource_count = 0U;
+    render_graph->pass_count = 0U;
+    render_graph->memory_count = 0U;
+    render_graph->compiled = false;
+    render_graph->statistics = (struct render_graph_statistics) {0};
+
+    return render_graph;
+}
+
+void render_graph_destroy(struct render_graph *render_graph) {
+    render_graph_reset(render_graph);
+    free(render_graph);
+}
+
+void render_graph_reset(struct render_graph *render_graph) {
+    for (uint32_t resource_index = 0U; resource_index < render_graph->resource_count; ++resource_index) {
+        const struct render_graph_resource *const resource = &render_graph->resources[resource_index];
+
+        if (resource->imported) {
+            continue;
+        }
+
+        if (resource->image_view != VK_NULL_HANDLE) {
+            vkDestroyImageView(render_graph->device, resource->image_view, NULL);
+        }
+
+        if (resource->image != VK_NULL_HANDLE) {
+            vkDestroyImage(render_graph->device, resource->image, NULL);
+        }
+
+        if (resource->buffer != VK_NULL_HANDLE) {
+            vkDestroyBuffer(render_graph->device, resource->buffer, NULL);
+        }
+    }
+
+    for (uint32_t memory_index = 0U; memory_index < render_graph->memory_count; ++memory_index) {
+        vkFreeMemory(render_graph->device, render_graph->memories[memory_index], NULL);
+    }
+
+    render_graph->resource_count = 0U;
+    render_graph->pass_count = 0U;
+    render_graph->memory_count = 0U;
+    render_graph->compiled = false;
+    render_graph->statistics = (struct render_graph_statistics) {0};
+}
+
+uint32_t render_graph_import_image(
+    struct render_graph *render_graph,
+    const char *const name,
+    const VkFormat format,
+    const struct render_graph_resource_state initial_state
+) {
+    const uint32_t resource_index = render_graph_add_resource(render_graph, name);
+    struct render_graph_resource *resource = &render_graph->resources[resource_index];
+
+    resource->is_image = true;
+    resource->imported = true;
+    resource->image_description.format = format;
+    resource->initial_state = initial_state;
+
+    return resource_index;
+}
+
+uint32_t render_graph_import_buffer(
+    struct render_graph *render_graph,
+    const char *const name,
+    const VkBuffer buffer,
+    const struct render_graph_resource_state initial_state
+) {
+    const uint32_t resource_index = render_graph_add_resource(render_graph, name);
+    struct render_graph_resource *resource = &render_graph->resources[resource_index];
+
+    resource->imported = true;
+    resource->buffer = buffer;
+    resource->initial_state = initial_state;
+
+    return resource_index;
+}
+
+uint32_t render_graph_create_image(
+    struct render_graph *render_graph,
+    const char *const name,
+    const struct render_graph_image_description *const image_description
+) {
+    const uint32_t resource_index = render_graph_add_resource(render_graph, name);
+    struct render_graph_resource *resource = &render_graph->resources[resource_index];
+
+    resource->is_image = true;
+    resource->image_description = *image_description;
+
+    return resource_index;
+}
+
+uint32_t render_graph_create_buffer(struct render_graph *render_graph, const char *const name, const VkDeviceSize size) {
+    const uint32_t resource_index = render_graph_add_resource(render_graph, name);
+
+    render_graph->resources[resource_index].buffer_size = size;
+
+    return resource_index;
+}
+
+void render_graph_set_output(
+    struct render_graph *render_graph,
+    const uint32_t resource,
+    const struct render_graph_resource_state final_state
+) {
+    render_graph->resources[resource].output = true;
+    render_graph->resources[resource].final_state = final_state;
+}
+
+uint32_t render_graph_add_pass(struct render_graph *render_graph, const char *const name, const render_graph_record_function record) {
+    if (render_graph->compiled) {
+        fprintf(stderr, "error: render graph is already compiled\n");
+        exit(1);
+    }
+
+    if (render_graph->pass_count == RENDER_GRAPH_MAX_PASSES) {
+        fprintf(stderr, "error: too many render graph passes\n");
+        exit(1);
+    }
+
+    const uint32_t pass_index = render_graph->pass_count++;
+    struct render_graph_pass *pass = &render_graph->passes[pass_index];
+
+    memset(pass, 0, sizeof *pass);
+    snprintf(pass->name, sizeof pass->name, "%s", name);
+    pass->record = record;
+
+    return pass_index;
+}
+
+void render_graph_pass_access(
+    struct render_graph *render_graph,
+    const uint32_t pass,
+    const uint32_t resource,
+    const enum render_graph_access_type access_type
+) {
+    struct render_graph_pass *render_graph_pass = &render_graph->passes[pass];
+
+    for (uint32_t access_index = 0U; access_index < render_graph_pass->access_count; ++access_index) {
+        if (render_graph_pass->accesses[access_index].resource == resource) {
+            fprintf(stderr, "error: render graph pass %s accesses %s twice\n", render_graph_pass->name, render_graph->resources[resource].name);
+            exit(1);
+        }
+    }
+
+    if (render_graph_pass->access_count == RENDER_GRAPH_MAX_PASS_ACCESSES) {
+        fprintf(stderr, "error: render graph pass %s has too many accesses\n", render_graph_pass->name);
+        exit(1);
+    }
+
+    if (render_graph->resources[resource].is_image && render_graph_access_types[access_type].image_usage == 0) {
+        fprintf(stderr, "error: render graph pass %s accesses image %s as a buffer\n", render_graph_pass->name, render_graph->resources[resource].name);
+        exit(1);
+    }
+
+    render_graph_pass->accesses[render_graph_pass->access_count++] = (struct render_graph_access) {
+        .resource = resource,
+        .type = access_type
+    };
+}
+
+// A pass is kept when it writes a resource that is an output or that a kept
+// pass accesses later on.
+static void render_graph_cull(struct render_graph *render_graph) {
+    bool needed[RENDER_GRAPH_MAX_RESOURCES];
+
+    for (uint32_t resource_index = 0U; resource_index < render_graph->resource_count; ++resource_index) {
+        needed[resource_index] = render_graph->resources[resource_index].output;
+    }
+
+    for (uint32_t pass_index = render_graph->pass_count; pass_index-- > 0U;) {
+        struct render_graph_pass *pass = &render_graph->passes[pass_index];
+        bool kept = false;
+
+        for (uint32_t access_index = 0U; access_index < pass->access_count; ++access_index) {
+            const struct render_graph_access access = pass->accesses[access_index];
+            kept = kept || (render_graph_access_types[access.type].write && needed[access.resource]);
+        }
+
+        pass->culled = !kept;
+
+        if (!kept) {
+            continue;
+        }
+
+        for (uint32_t access_index = 0U; access_index < pass->access_count; ++access_index) {
+            needed[pass->accesses[access_index].resource] = true;
+        }
+    }
+}
+
+static void render_graph_create_resources(struct render_graph *render_graph) {
+    for (uint32_t pass_index = 0U; pass_index < render_graph->pass_count; ++pass_index) {
+        const struct render_graph_pass *const pass = &render_graph->passes[pass_index];
+
+        if (pass->culled) {
+            continue;
+        }
+
+        for (uint32_t access_index = 0U; access_index < pass->access_count; ++access_index) {
+            const struct render_graph_access access = pass->accesses[access_index];
+            struct render_graph_resource *resource = &render_graph->resources[access.resource];
+
+            resource->image_usage |= render_graph_access_types[access.type].image_usage;
+            resource->buffer_usage |= render_graph_access_types[access.type].buffer_usage;
+
+            if (resource->first_pass == UINT32_MAX) {
+                resource->first_pass = pass_index;
+            }
+
+            resource->last_pass = pass_index;
+        }
+    }
+
+    for (uint32_t resource_index = 0U; resource_index < render_graph->resource_count; ++resource_index) {
+        struct render_graph_resource *resource = &render_graph->resources[resource_index];
+
+        // Resources only accessed by culled passes are never created.
+        if (resource->imported || resource->first_pass == UINT32_MAX) {
+            continue;
+        }
+
+        VkMemoryPropertyFlags memory_property_flags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+        if (resource->is_image) {
+            const struct render_graph_image_description *const description = &resource->image_description;
+
+            if (description->transient_attachment) {
+                resource->image_usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+            }
+
+            const VkImageCreateInfo image_create_info = {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+                .pNext = NULL,
+                .flags = 0,
+                .imageType = VK_IMAGE_TYPE_2D,
+                .format = description->format,
+                .extent.width = description->extent.width,
+                .extent.height = description->extent.height,
+                .extent.depth = 1,
+                .mipLevels = 1,
+                .arrayLayers = 1,
+                .samples = description->sample_count ? description->sample_count : VK_SAMPLE_COUNT_1_BIT,
+                .tiling = VK_IMAGE_TILING_OPTIMAL,
+                .usage = resource->image_usage,
+                .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+                .queueFamilyIndexCount = 0,
+                .pQueueFamilyIndices = NULL,
+                .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
+            };
+
+            if (vkCreateImage(render_graph->device, &image_create_info, NULL, &resource->image) != VK_SUCCESS) {
+                fprintf(stderr, "error: failed to create render graph image %s\n", resource->name);
+                exit(1);
+            }
+
+            vkGetImageMemoryRequirements(render_graph->device, resource->image, &resource->memory_requirements);
+
+            if (description->transient_attachment) {
+                memory_property_flags |= VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+            }
+        } else {
+            const VkBufferCreateInfo buffer_create_info = {
+                .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+                .pNext = NULL,
+                .flags = 0,
+                .size = resource->buffer_size,
+                .usage = resource->buffer_usage,
+                .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+                .queueFamilyIndexCount = 0,
+                .pQueueFamilyIndices = NULL
+            };
+
+            if (vkCreateBuffer(render_graph->device, &buffer_create_info, NULL, &resource->buffer) != VK_SUCCESS) {
+                fprintf(stderr, "error: failed to create render graph buffer %s\n", resource->name);
+                exit(1);
+            }
+
+            vkGetBufferMemoryRequirements(render_graph->device, resource->buffer, &resource->memory_requirements);
+        }
+
+        resource->memory_type_index = device_find_memory_type_index(render_graph->physical_device_memory_properties, resource->memory_requirements.memoryTypeBits, memory_property_flags);
+
+        // Lazily allocated memory is optional, desktop devices rarely have it.
+        if (resource->memory_type_index == UINT32_MAX) {
+            resource->memory_type_index = device_find_memory_type_index(render_graph->physical_device_memory_properties, resource->memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        }
+
+        if (resource->memory_type_index == UINT32_MAX) {
+            fprintf(stderr, "error: failed to find memory type for render graph resource %s\n", resource->name);
+            exit(1);
+        }
+
+        render_graph->statistics.transient_resource_count++;
+        render_graph->statistics.unaliased_memory_size += resource->memory_requirements.size;
+    }
+}
+
+static bool render_graph_lifetimes_overlap(const struct render_graph_resource *const resource_a, const struct render_graph_resource *const resource_b) {
+    return resource_a->first_pass <= resource_b->last_pass && resource_b->first_pass <= resource_a->last_pass;
+}
+
+static bool render_graph_memory_overlaps(const struct render_graph_resource *const resource_a, const struct render_graph_resource *const resource_b) {
+    return resource_a->memory_offset < resource_b->memory_offset + resource_b->memory_requirements.size &&
+        resource_b->memory_offset < resource_a->memory_offset + resource_a->memory_requirements.size;
+}
+
+static bool render_graph_is_transient(const struct render_graph_resource *const resource) {
+    return !resource->imported && resource->first_pass != UINT32_MAX;
+}
+
+// Greedy placement per memory type: the largest resources go first, each at
+// the lowest offset that no placed resource with an overlapping lifetime
+// uses. Offsets are aligned to bufferImageGranularity as well, because images
+// and buffers may end up next to each other.
+static void render_graph_place_resources(struct render_graph *render_graph) {
+    uint32_t order[RENDER_GRAPH_MAX_RESOURCES];
+    uint32_t order_count = 0U;
+
+    for (uint32_t resource_index = 0U; resource_index < render_graph->resource_count; ++resource_index) {
+        if (!render_graph_is_transient(&render_graph->resources[resource_index])) {
+            continue;
+        }
+
+        const VkDeviceSize size = render_graph->resources[resource_index].memory_requirements.size;
+        uint32_t insert_index = order_count++;
+
+        for (; insert_index > 0U && render_graph->resources[order[insert_index - 1U]].memory_requirements.size < size; --insert_index) {
+            order[insert_index] = order[insert_index - 1U];
+        }
+
+        order[insert_index] = resource_index;
+    }
+
+    VkDeviceSize memory_sizes[VK_MAX_MEMORY_TYPES] = {0};
+    bool placed[RENDER_GRAPH_MAX_RESOURCES] = {false};
+
+    for (uint32_t order_index = 0U; order_index < order_count; ++order_index) {
+        struct render_graph_resource *resource = &render_graph->resources[order[order_index]];
+
+        VkDeviceSize alignment = resource->memory_requirements.alignment;
+
+        if (render_graph->buffer_image_granularity > alignment) {
+            alignment = render_graph->buffer_image_granularity;
+        }
+
+        // Candidates are the start of the memory and the end of every placed
+        // resource, the lowest that fits wins.
+        VkDeviceSize best_offset = UINT64_MAX;
+
+        for (uint32_t candidate_index = 0U; candidate_index <= order_index; ++candidate_index) {
+            VkDeviceSize candidate_offset = 0U;
+
+            if (candidate_index < order_index) {
+                const struct render_graph_resource *const candidate = &render_graph->resources[order[candidate_index]];
+
+                if (candidate->memory_type_index != resource->memory_type_index) {
+                    continue;
+                }
+
+                candidate_offset = candidate->memory_offset + candidate->memory_requirements.size;
+            }
+
+            candidate_offset = (candidate_offset + alignment - 1U) / alignment * alignment;
+
+            if (candidate_offset >= best_offset) {
+                continue;
+            }
+
+            resource->memory_offset = candidate_offset;
+            bool fits = true;
+
+            for (uint32_t other_index = 0U; other_index < render_graph->resource_count && fits; ++other_index) {
+                const struct render_graph_resource *const other = &render_graph->resources[other_index];
+
+                fits = !placed[other_index] ||
+                    other->memory_type_index != resource->memory_type_index ||
+                    !render_graph_lifetimes_overlap(resource, other) ||
+                    !render_graph_memory_overlaps(resource, other);
+            }
+
+            if (fits) {
+                best_offset = candidate_offset;
+            }
+        }
+
+        resource->memory_offset = best_offset;
+        placed[order[order_index]] = true;
+
+        if (best_offset + resource->memory_requirements.size > memory_sizes[resource->memory_type_index]) {
+            memory_sizes[resource->memory_type_index] = best_offset + resource->memory_requirements.size;
+        }
+    }
+
+    for (uint32_t memory_type_index = 0U; memory_type_index < VK_MAX_MEMORY_TYPES; ++memory_type_index) {
+        if (memory_sizes[memory_type_index] == 0U) {
+            continue;
+        }
+
+        const VkMemoryAllocateInfo memory_allocate_info = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            .pNext = NULL,
+            .allocationSize = memory_sizes[memory_type_index],
+            .memoryTypeIndex = memory_type_index
+        };
+
+        const uint32_t memory_index = render_graph->memory_count++;
+
+        if (vkAllocateMemory(render_graph->device, &memory_allocate_info, NULL, &render_graph->memories[memory_index]) != VK_SUCCESS) {
+            fprintf(stderr, "error: failed to allocate render graph memory\n");
+            exit(1);
+        }
+
+        render_graph->statistics.transient_memory_size += memory_sizes[memory_type_index];
+
+        for (uint32_t resource_index = 0U; resource_index < render_graph->resource_count; ++resource_index) {
+            struct render_graph_resource *resource = &render_graph->resources[resource_index];
+
+            if (!render_graph_is_transient(resource) || resource->memory_type_index != memory_type_index) {
+                continue;
+            }
+
+            if (resource->is_image) {
+                vkBindImageMemory(render_graph->device, resource->image, render_graph->memories[memory_index], resource->memory_offset);
+
+                const VkImageViewCreateInfo image_view_create_info = {
+                    .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+                    .pNext = NULL,
+                    .flags = 0,
+                    .image = resource->image,
+                    .viewType = VK_IMAGE_VIEW_TYPE_2D,
+                    .format = resource->image_description.format,
+                    .components.r = VK_COMPONENT_SWIZZLE_IDENTITY,
+                    .components.g = VK_COMPONENT_SWIZZLE_IDENTITY,
+                    .components.b = VK_COMPONENT_SWIZZLE_IDENTITY,
+                    .components.a = VK_COMPONENT_SWIZZLE_IDENTITY,
+                    .subresourceRange.aspectMask = render_graph_format_aspect(resource->image_description.format),
+                    .subresourceRange.baseMipLevel = 0,
+                    .subresourceRange.levelCount = 1,
+                    .subresourceRange.baseArrayLayer = 0,
+                    .subresourceRange.layerCount = 1
+                };
+
+                if (vkCreateImageView(render_graph->device, &image_view_create_info, NULL, &resource->image_view) != VK_SUCCESS) {
+                    fprintf(stderr, "error: failed to create render graph image view %s\n", resource->name);
+                    exit(1);
+                }
+            } else {
+                vkBindBufferMemory(render_graph->device, resource->buffer, render_graph->memories[memory_index], resource->memory_offset);
+            }
+        }
+    }
+}
+
+static void render_graph_batch_add(
+    struct render_graph_barrier_batch *batch,
+    const uint32_t resource,
+    const VkPipelineStageFlags src_stage_mask,
+    const VkAccessFlags src_access_mask,
+    const VkImageLayout old_layout,
+    const VkPipelineStageFlags dst_stage_mask,
+    const VkAccessFlags dst_access_mask,
+    const VkImageLayout new_layout
+) {
+    batch->src_stage_mask |= src_stage_mask;
+    batch->dst_stage_mask |= dst_stage_mask;
+    batch->barriers[batch->barrier_count++] = (struct render_graph_barrier) {
+        .resource = resource,
+        .src_access_mask = src_access_mask,
+        .dst_access_mask = dst_access_mask,
+        .old_layout = old_layout,
+        .new_layout = new_layout
+    };
+}
+
+static void render_graph_count_batch(struct render_graph *render_graph, const struct render_graph_barrier_batch *const batch) {
+    if (batch->barrier_count == 0U) {
+        return;
+    }
+
+    render_graph->statistics.barrier_batch_count++;
+
+    for (uint32_t barrier_index = 0U; barrier_index < batch->barrier_count; ++barrier_index) {
+        if (render_graph->resources[batch->barriers[barrier_index].resource].is_image) {
+            render_graph->statistics.image_barrier_count++;
+        } else {
+            render_graph->statistics.buffer_barrier_count++;
+        }
+    }
+}
+
+static VkAccessFlags render_graph_write_access_mask(const VkAccessFlags access_mask) {
+    return access_mask & (VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT);
+}
+
+// Where every resource stands after one execution: its last write and the
+// reads since. Transient resources are shared by all frames in flight, so the
+// next execution has to wait for these accesses of the previous one.
+static void render_graph_compute_last_states(const struct render_graph *render_graph, struct render_graph_tracked_state *last_states) {
+    for (uint32_t resource_index = 0U; resource_index < render_graph->resource_count; ++resource_index) {
+        last_states[resource_index] = (struct render_graph_tracked_state) {0};
+    }
+
+    for (uint32_t pass_index = 0U; pass_index < render_graph->pass_count; ++pass_index) {
+        const struct render_graph_pass *const pass = &render_graph->passes[pass_index];
+
+        if (pass->culled) {
+            continue;
+        }
+
+        for (uint32_t access_index = 0U; access_index < pass->access_count; ++access_index) {
+            const struct render_graph_access access = pass->accesses[access_index];
+            struct render_graph_tracked_state *last_state = &last_states[access.resource];
+
+            if (render_graph_access_types[access.type].write) {
+                last_state->write_stage_mask = render_graph_access_types[access.type].stage_mask;
+                last_state->write_access_mask = render_graph_write_access_mask(render_graph_access_types[access.type].access_mask);
+                last_state->read_stage_mask = 0;
+            } else {
+                last_state->read_stage_mask |= render_graph_access_types[access.type].stage_mask;
+            }
+        }
+    }
+}
+
+// Walks the kept passes in order. A barrier is only added for a layout
+// change, for a read of a write that is not yet visible to its stage, and for
+// a write after earlier accesses. Reads in the same layout share one barrier.
+static void render_graph_compute_barriers(struct render_graph *render_graph) {
+    struct render_graph_tracked_state states[RENDER_GRAPH_MAX_RESOURCES];
+    struct render_graph_tracked_state last_states[RENDER_GRAPH_MAX_RESOURCES];
+    render_graph_compute_last_states(render_graph, last_states);
+
+    for (uint32_t resource_index = 0U; resource_index < render_graph->resource_count; ++resource_index) {
+        const struct render_graph_resource *const resource = &render_graph->resources[resource_index];
+
+        // Imported resources start out as if their initial state was a write.
+        states[resource_index] = (struct render_graph_tracked_state) {
+            .accessed = resource->imported,
+            .layout = resource->imported ? resource->initial_state.layout : VK_IMAGE_LAYOUT_UNDEFINED,
+            .write_stage_mask = resource->imported ? resource->initial_state.stage_mask : 0,
+            .write_access_mask = resource->imported ? resource->initial_state.access_mask : 0,
+            .read_stage_mask = 0,
+            .visible_stage_mask = 0
+        };
+    }
+
+    for (uint32_t pass_index = 0U; pass_index < render_graph->pass_count; ++pass_index) {
+        struct render_graph_pass *pass = &render_graph->passes[pass_index];
+        pass->barrier_batch = (struct render_graph_barrier_batch) {0};
+
+        if (pass->culled) {
+            continue;
+        }
+
+        render_graph->statistics.pass_count++;
+
+        for (uint32_t access_index = 0U; access_index < pass->access_count; ++access_index) {
+            const struct render_graph_access access = pass->accesses[access_index];
+            const struct render_graph_resource *const resource = &render_graph->resources[access.resource];
+            struct render_graph_tracked_state *state = &states[access.resource];
+
+            const VkPipelineStageFlags stage_mask = render_graph_access_types[access.type].stage_mask;
+            const VkAccessFlags access_mask = render_graph_access_types[access.type].access_mask;
+            const VkImageLayout layout = resource->is_image ? render_graph_access_types[access.type].layout : VK_IMAGE_LAYOUT_UNDEFINED;
+            const bool write = render_graph_access_types[access.type].write;
+
+            if (!state->accessed) {
+                // The first use of a transient discards the content and waits
+                // for every use of its memory that may still run: the earlier
+                // resources of this execution it shares memory with, and the
+                // previous execution's uses of the resource itself and of all
+                // its aliases, wherever they were in that frame.
+                VkPipelineStageFlags previous_stage_mask = 0;
+                VkAccessFlags previous_access_mask = 0;
+
+                for (uint32_t other_index = 0U; other_index < render_graph->resource_count; ++other_index) {
+                    const struct render_graph_resource *const other = &render_graph->resources[other_index];
+
+                    if (render_graph_is_transient(other) &&
+                        other->memory_type_index == resource->memory_type_index &&
+                        (other_index == access.resource || render_graph_memory_overlaps(resource, other))) {
+                        previous_stage_mask |= last_states[other_index].write_stage_mask | last_states[other_index].read_stage_mask;
+                        previous_access_mask |= last_states[other_index].write_access_mask;
+                    }
+                }
+
+                render_graph_batch_add(&pass->barrier_batch, access.resource,
+                    previous_stage_mask, previous_access_mask, VK_IMAGE_LAYOUT_UNDEFINED,
+                    stage_mask, access_mask, layout);
+            } else {
+                const bool has_write = state->write_stage_mask != 0;
+                const bool layout_change = resource->is_image && layout != state->layout;
+                const bool write_not_visible = has_write && (state->visible_stage_mask & stage_mask) != stage_mask;
+
+                if (layout_change || write || write_not_visible) {
+                    render_graph_batch_add(&pass->barrier_batch, access.resource,
+                        state->write_stage_mask | state->read_stage_mask, state->write_access_mask, state->layout,
+                        stage_mask, access_mask, layout);
+
+                    state->visible_stage_mask |= stage_mask;
+                }
+            }
+
+            state->accessed = true;
+            state->layout = layout;
+
+            if (write) {
+                state->write_stage_mask = stage_mask;
+                state->write_access_mask = render_graph_write_access_mask(access_mask);
+                state->read_stage_mask = 0;
+                state->visible_stage_mask = 0;
+            } else {
+                state->read_stage_mask |= stage_mask;
+            }
+        }
+
+        render_graph_count_batch(render_graph, &pass->barrier_batch);
+    }
+
+    render_graph->final_barrier_batch = (struct render_graph_barrier_batch) {0};
+
+    for (uint32_t resource_index = 0U; resource_index < render_graph->resource_count; ++resource_index) {
+        const struct render_graph_resource *const resource = &render_graph->resources[resource_index];
+        const struct render_graph_tracked_state *const state = &states[resource_index];
+
+        if (!resource->imported || !resource->output || resource->first_pass == UINT32_MAX) {
+            continue;
+        }
+
+        render_graph_batch_add(&render_graph->final_barrier_batch, resource_index,
+            state->write_stage_mask | state->read_stage_mask, state->write_access_mask, state->layout,
+            resource->final_state.stage_mask, resource->final_state.access_mask, resource->is_image ? resource->final_state.layout : VK_IMAGE_LAYOUT_UNDEFINED);
+    }
+
+    render_graph_count_batch(render_graph, &render_graph->final_barrier_batch);
+}
+
+void render_graph_compile(struct render_graph *render_graph) {
+    render_graph_cull(render_graph);
+    render_graph_create_resources(render_graph);
+    render_graph_place_resources(render_graph);
+    render_graph_compute_barriers(render_graph);
+
+    render_graph->statistics.culled_pass_count = render_graph->pass_count - render_graph->statistics.pass_count;
+    render_graph->compiled = true;
+}
+
+void render_graph_set_image(struct render_graph *render_graph, const uint32_t resource, const VkImage image, const VkImageView image_view) {
+    render_graph->resources[resource].image = image;
+    render_graph->resources[resource].image_view = image_view;
+}
+
+void render_graph_set_buffer(struct render_graph *render_graph, const uint32_t resource, const VkBuffer buffer) {
+    render_graph->resources[resource].buffer = buffer;
+}
+
+static void render_graph_record_barrier_batch(
+    const struct render_graph *render_graph,
+    const VkCommandBuffer command_buffer,
+    const struct render_graph_barrier_batch *const batch
+) {
+    if (batch->barrier_count == 0U) {
+        return;
+    }
+
+    VkImageMemoryBarrier image_memory_barriers[RENDER_GRAPH_MAX_RESOURCES];
+    VkBufferMemoryBarrier buffer_memory_barriers[RENDER_GRAPH_MAX_RESOURCES];
+    uint32_t image_memory_barrier_count = 0U;
+    uint32_t buffer_memory_barrier_count = 0U;
+
+    for (uint32_t barrier_index = 0U; barrier_index < batch->barrier_count; ++barrier_index) {
+        const struct render_graph_barrier *const barrier = &batch->barriers[barrier_index];
+        const struct render_graph_resource *const resource = &render_graph->resources[barrier->resource];
+
+        if (resource->is_image) {
+            image_memory_barriers[image_memory_barrier_count++] = (VkImageMemoryBarrier) {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                .pNext = NULL,
+                .srcAccessMask = barrier->src_access_mask,
+                .dstAccessMask = barrier->dst_access_mask,
+                .oldLayout = barrier->old_layout,
+                .newLayout = barrier->new_layout,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image = resource->image,
+                .subresourceRange.aspectMask = render_graph_format_aspect(resource->image_description.format),
+                .subresourceRange.baseMipLevel = 0,
+                .subresourceRange.levelCount = 1,
+                .subresourceRange.baseArrayLayer = 0,
+                .subresourceRange.layerCount = 1
+            };
+        } else {
+            buffer_memory_barriers[buffer_memory_barrier_count++] = (VkBufferMemoryBarrier) {
+                .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                .pNext = NULL,
+                .srcAccessMask = barrier->src_access_mask,
+                .dstAccessMask = barrier->dst_access_mask,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .buffer = resource->buffer,
+                .offset = 0,
+                .size = VK_WHOLE_SIZE
+            };
+        }
+    }
+
+    vkCmdPipelineBarrier(
+        command_buffer,
+        batch->src_stage_mask ? batch->src_stage_mask : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+        batch->dst_stage_mask ? batch->dst_stage_mask : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        0,
+        0, NULL,
+        buffer_memory_barrier_count, buffer_memory_barriers,
+        image_memory_barrier_count, image_memory_barriers);
+}
+
+void render_graph_execute(struct render_graph *render_graph, const VkCommandBuffer command_buffer, void *frame_data) {
+    if (!render_graph->compiled) {
+        fprintf(stderr, "error: render graph has not been compiled\n");
+        exit(1);
+    }
+
+    for (uint32_t pass_index = 0U; pass_index < render_graph->pass_count; ++pass_index) {
+        const struct render_graph_pass *const pass = &render_graph->passes[pass_index];
+
+        if (pass->culled) {
+            continue;
+        }
+
+        render_graph_record_barrier_batch(render_graph, command_buffer, &pass->barrier_batch);
+        pass->record(command_buffer, render_graph, frame_data);
+    }
+
+    render_graph_record_barrier_batch(render_graph, command_buffer, &render_graph->final_barrier_batch);
+}
+
+VkImage render_graph_get_image(const struct render_graph *render_graph, const uint32_t resource) {
+    return render_graph->resources[resource].image;
+}
+
+VkImageView render_graph_get_image_view(const struct render_graph *render_graph, const uint32_t resource) {
+    return render_graph->resources[resource].image_view;
+}
+
+VkBuffer render_graph_get_buffer(const struct render_graph *render_graph, const uint32_t resource) {
+    return render_graph->resources[resource].buffer;
+}
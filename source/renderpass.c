@@ -1,59 +1,195 @@
 #include <renderpass.h>
 
+#include <hash.h>
+
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
-VkRenderPass render_pass_create(const VkDevice device, const VkSurfaceFormatKHR surface_format) {
-    const VkAttachmentDescription attachment_description = {
-        .flags = 0,
-        .format = surface_format.format,
-        .samples = VK_SAMPLE_COUNT_1_BIT,
-        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
-        .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
-        .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-        .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-        .finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+void render_pass_description_init(
+    struct render_pass_description *description,
+    const VkFormat color_format,
+    const VkFormat depth_format,
+    const VkSampleCountFlagBits sample_count
+) {
+    memset(description, 0, sizeof *description);
+
+    const bool multisampled = sample_count != VK_SAMPLE_COUNT_1_BIT;
+
+    description->color_attachment_count = 1;
+    description->color_attachments[0] = (struct render_pass_attachment) {
+        .format = color_format,
+        .samples = sample_count,
+        .load_op = VK_ATTACHMENT_LOAD_OP_CLEAR,
+        .store_op = multisampled ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE,
+        .initial_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        .final_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
     };
 
-    const VkAttachmentReference attachment_reference = {
-        .attachment = 0,
-        .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+    if (multisampled) {
+        description->has_resolve_attachments = VK_TRUE;
+        description->resolve_attachments[0] = (struct render_pass_attachment) {
+            .format = color_format,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .load_op = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            .store_op = VK_ATTACHMENT_STORE_OP_STORE,
+            .initial_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            .final_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+        };
+    }
+
+    if (depth_format == VK_FORMAT_UNDEFINED) {
+        return;
+    }
+
+    description->has_depth_attachment = VK_TRUE;
+    description->depth_attachment = (struct render_pass_attachment) {
+        .format = depth_format,
+        .samples = sample_count,
+        .load_op = VK_ATTACHMENT_LOAD_OP_CLEAR,
+        .store_op = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        .initial_layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        .final_layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
     };
+}
+
+void render_pass_description_init_deferred(
+    struct render_pass_description *description,
+    const VkFormat gbuffer_format,
+    const VkFormat depth_format,
+    const VkFormat color_format
+) {
+    render_pass_description_init(description, gbuffer_format, depth_format, VK_SAMPLE_COUNT_1_BIT);
+
+    description->color_attachments[0].store_op = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+    // The lighting subpass writes every pixel of the render area.
+    description->has_lighting_subpass = VK_TRUE;
+    description->lighting_attachment = (struct render_pass_attachment) {
+        .format = color_format,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .load_op = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+        .store_op = VK_ATTACHMENT_STORE_OP_STORE,
+        .initial_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        .final_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+    };
+}
+
+VkRenderPass render_pass_create_from_description(const VkDevice device, const struct render_pass_description *const description) {
+    if (description->has_lighting_subpass && description->has_resolve_attachments) {
+        fprintf(stderr, "error: a render pass with a lighting subpass cannot resolve\n");
+        exit(1);
+    }
+
+    VkAttachmentDescription attachment_descriptions[2U * RENDER_PASS_MAX_COLOR_ATTACHMENTS + 1U];
+    VkAttachmentReference attachment_references[2U * RENDER_PASS_MAX_COLOR_ATTACHMENTS + 1U];
+    const uint32_t depth_attachment_count = description->has_depth_attachment ? 1U : 0U;
+    const uint32_t resolve_attachment_offset = description->color_attachment_count + depth_attachment_count;
+    const uint32_t lighting_attachment_index = resolve_attachment_offset;
+    const uint32_t attachment_count = resolve_attachment_offset
+        + (description->has_resolve_attachments ? description->color_attachment_count : 0U)
+        + (description->has_lighting_subpass ? 1U : 0U);
+
+    for (uint32_t attachment_index = 0U; attachment_index < attachment_count; ++attachment_index) {
+        const bool is_depth_attachment = depth_attachment_count != 0U && attachment_index == description->color_attachment_count;
+        const struct render_pass_attachment *attachment = &description->color_attachments[attachment_index];
+
+        if (is_depth_attachment) {
+            attachment = &description->depth_attachment;
+        } else if (description->has_lighting_subpass && attachment_index == lighting_attachment_index) {
+            attachment = &description->lighting_attachment;
+        } else if (attachment_index >= resolve_attachment_offset) {
+            attachment = &description->resolve_attachments[attachment_index - resolve_attachment_offset];
+        }
+
+        attachment_descriptions[attachment_index] = (VkAttachmentDescription) {
+            .flags = 0,
+            .format = attachment->format,
+            .samples = attachment->samples,
+            .loadOp = attachment->load_op,
+            .storeOp = attachment->store_op,
+            .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .initialLayout = attachment->initial_layout,
+            .finalLayout = attachment->final_layout
+        };
 
-    const VkSubpassDescription subpass_description = {
+        attachment_references[attachment_index] = (VkAttachmentReference) {
+            .attachment = attachment_index,
+            .layout = is_depth_attachment ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+        };
+    }
+
+    VkSubpassDescription subpass_descriptions[2];
+
+    subpass_descriptions[0] = (VkSubpassDescription) {
         .flags = 0,
         .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
         .inputAttachmentCount = 0,
         .pInputAttachments = NULL,
+        .colorAttachmentCount = description->color_attachment_count,
+        .pColorAttachments = attachment_references,
+        .pResolveAttachments = description->has_resolve_attachments ? &attachment_references[resolve_attachment_offset] : NULL,
+        .pDepthStencilAttachment = description->has_depth_attachment ? &attachment_references[description->color_attachment_count] : NULL,
+        .preserveAttachmentCount = 0,
+        .pPreserveAttachments = NULL
+    };
+
+    // Every attachment of the first subpass is read back at the same pixel.
+    VkAttachmentReference input_attachment_references[RENDER_PASS_MAX_COLOR_ATTACHMENTS + 1U];
+
+    for (uint32_t attachment_index = 0U; attachment_index < resolve_attachment_offset; ++attachment_index) {
+        const bool is_depth_attachment = depth_attachment_count != 0U && attachment_index == description->color_attachment_count;
+
+        input_attachment_references[attachment_index] = (VkAttachmentReference) {
+            .attachment = attachment_index,
+            .layout = is_depth_attachment ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        };
+    }
+
+    const VkAttachmentReference lighting_attachment_reference = {
+        .attachment = lighting_attachment_index,
+        .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+    };
+
+    subpass_descriptions[1] = (VkSubpassDescription) {
+        .flags = 0,
+        .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+        .inputAttachmentCount = resolve_attachment_offset,
+        .pInputAttachments = input_attachment_references,
         .colorAttachmentCount = 1,
-        .pColorAttachments = &attachment_reference,
+        .pColorAttachments = &lighting_attachment_reference,
         .pResolveAttachments = NULL,
         .pDepthStencilAttachment = NULL,
         .preserveAttachmentCount = 0,
         .pPreserveAttachments = NULL
     };
 
-    const VkSubpassDependency subpass_dependency = {
-        .srcSubpass = VK_SUBPASS_EXTERNAL,
-        .dstSubpass = 0,
-        .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-        .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-        .srcAccessMask = 0,
-        .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-        .dependencyFlags = 0
+    // By region, so each tile is lit as soon as its G-buffer is complete
+    // instead of after the whole first subpass.
+    const VkSubpassDependency lighting_subpass_dependency = {
+        .srcSubpass = 0,
+        .dstSubpass = 1,
+        .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+        .dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT,
+        .dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT
     };
 
+    // The render graph transitions the images before and after the render
+    // pass, see context_build_render_graph.
     const VkRenderPassCreateInfo render_pass_create_info = {
         .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
         .pNext = NULL,
         .flags = 0,
-        .attachmentCount = 1,
-        .pAttachments = &attachment_description,
-        .subpassCount = 1,
-        .pSubpasses = &subpass_description,
-        .dependencyCount = 1,
-        .pDependencies = &subpass_dependency
+        .attachmentCount = attachment_count,
+        .pAttachments = attachment_descriptions,
+        .subpassCount = description->has_lighting_subpass ? 2 : 1,
+        .pSubpasses = subpass_descriptions,
+        .dependencyCount = description->has_lighting_subpass ? 1 : 0,
+        .pDependencies = description->has_lighting_subpass ? &lighting_subpass_dependency : NULL
     };
 
     VkRenderPass render_pass;
@@ -67,6 +203,97 @@ VkRenderPass render_pass_create(const VkDevice device, const VkSurfaceFormatKHR
     return render_pass;
 }
 
+VkRenderPass render_pass_create(const VkDevice device, const VkSurfaceFormatKHR surface_format, const VkFormat depth_format, const VkSampleCountFlagBits sample_count) {
+    struct render_pass_description description;
+    render_pass_description_init(&description, surface_format.format, depth_format, sample_count);
+
+    return render_pass_create_from_description(device, &description);
+}
+
 void render_pass_destroy(const VkRenderPass render_pass, const VkDevice device) {
     vkDestroyRenderPass(device, render_pass, NULL);
 }
+
+struct render_pass_cache *render_pass_cache_create(const VkDevice device) {
+    struct render_pass_cache *render_pass_cache = malloc(sizeof *render_pass_cache);
+
+    render_pass_cache->device = device;
+    render_pass_cache->entry_capacity = 16U;
+    render_pass_cache->entries = calloc(render_pass_cache->entry_capacity, sizeof *render_pass_cache->entries);
+    render_pass_cache->statistics = (struct render_pass_cache_statistics) {0};
+
+    return render_pass_cache;
+}
+
+void render_pass_cache_destroy(struct render_pass_cache *render_pass_cache) {
+    for (uint32_t slot = 0U; slot < render_pass_cache->entry_capacity; ++slot) {
+        if (render_pass_cache->entries[slot].render_pass != VK_NULL_HANDLE) {
+            render_pass_destroy(render_pass_cache->entries[slot].render_pass, render_pass_cache->device);
+        }
+    }
+
+    free(render_pass_cache->entries);
+    free(render_pass_cache);
+}
+
+static uint32_t render_pass_cache_find_slot(
+    const struct render_pass_cache_entry *const entries,
+    const uint32_t entry_capacity,
+    const uint64_t hash,
+    const struct render_pass_description *const description
+) {
+    uint32_t slot = (uint32_t) hash & (entry_capacity - 1U);
+
+    while (entries[slot].render_pass != VK_NULL_HANDLE) {
+        if (entries[slot].hash == hash && memcmp(&entries[slot].description, description, sizeof *description) == 0) {
+            break;
+        }
+
+        slot = (slot + 1U) & (entry_capacity - 1U);
+    }
+
+    return slot;
+}
+
+static void render_pass_cache_grow(struct render_pass_cache *render_pass_cache) {
+    const uint32_t entry_capacity = render_pass_cache->entry_capacity * 2U;
+    struct render_pass_cache_entry *entries = calloc(entry_capacity, sizeof *entries);
+
+    for (uint32_t slot = 0U; slot < render_pass_cache->entry_capacity; ++slot) {
+        const struct render_pass_cache_entry *const entry = &render_pass_cache->entries[slot];
+
+        if (entry->render_pass != VK_NULL_HANDLE) {
+            entries[render_pass_cache_find_slot(entries, entry_capacity, entry->hash, &entry->description)] = *entry;
+        }
+    }
+
+    free(render_pass_cache->entries);
+    render_pass_cache->entries = entries;
+    render_pass_cache->entry_capacity = entry_capacity;
+}
+
+VkRenderPass render_pass_cache_get(struct render_pass_cache *render_pass_cache, const struct render_pass_description *const description) {
+    const uint64_t hash = hash_bytes(description, sizeof *description, 0U);
+
+    render_pass_cache->statistics.request_count++;
+
+    const uint32_t slot = render_pass_cache_find_slot(render_pass_cache->entries, render_pass_cache->entry_capacity, hash, description);
+    struct render_pass_cache_entry *entry = &render_pass_cache->entries[slot];
+
+    if (entry->render_pass != VK_NULL_HANDLE) {
+        render_pass_cache->statistics.hit_count++;
+        return entry->render_pass;
+    }
+
+    entry->description = *description;
+    entry->hash = hash;
+    entry->render_pass = render_pass_create_from_description(render_pass_cache->device, description);
+
+    const VkRenderPass render_pass = entry->render_pass;
+
+    if (++render_pass_cache->statistics.render_pass_count * 2U > render_pass_cache->entry_capacity) {
+        render_pass_cache_grow(render_pass_cache);
+    }
+
+    return render_pass;
+}
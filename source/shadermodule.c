@@ -1,28 +1,86 @@
 #include <shadermodule.h>
 
+#include <hash.h>
+#include <shaderregistry.h>
+
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Two independently seeded hashes and the size form the content address.
+static const uint64_t shader_module_content_seeds[2] = {0x5350495256ULL, 0x6C6561726E2D766BULL};
+
+struct shader_module_code {
+    const uint32_t *code;
+    size_t code_size;
+    void *mapping;
+};
+
+// Maps the file read-only. The pages are shared with the page cache, so a
+// shader is never copied into a heap buffer.
+static struct shader_module_code shader_module_map_file(const char *const path) {
+    const int file_descriptor = open(path, O_RDONLY);
+
+    if (file_descriptor < 0) {
+        fprintf(stderr, "error: failed to open shader module file '%s'\n", path);
+        exit(1);
+    }
+
+    struct stat file_status;
+
+    if (fstat(file_descriptor, &file_status) != 0 || file_status.st_size <= 0 || file_status.st_size % sizeof (uint32_t) != 0) {
+        fprintf(stderr, "error: shader module file '%s' is not SPIR-V\n", path);
+        exit(1);
+    }
+
+    void *mapping = mmap(NULL, file_status.st_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+    close(file_descriptor);
 
-VkShaderModule shader_module_create(const VkDevice device, const char *const path) {
-    FILE *shader_module_file = fopen(path, "rb");
+    if (mapping == MAP_FAILED) {
+        fprintf(stderr, "error: failed to map shader module file '%s'\n", path);
+        exit(1);
+    }
+
+    return (struct shader_module_code) {.code = mapping, .code_size = file_status.st_size, .mapping = mapping};
+}
+
+// Returns the embedded SPIR-V of the named shader, or the mapped <name>.spv
+// when LEARN_VULKAN_SHADER_DIRECTORY is set for development.
+static struct shader_module_code shader_module_get_code(const char *const name) {
+    const char *const shader_directory = getenv("LEARN_VULKAN_SHADER_DIRECTORY");
+
+    if (shader_directory != NULL && shader_directory[0] != '\0') {
+        char path[4096];
+        snprintf(path, sizeof path, "%s/%s.spv", shader_directory, name);
+        return shader_module_map_file(path);
+    }
+
+    const struct shader_registry_entry *const shader_registry_entry = shader_registry_find(name);
 
-    if (!shader_module_file) {
-        fprintf(stderr, "error: failed to open vertex shader module file\n");
+    if (shader_registry_entry == NULL) {
+        fprintf(stderr, "error: no embedded shader named '%s'\n", name);
         exit(1);
     }
 
-    fseek(shader_module_file, 0L, SEEK_END);
-    const uint64_t shader_module_file_size = ftell(shader_module_file);
-    fseek(shader_module_file, 0L, SEEK_SET);
-    char *shader_module_file_buffer = malloc(shader_module_file_size * (sizeof *shader_module_file_buffer));
-    fread(shader_module_file_buffer, shader_module_file_size, 1, shader_module_file);
+    return (struct shader_module_code) {.code = shader_registry_entry->code, .code_size = shader_registry_entry->code_size, .mapping = NULL};
+}
+
+static void shader_module_free_code(const struct shader_module_code code) {
+    if (code.mapping != NULL) {
+        munmap(code.mapping, code.code_size);
+    }
+}
 
+static VkShaderModule shader_module_create_from_code(const VkDevice device, const uint32_t *const code, const size_t code_size) {
     const VkShaderModuleCreateInfo shader_module_create_info = {
         .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
         .pNext = NULL,
         .flags = 0,
-        .codeSize = shader_module_file_size,
-        .pCode = (uint32_t *) shader_module_file_buffer,
+        .codeSize = code_size,
+        .pCode = code,
     };
 
     VkShaderModule shader_module = VK_NULL_HANDLE;
@@ -33,8 +91,191 @@ VkShaderModule shader_module_create(const VkDevice device, const char *const pat
         exit(1);
     }
 
-    fclose(shader_module_file);
-    free(shader_module_file_buffer);
+    return shader_module;
+}
+
+VkShaderModule shader_module_create(const VkDevice device, const char *const name) {
+    const struct shader_module_code code = shader_module_get_code(name);
+    const VkShaderModule shader_module = shader_module_create_from_code(device, code.code, code.code_size);
+    shader_module_free_code(code);
 
     return shader_module;
 }
+
+struct shader_module_cache *shader_module_cache_create(const VkDevice device) {
+    struct shader_module_cache *shader_module_cache = malloc(sizeof *shader_module_cache);
+
+    shader_module_cache->device = device;
+    shader_module_cache->module_capacity = 32U;
+    shader_module_cache->modules = calloc(shader_module_cache->module_capacity, sizeof *shader_module_cache->modules);
+    shader_module_cache->statistics = (struct shader_module_cache_statistics) {0};
+    pthread_mutex_init(&shader_module_cache->mutex, NULL);
+
+    return shader_module_cache;
+}
+
+void shader_module_cache_destroy(struct shader_module_cache *shader_module_cache) {
+    if (shader_module_cache->statistics.module_count > 0U) {
+        fprintf(stderr, "error: %u shader modules are still acquired\n", shader_module_cache->statistics.module_count);
+        exit(1);
+    }
+
+    pthread_mutex_destroy(&shader_module_cache->mutex);
+    free(shader_module_cache->modules);
+    free(shader_module_cache);
+}
+
+static uint32_t shader_module_cache_find_slot(
+    struct shader_module *const *const modules,
+    const uint32_t module_capacity,
+    const uint64_t content_hash[2],
+    const size_t code_size
+) {
+    uint32_t slot = (uint32_t) content_hash[0] & (module_capacity - 1U);
+
+    while (modules[slot] != NULL) {
+        if (modules[slot]->content_hash[0] == content_hash[0] && modules[slot]->content_hash[1] == content_hash[1] && modules[slot]->code_size == code_size) {
+            break;
+        }
+
+        slot = (slot + 1U) & (module_capacity - 1U);
+    }
+
+    return slot;
+}
+
+static void shader_module_cache_grow(struct shader_module_cache *shader_module_cache) {
+    const uint32_t module_capacity = shader_module_cache->module_capacity * 2U;
+    struct shader_module **modules = calloc(module_capacity, sizeof *modules);
+
+    for (uint32_t slot = 0U; slot < shader_module_cache->module_capacity; ++slot) {
+        struct shader_module *shader_module = shader_module_cache->modules[slot];
+
+        if (shader_module != NULL) {
+            modules[shader_module_cache_find_slot(modules, module_capacity, shader_module->content_hash, shader_module->code_size)] = shader_module;
+        }
+    }
+
+    free(shader_module_cache->modules);
+    shader_module_cache->modules = modules;
+    shader_module_cache->module_capacity = module_capacity;
+}
+
+struct shader_module *shader_module_cache_try_acquire_code(
+    struct shader_module_cache *shader_module_cache,
+    const uint32_t *const code,
+    const size_t code_size,
+    char *const message,
+    const size_t message_size
+) {
+    const uint64_t content_hash[2] = {
+        hash_bytes(code, code_size, shader_module_content_seeds[0]),
+        hash_bytes(code, code_size, shader_module_content_seeds[1])
+    };
+
+    pthread_mutex_lock(&shader_module_cache->mutex);
+
+    shader_module_cache->statistics.request_count++;
+
+    const uint32_t slot = shader_module_cache_find_slot(shader_module_cache->modules, shader_module_cache->module_capacity, content_hash, code_size);
+    struct shader_module *shader_module = shader_module_cache->modules[slot];
+
+    if (shader_module != NULL) {
+        shader_module->reference_count++;
+        shader_module_cache->statistics.hit_count++;
+        pthread_mutex_unlock(&shader_module_cache->mutex);
+        return shader_module;
+    }
+
+    shader_module = malloc(sizeof *shader_module);
+
+    // Reflection also validates the code before it reaches the driver.
+    if (!shader_reflection_try_parse(code, code_size, &shader_module->reflection, message, message_size)) {
+        pthread_mutex_unlock(&shader_module_cache->mutex);
+        free(shader_module);
+        return NULL;
+    }
+
+    shader_module->handle = shader_module_create_from_code(shader_module_cache->device, code, code_size);
+    shader_module->content_hash[0] = content_hash[0];
+    shader_module->content_hash[1] = content_hash[1];
+    shader_module->code_size = code_size;
+    shader_module->reference_count = 1U;
+
+    shader_module_cache->modules[slot] = shader_module;
+
+    if (++shader_module_cache->statistics.module_count * 2U > shader_module_cache->module_capacity) {
+        shader_module_cache_grow(shader_module_cache);
+    }
+
+    pthread_mutex_unlock(&shader_module_cache->mutex);
+
+    return shader_module;
+}
+
+struct shader_module *shader_module_cache_acquire_code(
+    struct shader_module_cache *shader_module_cache,
+    const uint32_t *const code,
+    const size_t code_size
+) {
+    char message[128];
+    struct shader_module *shader_module = shader_module_cache_try_acquire_code(shader_module_cache, code, code_size, message, sizeof message);
+
+    if (shader_module == NULL) {
+        fprintf(stderr, "error: %s\n", message);
+        exit(1);
+    }
+
+    return shader_module;
+}
+
+struct shader_module *shader_module_cache_acquire(struct shader_module_cache *shader_module_cache, const char *const name) {
+    const struct shader_module_code code = shader_module_get_code(name);
+    struct shader_module *shader_module = shader_module_cache_acquire_code(shader_module_cache, code.code, code.code_size);
+    shader_module_free_code(code);
+
+    return shader_module;
+}
+
+void shader_module_cache_release(struct shader_module_cache *shader_module_cache, struct shader_module *shader_module) {
+    pthread_mutex_lock(&shader_module_cache->mutex);
+
+    if (--shader_module->reference_count > 0U) {
+        pthread_mutex_unlock(&shader_module_cache->mutex);
+        return;
+    }
+
+    // Backward shift deletion keeps every probe sequence free of holes.
+    const uint32_t mask = shader_module_cache->module_capacity - 1U;
+    uint32_t slot = shader_module_cache_find_slot(shader_module_cache->modules, shader_module_cache->module_capacity, shader_module->content_hash, shader_module->code_size);
+    uint32_t next_slot = (slot + 1U) & mask;
+
+    shader_module_cache->modules[slot] = NULL;
+
+    while (shader_module_cache->modules[next_slot] != NULL) {
+        const uint32_t home_slot = (uint32_t) shader_module_cache->modules[next_slot]->content_hash[0] & mask;
+
+        if (((next_slot - home_slot) & mask) >= ((next_slot - slot) & mask)) {
+            shader_module_cache->modules[slot] = shader_module_cache->modules[next_slot];
+            shader_module_cache->modules[next_slot] = NULL;
+            slot = next_slot;
+        }
+
+        next_slot = (next_slot + 1U) & mask;
+    }
+
+    shader_module_cache->statistics.module_count--;
+
+    pthread_mutex_unlock(&shader_module_cache->mutex);
+
+    vkDestroyShaderModule(shader_module_cache->device, shader_module->handle, NULL);
+    free(shader_module);
+}
+
+struct shader_module_cache_statistics shader_module_cache_get_statistics(struct shader_module_cache *shader_module_cache) {
+    pthread_mutex_lock(&shader_module_cache->mutex);
+    const struct shader_module_cache_statistics statistics = shader_module_cache->statistics;
+    pthread_mutex_unlock(&shader_module_cache->mutex);
+
+    return statistics;
+}
@@ -0,0 +1,682 @@
+#include <shaderreflection.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SPIRV_MAGIC 0x07230203U
+
+#define SPIRV_OP_NAME 5U
+#define SPIRV_OP_ENTRY_POINT 15U
+#define SPIRV_OP_TYPE_INT 21U
+#define SPIRV_OP_TYPE_FLOAT 22U
+#define SPIRV_OP_TYPE_VECTOR 23U
+#define SPIRV_OP_TYPE_MATRIX 24U
+#define SPIRV_OP_TYPE_IMAGE 25U
+#define SPIRV_OP_TYPE_SAMPLER 26U
+#define SPIRV_OP_TYPE_SAMPLED_IMAGE 27U
+#define SPIRV_OP_TYPE_ARRAY 28U
+#define SPIRV_OP_TYPE_RUNTIME_ARRAY 29U
+#define SPIRV_OP_TYPE_STRUCT 30U
+#define SPIRV_OP_TYPE_POINTER 32U
+#define SPIRV_OP_CONSTANT 43U
+#define SPIRV_OP_SPEC_CONSTANT_TRUE 48U
+#define SPIRV_OP_SPEC_CONSTANT_FALSE 49U
+#define SPIRV_OP_SPEC_CONSTANT 50U
+#define SPIRV_OP_VARIABLE 59U
+#define SPIRV_OP_DECORATE 71U
+#define SPIRV_OP_MEMBER_DECORATE 72U
+
+#define SPIRV_DECORATION_SPEC_ID 1U
+#define SPIRV_DECORATION_BLOCK 2U
+#define SPIRV_DECORATION_BUFFER_BLOCK 3U
+#define SPIRV_DECORATION_ARRAY_STRIDE 6U
+#define SPIRV_DECORATION_MATRIX_STRIDE 7U
+#define SPIRV_DECORATION_BUILT_IN 11U
+#define SPIRV_DECORATION_LOCATION 30U
+#define SPIRV_DECORATION_BINDING 33U
+#define SPIRV_DECORATION_DESCRIPTOR_SET 34U
+#define SPIRV_DECORATION_OFFSET 35U
+
+#define SPIRV_STORAGE_CLASS_UNIFORM_CONSTANT 0U
+#define SPIRV_STORAGE_CLASS_INPUT 1U
+#define SPIRV_STORAGE_CLASS_UNIFORM 2U
+#define SPIRV_STORAGE_CLASS_PUSH_CONSTANT 9U
+#define SPIRV_STORAGE_CLASS_STORAGE_BUFFER 12U
+
+#define SPIRV_DIM_BUFFER 5U
+#define SPIRV_DIM_SUBPASS_DATA 6U
+
+// Everything known about one SPIR-V id, filled by a single pass over the module.
+struct spirv_id {
+    uint32_t opcode;
+    uint32_t first_operand;
+    uint32_t operand_count;
+    uint32_t location;
+    uint32_t binding;
+    uint32_t set;
+    uint32_t array_stride;
+    uint32_t constant;
+    uint32_t spec_id;
+    uint32_t name_word;
+    uint32_t name_word_count;
+    uint8_t has_location;
+    uint8_t has_spec_id;
+    uint8_t is_built_in;
+    uint8_t is_block;
+    uint8_t is_buffer_block;
+};
+
+struct spirv_member_decoration {
+    uint32_t struct_id;
+    uint32_t member;
+    uint32_t offset;
+    uint32_t matrix_stride;
+};
+
+struct spirv_module {
+    const uint32_t *code;
+    uint32_t word_count;
+    uint32_t id_bound;
+    struct spirv_id *ids;
+    struct spirv_member_decoration *member_decorations;
+    uint32_t member_decoration_count;
+    uint32_t member_decoration_capacity;
+    // The first failure, parsing stops at the next instruction or variable.
+    // Until then invalid ids resolve to invalid_id and operands read as zero.
+    const char *error;
+    struct spirv_id invalid_id;
+};
+
+static void spirv_fail(struct spirv_module *module, const char *const error) {
+    if (module->error == NULL) {
+        module->error = error;
+    }
+}
+
+static struct spirv_id *spirv_get_id(struct spirv_module *module, const uint32_t id) {
+    if (id >= module->id_bound) {
+        spirv_fail(module, "malformed SPIR-V in shader module");
+        module->invalid_id = (struct spirv_id) {0};
+        return &module->invalid_id;
+    }
+
+    return &module->ids[id];
+}
+
+static uint32_t spirv_operand(struct spirv_module *module, const uint32_t id, const uint32_t operand) {
+    const struct spirv_id *const spirv_id = spirv_get_id(module, id);
+
+    if (operand >= spirv_id->operand_count) {
+        spirv_fail(module, "malformed SPIR-V in shader module");
+        return 0U;
+    }
+
+    return module->code[spirv_id->first_operand + operand];
+}
+
+static struct spirv_member_decoration *spirv_get_member_decoration(struct spirv_module *module, const uint32_t struct_id, const uint32_t member) {
+    for (uint32_t index = 0U; index < module->member_decoration_count; ++index) {
+        if (module->member_decorations[index].struct_id == struct_id && module->member_decorations[index].member == member) {
+            return &module->member_decorations[index];
+        }
+    }
+
+    if (module->member_decoration_count == module->member_decoration_capacity) {
+        module->member_decoration_capacity = module->member_decoration_capacity ? module->member_decoration_capacity * 2U : 32U;
+        module->member_decorations = realloc(module->member_decorations, module->member_decoration_capacity * (sizeof *module->member_decorations));
+    }
+
+    struct spirv_member_decoration *member_decoration = &module->member_decorations[module->member_decoration_count++];
+    *member_decoration = (struct spirv_member_decoration) {.struct_id = struct_id, .member = member, .offset = 0U, .matrix_stride = 0U};
+
+    return member_decoration;
+}
+
+static uint32_t spirv_get_type_size(struct spirv_module *module, const uint32_t type_id) {
+    switch (spirv_get_id(module, type_id)->opcode) {
+        case SPIRV_OP_TYPE_INT:
+        case SPIRV_OP_TYPE_FLOAT:
+            return spirv_operand(module, type_id, 1) / 8U;
+        case SPIRV_OP_TYPE_VECTOR:
+            return spirv_get_type_size(module, spirv_operand(module, type_id, 1)) * spirv_operand(module, type_id, 2);
+        case SPIRV_OP_TYPE_MATRIX:
+            return spirv_get_type_size(module, spirv_operand(module, type_id, 1)) * spirv_operand(module, type_id, 2);
+        case SPIRV_OP_TYPE_ARRAY: {
+            const uint32_t length = spirv_get_id(module, spirv_operand(module, type_id, 2))->constant;
+            const uint32_t stride = spirv_get_id(module, type_id)->array_stride;
+            return length * (stride ? stride : spirv_get_type_size(module, spirv_operand(module, type_id, 1)));
+        }
+        case SPIRV_OP_TYPE_STRUCT: {
+            uint32_t size = 0U;
+
+            for (uint32_t member = 0U; member + 1U < spirv_get_id(module, type_id)->operand_count; ++member) {
+                const uint32_t member_type_id = spirv_operand(module, type_id, member + 1U);
+                const struct spirv_member_decoration *const member_decoration = spirv_get_member_decoration(module, type_id, member);
+                uint32_t member_size = spirv_get_type_size(module, member_type_id);
+
+                // Matrix columns are padded to the matrix stride.
+                if (spirv_get_id(module, member_type_id)->opcode == SPIRV_OP_TYPE_MATRIX && member_decoration->matrix_stride) {
+                    member_size = member_decoration->matrix_stride * spirv_operand(module, member_type_id, 2);
+                }
+
+                if (member_decoration->offset + member_size > size) {
+                    size = member_decoration->offset + member_size;
+                }
+            }
+
+            return size;
+        }
+        default:
+            return 0U;
+    }
+}
+
+static VkFormat spirv_get_input_format(struct spirv_module *module, const uint32_t type_id) {
+    uint32_t component_type_id = type_id;
+    uint32_t component_count = 1U;
+
+    if (spirv_get_id(module, type_id)->opcode == SPIRV_OP_TYPE_VECTOR) {
+        component_type_id = spirv_operand(module, type_id, 1);
+        component_count = spirv_operand(module, type_id, 2);
+    }
+
+    const VkFormat float_formats[] = {VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT};
+    const VkFormat sint_formats[] = {VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT};
+    const VkFormat uint_formats[] = {VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT};
+
+    if (component_count < 1U || component_count > 4U || spirv_operand(module, component_type_id, 1) != 32U) {
+        return VK_FORMAT_UNDEFINED;
+    }
+
+    if (spirv_get_id(module, component_type_id)->opcode == SPIRV_OP_TYPE_FLOAT) {
+        return float_formats[component_count - 1U];
+    }
+
+    if (spirv_get_id(module, component_type_id)->opcode == SPIRV_OP_TYPE_INT) {
+        return spirv_operand(module, component_type_id, 2) ? sint_formats[component_count - 1U] : uint_formats[component_count - 1U];
+    }
+
+    return VK_FORMAT_UNDEFINED;
+}
+
+static VkDescriptorType spirv_get_descriptor_type(struct spirv_module *module, const uint32_t storage_class, const uint32_t type_id) {
+    const struct spirv_id *const type = spirv_get_id(module, type_id);
+
+    if (storage_class == SPIRV_STORAGE_CLASS_STORAGE_BUFFER) {
+        return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    }
+
+    if (storage_class == SPIRV_STORAGE_CLASS_UNIFORM) {
+        return type->is_buffer_block ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    }
+
+    switch (type->opcode) {
+        case SPIRV_OP_TYPE_SAMPLER:
+            return VK_DESCRIPTOR_TYPE_SAMPLER;
+        case SPIRV_OP_TYPE_SAMPLED_IMAGE:
+            return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        case SPIRV_OP_TYPE_IMAGE: {
+            const uint32_t dim = spirv_operand(module, type_id, 2);
+            const uint32_t sampled = spirv_operand(module, type_id, 6);
+
+            if (dim == SPIRV_DIM_SUBPASS_DATA) {
+                return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+            }
+
+            if (dim == SPIRV_DIM_BUFFER) {
+                return sampled == 2U ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+            }
+
+            return sampled == 2U ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        }
+        default:
+            spirv_fail(module, "unsupported descriptor type in shader module");
+            return VK_DESCRIPTOR_TYPE_SAMPLER;
+    }
+}
+
+static uint32_t spirv_get_minimum_operand_count(const uint32_t opcode, const uint32_t *const operands, const uint32_t operand_count) {
+    switch (opcode) {
+        case SPIRV_OP_ENTRY_POINT:
+        case SPIRV_OP_TYPE_INT:
+        case SPIRV_OP_TYPE_FLOAT:
+        case SPIRV_OP_TYPE_VECTOR:
+        case SPIRV_OP_TYPE_MATRIX:
+        case SPIRV_OP_TYPE_IMAGE:
+        case SPIRV_OP_TYPE_SAMPLER:
+        case SPIRV_OP_TYPE_SAMPLED_IMAGE:
+        case SPIRV_OP_TYPE_ARRAY:
+        case SPIRV_OP_TYPE_RUNTIME_ARRAY:
+        case SPIRV_OP_TYPE_STRUCT:
+        case SPIRV_OP_TYPE_POINTER:
+            return 1U;
+        case SPIRV_OP_NAME:
+        case SPIRV_OP_SPEC_CONSTANT_TRUE:
+        case SPIRV_OP_SPEC_CONSTANT_FALSE:
+            return 2U;
+        case SPIRV_OP_CONSTANT:
+        case SPIRV_OP_SPEC_CONSTANT:
+        case SPIRV_OP_VARIABLE:
+            return 3U;
+        case SPIRV_OP_DECORATE:
+            if (operand_count < 2U) {
+                return 2U;
+            }
+
+            return operands[1] == SPIRV_DECORATION_BLOCK || operands[1] == SPIRV_DECORATION_BUFFER_BLOCK ? 2U : 3U;
+        case SPIRV_OP_MEMBER_DECORATE:
+            if (operand_count < 3U) {
+                return 3U;
+            }
+
+            return operands[2] == SPIRV_DECORATION_OFFSET || operands[2] == SPIRV_DECORATION_MATRIX_STRIDE ? 4U : 3U;
+        default:
+            return 0U;
+    }
+}
+
+static VkShaderStageFlagBits spirv_get_stage(const uint32_t execution_model) {
+    switch (execution_model) {
+        case 0U: return VK_SHADER_STAGE_VERTEX_BIT;
+        case 1U: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+        case 2U: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+        case 3U: return VK_SHADER_STAGE_GEOMETRY_BIT;
+        case 4U: return VK_SHADER_STAGE_FRAGMENT_BIT;
+        case 5U: return VK_SHADER_STAGE_COMPUTE_BIT;
+        default: return VK_SHADER_STAGE_ALL;
+    }
+}
+
+static void spirv_reflect_variable(
+    struct spirv_module *module,
+    const uint32_t variable_id,
+    const uint32_t storage_class,
+    struct shader_reflection *reflection
+) {
+    const struct spirv_id *const variable = spirv_get_id(module, variable_id);
+    const uint32_t pointer_type_id = spirv_operand(module, variable_id, 0);
+    uint32_t type_id = spirv_operand(module, pointer_type_id, 2);
+
+    if (storage_class == SPIRV_STORAGE_CLASS_INPUT) {
+        if (variable->is_built_in || !variable->has_location || reflection->stage != VK_SHADER_STAGE_VERTEX_BIT) {
+            return;
+        }
+
+        if (reflection->input_count == SHADER_REFLECTION_MAX_INPUTS) {
+            spirv_fail(module, "too many shader inputs");
+            return;
+        }
+
+        reflection->inputs[reflection->input_count++] = (struct shader_reflection_input) {
+            .location = variable->location,
+            .format = spirv_get_input_format(module, type_id),
+            .size = spirv_get_type_size(module, type_id)
+        };
+    } else if (storage_class == SPIRV_STORAGE_CLASS_PUSH_CONSTANT) {
+        reflection->push_constant_size = spirv_get_type_size(module, type_id);
+    } else if (storage_class == SPIRV_STORAGE_CLASS_UNIFORM || storage_class == SPIRV_STORAGE_CLASS_UNIFORM_CONSTANT || storage_class == SPIRV_STORAGE_CLASS_STORAGE_BUFFER) {
+        uint32_t descriptor_count = 1U;
+
+        if (spirv_get_id(module, type_id)->opcode == SPIRV_OP_TYPE_ARRAY) {
+            descriptor_count = spirv_get_id(module, spirv_operand(module, type_id, 2))->constant;
+            type_id = spirv_operand(module, type_id, 1);
+        } else if (spirv_get_id(module, type_id)->opcode == SPIRV_OP_TYPE_RUNTIME_ARRAY) {
+            descriptor_count = 0U;
+            type_id = spirv_operand(module, type_id, 1);
+        }
+
+        if (reflection->binding_count == SHADER_REFLECTION_MAX_BINDINGS) {
+            spirv_fail(module, "too many shader bindings");
+            return;
+        }
+
+        reflection->bindings[reflection->binding_count++] = (struct shader_reflection_binding) {
+            .set = variable->set,
+            .binding = variable->binding,
+            .descriptor_type = spirv_get_descriptor_type(module, storage_class, type_id),
+            .descriptor_count = descriptor_count,
+            .stage_flags = reflection->stage
+        };
+    }
+}
+
+static void spirv_reflect_specialization_constant(
+    struct spirv_module *module,
+    const uint32_t constant_id,
+    struct shader_reflection *reflection
+) {
+    const struct spirv_id *const constant = spirv_get_id(module, constant_id);
+
+    if (reflection->specialization_constant_count == SHADER_REFLECTION_MAX_SPECIALIZATION_CONSTANTS) {
+        spirv_fail(module, "too many specialization constants");
+        return;
+    }
+
+    struct shader_reflection_specialization_constant *specialization_constant =
+        &reflection->specialization_constants[reflection->specialization_constant_count++];
+
+    specialization_constant->constant_id = constant->spec_id;
+    specialization_constant->default_value = constant->constant;
+
+    // The name is a nul terminated literal that may fill its last word
+    // completely, so it is bounded by the instruction as well.
+    const char *const name = (const char *) &module->code[constant->name_word];
+    const size_t name_capacity = constant->name_word_count * sizeof (uint32_t);
+    const char *const name_end = memchr(name, '\0', name_capacity);
+    size_t name_length = name_end ? (size_t) (name_end - name) : name_capacity;
+
+    if (name_length >= sizeof specialization_constant->name) {
+        name_length = sizeof specialization_constant->name - 1U;
+    }
+
+    memcpy(specialization_constant->name, name, name_length);
+    specialization_constant->name[name_length] = '\0';
+}
+
+bool shader_reflection_try_parse(
+    const uint32_t *const code,
+    const size_t code_size,
+    struct shader_reflection *reflection,
+    char *const message,
+    const size_t message_size
+) {
+    memset(reflection, 0, sizeof *reflection);
+
+    if (code_size < 5U * sizeof (uint32_t) || code[0] != SPIRV_MAGIC) {
+        snprintf(message, message_size, "shader module is not SPIR-V");
+        return false;
+    }
+
+    struct spirv_module module = {
+        .code = code,
+        .word_count = code_size / sizeof (uint32_t),
+        .id_bound = code[3],
+        .ids = calloc(code[3], sizeof (struct spirv_id)),
+        .member_decorations = NULL,
+        .member_decoration_count = 0U,
+        .member_decoration_capacity = 0U,
+        .error = NULL,
+        .invalid_id = {0}
+    };
+
+    reflection->stage = VK_SHADER_STAGE_ALL;
+
+    // The first pass records declarations and decorations, variables are
+    // resolved afterwards because decorations may follow their targets.
+    for (uint32_t word = 5U; word < module.word_count && module.error == NULL;) {
+        const uint32_t opcode = code[word] & 0xFFFFU;
+        const uint32_t instruction_word_count = code[word] >> 16U;
+
+        if (instruction_word_count == 0U || word + instruction_word_count > module.word_count) {
+            spirv_fail(&module, "malformed SPIR-V in shader module");
+            break;
+        }
+
+        const uint32_t *const operands = &code[word + 1U];
+        const uint32_t operand_count = instruction_word_count - 1U;
+
+        // Operands read while parsing are checked here, type operands are
+        // checked when they are read through spirv_operand.
+        if (operand_count < spirv_get_minimum_operand_count(opcode, operands, operand_count)) {
+            spirv_fail(&module, "malformed SPIR-V in shader module");
+            break;
+        }
+
+        switch (opcode) {
+            case SPIRV_OP_ENTRY_POINT:
+                if (reflection->stage == VK_SHADER_STAGE_ALL) {
+                    reflection->stage = spirv_get_stage(operands[0]);
+                }
+                break;
+            case SPIRV_OP_TYPE_INT:
+            case SPIRV_OP_TYPE_FLOAT:
+            case SPIRV_OP_TYPE_VECTOR:
+            case SPIRV_OP_TYPE_MATRIX:
+            case SPIRV_OP_TYPE_IMAGE:
+            case SPIRV_OP_TYPE_SAMPLER:
+            case SPIRV_OP_TYPE_SAMPLED_IMAGE:
+            case SPIRV_OP_TYPE_ARRAY:
+            case SPIRV_OP_TYPE_RUNTIME_ARRAY:
+            case SPIRV_OP_TYPE_STRUCT:
+            case SPIRV_OP_TYPE_POINTER:
+                spirv_get_id(&module, operands[0])->opcode = opcode;
+                spirv_get_id(&module, operands[0])->first_operand = word + 1U;
+                spirv_get_id(&module, operands[0])->operand_count = operand_count;
+                break;
+            case SPIRV_OP_NAME:
+                spirv_get_id(&module, operands[0])->name_word = word + 2U;
+                spirv_get_id(&module, operands[0])->name_word_count = operand_count - 1U;
+                break;
+            case SPIRV_OP_CONSTANT:
+            case SPIRV_OP_SPEC_CONSTANT:
+                spirv_get_id(&module, operands[1])->opcode = opcode;
+                spirv_get_id(&module, operands[1])->constant = operands[2];
+                break;
+            case SPIRV_OP_SPEC_CONSTANT_TRUE:
+            case SPIRV_OP_SPEC_CONSTANT_FALSE:
+                spirv_get_id(&module, operands[1])->opcode = opcode;
+                spirv_get_id(&module, operands[1])->constant = opcode == SPIRV_OP_SPEC_CONSTANT_TRUE;
+                break;
+            case SPIRV_OP_VARIABLE:
+                spirv_get_id(&module, operands[1])->opcode = opcode;
+                spirv_get_id(&module, operands[1])->first_operand = word + 1U;
+                spirv_get_id(&module, operands[1])->operand_count = operand_count;
+                break;
+            case SPIRV_OP_DECORATE: {
+                struct spirv_id *const target = spirv_get_id(&module, operands[0]);
+
+                switch (operands[1]) {
+                    case SPIRV_DECORATION_SPEC_ID: target->spec_id = operands[2]; target->has_spec_id = 1U; break;
+                    case SPIRV_DECORATION_BLOCK: target->is_block = 1U; break;
+                    case SPIRV_DECORATION_BUFFER_BLOCK: target->is_buffer_block = 1U; break;
+                    case SPIRV_DECORATION_ARRAY_STRIDE: target->array_stride = operands[2]; break;
+                    case SPIRV_DECORATION_BUILT_IN: target->is_built_in = 1U; break;
+                    case SPIRV_DECORATION_LOCATION: target->location = operands[2]; target->has_location = 1U; break;
+                    case SPIRV_DECORATION_BINDING: target->binding = operands[2]; break;
+                    case SPIRV_DECORATION_DESCRIPTOR_SET: target->set = operands[2]; break;
+                }
+                break;
+            }
+            case SPIRV_OP_MEMBER_DECORATE:
+                if (operands[2] == SPIRV_DECORATION_OFFSET) {
+                    spirv_get_member_decoration(&module, operands[0], operands[1])->offset = operands[3];
+                } else if (operands[2] == SPIRV_DECORATION_MATRIX_STRIDE) {
+                    spirv_get_member_decoration(&module, operands[0], operands[1])->matrix_stride = operands[3];
+                } else if (operands[2] == SPIRV_DECORATION_BUILT_IN) {
+                    spirv_get_id(&module, operands[0])->is_built_in = 1U;
+                }
+                break;
+        }
+
+        word += instruction_word_count;
+    }
+
+    for (uint32_t id = 1U; id < module.id_bound && module.error == NULL; ++id) {
+        if (module.ids[id].opcode == SPIRV_OP_VARIABLE) {
+            spirv_reflect_variable(&module, id, spirv_operand(&module, id, 2), reflection);
+        } else if (module.ids[id].has_spec_id && (
+            module.ids[id].opcode == SPIRV_OP_SPEC_CONSTANT ||
+            module.ids[id].opcode == SPIRV_OP_SPEC_CONSTANT_TRUE ||
+            module.ids[id].opcode == SPIRV_OP_SPEC_CONSTANT_FALSE
+        )) {
+            spirv_reflect_specialization_constant(&module, id, reflection);
+        }
+    }
+
+    free(module.member_decorations);
+    free(module.ids);
+
+    if (module.error != NULL) {
+        snprintf(message, message_size, "%s", module.error);
+        return false;
+    }
+
+    return true;
+}
+
+void shader_reflection_parse(const uint32_t *const code, const size_t code_size, struct shader_reflection *reflection) {
+    char message[128];
+
+    if (!shader_reflection_try_parse(code, code_size, reflection, message, sizeof message)) {
+        fprintf(stderr, "error: %s\n", message);
+        exit(1);
+    }
+}
+
+bool shader_reflection_try_merge_layout(
+    const struct shader_reflection *const *const reflections,
+    const uint32_t reflection_count,
+    struct shader_reflection_layout *layout,
+    char *const message,
+    const size_t message_size
+) {
+    memset(layout, 0, sizeof *layout);
+
+    for (uint32_t reflection_index = 0U; reflection_index < reflection_count; ++reflection_index) {
+        const struct shader_reflection *const reflection = reflections[reflection_index];
+
+        for (uint32_t binding_index = 0U; binding_index < reflection->binding_count; ++binding_index) {
+            const struct shader_reflection_binding *const binding = &reflection->bindings[binding_index];
+            struct shader_reflection_binding *merged_binding = (struct shader_reflection_binding *) shader_reflection_layout_find_binding(layout, binding->set, binding->binding);
+
+            if (merged_binding != NULL) {
+                if (merged_binding->descriptor_type != binding->descriptor_type) {
+                    snprintf(message, message_size, "shader stages disagree on the type of set %u binding %u", binding->set, binding->binding);
+                    return false;
+                }
+
+                merged_binding->stage_flags |= binding->stage_flags;
+                continue;
+            }
+
+            if (binding->set >= SHADER_REFLECTION_MAX_SETS) {
+                snprintf(message, message_size, "descriptor set %u exceeds the supported set count", binding->set);
+                return false;
+            }
+
+            layout->bindings[layout->binding_count++] = *binding;
+
+            if (binding->set + 1U > layout->set_count) {
+                layout->set_count = binding->set + 1U;
+            }
+        }
+
+        // All stages share one range starting at zero, as in vert.glsl.
+        if (reflection->push_constant_size > 0U) {
+            layout->push_constant_range.stageFlags |= reflection->stage;
+
+            if (reflection->push_constant_size > layout->push_constant_range.size) {
+                layout->push_constant_range.size = reflection->push_constant_size;
+            }
+
+            layout->push_constant_range_count = 1U;
+        }
+    }
+
+    return true;
+}
+
+void shader_reflection_merge_layout(
+    const struct shader_reflection *const *const reflections,
+    const uint32_t reflection_count,
+    struct shader_reflection_layout *layout
+) {
+    char message[128];
+
+    if (!shader_reflection_try_merge_layout(reflections, reflection_count, layout, message, sizeof message)) {
+        fprintf(stderr, "error: %s\n", message);
+        exit(1);
+    }
+}
+
+const struct shader_reflection_binding *shader_reflection_layout_find_binding(
+    const struct shader_reflection_layout *const layout,
+    const uint32_t set,
+    const uint32_t binding
+) {
+    for (uint32_t binding_index = 0U; binding_index < layout->binding_count; ++binding_index) {
+        if (layout->bindings[binding_index].set == set && layout->bindings[binding_index].binding == binding) {
+            return &layout->bindings[binding_index];
+        }
+    }
+
+    return NULL;
+}
+
+bool shader_reflection_layouts_equal(
+    const struct shader_reflection_layout *const layout_a,
+    const struct shader_reflection_layout *const layout_b
+) {
+    if (layout_a->binding_count != layout_b->binding_count ||
+        layout_a->push_constant_range_count != layout_b->push_constant_range_count ||
+        (layout_a->push_constant_range_count && (
+            layout_a->push_constant_range.stageFlags != layout_b->push_constant_range.stageFlags ||
+            layout_a->push_constant_range.size != layout_b->push_constant_range.size))) {
+        return false;
+    }
+
+    for (uint32_t binding_index = 0U; binding_index < layout_b->binding_count; ++binding_index) {
+        const struct shader_reflection_binding *const binding_b = &layout_b->bindings[binding_index];
+        const struct shader_reflection_binding *const binding_a = shader_reflection_layout_find_binding(layout_a, binding_b->set, binding_b->binding);
+
+        if (binding_a == NULL ||
+            binding_a->descriptor_type != binding_b->descriptor_type ||
+            binding_a->descriptor_count != binding_b->descriptor_count ||
+            binding_a->stage_flags != binding_b->stage_flags) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+VkDescriptorSetLayout shader_reflection_layout_create_descriptor_set_layout(
+    const VkDevice device,
+    const struct shader_reflection_layout *const layout,
+    const uint32_t set,
+    const VkBool32 dynamic_uniform_buffers
+) {
+    VkDescriptorSetLayoutBinding descriptor_set_layout_bindings[SHADER_REFLECTION_MAX_BINDINGS];
+    uint32_t descriptor_set_layout_binding_count = 0U;
+
+    for (uint32_t binding_index = 0U; binding_index < layout->binding_count; ++binding_index) {
+        const struct shader_reflection_binding *const binding = &layout->bindings[binding_index];
+
+        if (binding->set != set) {
+            continue;
+        }
+
+        VkDescriptorType descriptor_type = binding->descriptor_type;
+
+        if (dynamic_uniform_buffers && descriptor_type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER) {
+            descriptor_type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        }
+
+        descriptor_set_layout_bindings[descriptor_set_layout_binding_count++] = (VkDescriptorSetLayoutBinding) {
+            .binding = binding->binding,
+            .descriptorType = descriptor_type,
+            .descriptorCount = binding->descriptor_count,
+            .stageFlags = binding->stage_flags,
+            .pImmutableSamplers = NULL
+        };
+    }
+
+    const VkDescriptorSetLayoutCreateInfo descriptor_set_layout_create_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = NULL,
+        .flags = 0,
+        .bindingCount = descriptor_set_layout_binding_count,
+        .pBindings = descriptor_set_layout_bindings
+    };
+
+    VkDescriptorSetLayout descriptor_set_layout = VK_NULL_HANDLE;
+    VkResult result = vkCreateDescriptorSetLayout(device, &descriptor_set_layout_create_info, NULL, &descriptor_set_layout);
+
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "error: failed to create descriptor set layout\n");
+        exit(1);
+    }
+
+    return descriptor_set_layout;
+}
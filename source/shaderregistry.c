@@ -0,0 +1,44 @@
+#include <shaderregistry.h>
+
+#include <string.h>
+
+// The .inc files are written by glslc -mfmt=num, a comma separated list of
+// SPIR-V words, so the arrays are naturally aligned for pCode.
+
+static const uint32_t shader_registry_vert_code[] = {
+#include <vert.inc>
+};
+
+static const uint32_t shader_registry_frag_code[] = {
+#include <frag.inc>
+};
+
+static const uint32_t shader_registry_cull_code[] = {
+#include <cull.inc>
+};
+
+static const uint32_t shader_registry_fullscreen_code[] = {
+#include <fullscreen.inc>
+};
+
+static const uint32_t shader_registry_lighting_code[] = {
+#include <lighting.inc>
+};
+
+static const struct shader_registry_entry shader_registry_entries[] = {
+    {"vert", shader_registry_vert_code, sizeof shader_registry_vert_code},
+    {"frag", shader_registry_frag_code, sizeof shader_registry_frag_code},
+    {"cull", shader_registry_cull_code, sizeof shader_registry_cull_code},
+    {"fullscreen", shader_registry_fullscreen_code, sizeof shader_registry_fullscreen_code},
+    {"lighting", shader_registry_lighting_code, sizeof shader_registry_lighting_code}
+};
+
+const struct shader_registry_entry *shader_registry_find(const char *const name) {
+    for (size_t entry_index = 0; entry_index < (sizeof shader_registry_entries) / (sizeof *shader_registry_entries); ++entry_index) {
+        if (strcmp(shader_registry_entries[entry_index].name, name) == 0) {
+            return &shader_registry_entries[entry_index];
+        }
+    }
+
+    return NULL;
+}
@@ -0,0 +1,65 @@
+#version 460
+
+layout (local_size_x = 64) in;
+
+struct culling_object {
+    vec4 bounding_sphere;
+    uint index_count;
+    uint first_index;
+    int vertex_offset;
+    uint padding;
+};
+
+// Same layout as VkDrawIndexedIndirectCommand.
+struct draw_command {
+    uint index_count;
+    uint instance_count;
+    uint first_index;
+    int vertex_offset;
+    uint first_instance;
+};
+
+layout (std430, set = 0, binding = 0) readonly buffer objects_buffer {
+    culling_object objects[];
+};
+
+layout (std430, set = 0, binding = 1) writeonly buffer draw_commands_buffer {
+    draw_command draw_commands[];
+};
+
+layout (std430, set = 0, binding = 2) buffer draw_count_buffer {
+    uint draw_count;
+};
+
+layout (push_constant) uniform culling_push_constants {
+    vec4 frustum_planes[6];
+    uint object_count;
+} culling;
+
+void main() {
+    const uint object_index = gl_GlobalInvocationID.x;
+
+    if (object_index >= culling.object_count) {
+        return;
+    }
+
+    const vec4 bounding_sphere = objects[object_index].bounding_sphere;
+
+    for (int plane_index = 0; plane_index < 6; ++plane_index) {
+        const vec4 plane = culling.frustum_planes[plane_index];
+
+        if (dot(plane.xyz, bounding_sphere.xyz) + plane.w < -bounding_sphere.w) {
+            return;
+        }
+    }
+
+    // The object index becomes the instance index so vertex shaders can look
+    // up per-object data.
+    const uint draw_index = atomicAdd(draw_count, 1);
+    draw_commands[draw_index] = draw_command(
+        objects[object_index].index_count,
+        1,
+        objects[object_index].first_index,
+        objects[object_index].vertex_offset,
+        object_index);
+}
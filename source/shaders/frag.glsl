@@ -1,11 +1,21 @@
 #version 460
 #extension GL_ARB_separate_shader_objects : enable
 
+// Specialization constants, folded by the driver when the pipeline is built.
+layout (constant_id = 0) const bool grayscale = false;
+layout (constant_id = 1) const float brightness = 1.0;
+
 layout (location = 0) in vec3 pass_color;
 
 layout (location = 0) out vec4 out_color;
 
 void main()
 {
-    out_color = vec4(pass_color, 1.0);
+    vec3 color = pass_color * brightness;
+
+    if (grayscale) {
+        color = vec3(dot(color, vec3(0.2126, 0.7152, 0.0722)));
+    }
+
+    out_color = vec4(color, 1.0);
 }
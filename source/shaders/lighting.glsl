@@ -0,0 +1,24 @@
+#version 460
+#extension GL_ARB_separate_shader_objects : enable
+
+// How much fog reaches the far plane.
+layout (constant_id = 0) const float fog_density = 0.5;
+
+// The G-buffer, read at the pixel being shaded.
+layout (input_attachment_index = 0, set = 0, binding = 0) uniform subpassInput gbuffer_albedo;
+layout (input_attachment_index = 1, set = 0, binding = 1) uniform subpassInput gbuffer_depth;
+
+layout (location = 0) out vec4 out_color;
+
+const vec3 fog_color = vec3(0.1, 0.1, 0.15);
+
+void main()
+{
+    const vec4 albedo = subpassLoad(gbuffer_albedo);
+    const float depth = subpassLoad(gbuffer_depth).r;
+
+    // Pixels nothing was drawn to keep the clear color.
+    const float fog = depth < 1.0 ? depth * fog_density : 0.0;
+
+    out_color = vec4(mix(albedo.rgb, fog_color, fog), 1.0);
+}
@@ -10,7 +10,15 @@ layout (location = 1) in vec3 color;
 
 layout (location = 0) out vec3 pass_color;
 
+layout (push_constant) uniform object_push_constants {
+    mat4 transform;
+} object;
+
+layout (set = 0, binding = 0) uniform object_uniforms {
+    vec4 tint;
+} uniforms;
+
 void main() {
-    pass_color = color;
-    gl_Position = vec4(position, 0.0, 1.0);
+    pass_color = color * uniforms.tint.rgb;
+    gl_Position = object.transform * vec4(position, 0.0, 1.0);
 }
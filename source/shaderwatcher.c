@@ -0,0 +1,297 @@
+#include <shaderwatcher.h>
+
+#include <errno.h>
+#include <poll.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+// Shader stages of the sources, matching the embed_shader calls in CMakeLists.txt.
+static const struct {
+    const char *name;
+    const char *stage;
+} shader_watcher_stages[] = {
+    {"vert", "vert"},
+    {"frag", "frag"},
+    {"cull", "comp"},
+    {"fullscreen", "vert"},
+    {"lighting", "frag"}
+};
+
+static const char *shader_watcher_find_stage(const char *const name) {
+    for (size_t stage_index = 0; stage_index < (sizeof shader_watcher_stages) / (sizeof *shader_watcher_stages); ++stage_index) {
+        if (strcmp(shader_watcher_stages[stage_index].name, name) == 0) {
+            return shader_watcher_stages[stage_index].stage;
+        }
+    }
+
+    return NULL;
+}
+
+// Runs glslc with its output on a pipe, compile errors go straight to stderr.
+static uint32_t *shader_watcher_compile(const char *const source_path, const char *const stage, size_t *code_size) {
+    char stage_argument[32];
+    snprintf(stage_argument, sizeof stage_argument, "-fshader-stage=%s", stage);
+
+    char *const arguments[] = {"glslc", stage_argument, (char *) source_path, "-o", "-", NULL};
+
+    int output_pipe[2];
+
+    if (pipe(output_pipe) != 0) {
+        return NULL;
+    }
+
+    posix_spawn_file_actions_t file_actions;
+    posix_spawn_file_actions_init(&file_actions);
+    posix_spawn_file_actions_adddup2(&file_actions, output_pipe[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addclose(&file_actions, output_pipe[0]);
+
+    pid_t process;
+    const int spawn_result = posix_spawnp(&process, "glslc", &file_actions, NULL, arguments, environ);
+
+    posix_spawn_file_actions_destroy(&file_actions);
+    close(output_pipe[1]);
+
+    if (spawn_result != 0) {
+        fprintf(stderr, "warning: failed to run glslc: %s\n", strerror(spawn_result));
+        close(output_pipe[0]);
+        return NULL;
+    }
+
+    size_t capacity = 16U * 1024U;
+    size_t size = 0U;
+    uint8_t *code = malloc(capacity);
+
+    for (;;) {
+        if (size == capacity) {
+            capacity *= 2U;
+            code = realloc(code, capacity);
+        }
+
+        const ssize_t read_size = read(output_pipe[0], code + size, capacity - size);
+
+        if (read_size > 0) {
+            size += (size_t) read_size;
+        } else if (read_size == 0 || errno != EINTR) {
+            break;
+        }
+    }
+
+    close(output_pipe[0]);
+
+    int status = 0;
+    while (waitpid(process, &status, 0) < 0 && errno == EINTR);
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || size == 0U || size % sizeof (uint32_t) != 0U) {
+        free(code);
+        return NULL;
+    }
+
+    *code_size = size;
+
+    return (uint32_t *) code;
+}
+
+static void shader_watcher_reload(struct shader_watcher *shader_watcher, const char *const name) {
+    const char *const stage = shader_watcher_find_stage(name);
+
+    if (stage == NULL) {
+        return;
+    }
+
+    const size_t source_path_size = strlen(shader_watcher->source_directory) + strlen(name) + 7U;
+    char *source_path = malloc(source_path_size);
+    snprintf(source_path, source_path_size, "%s/%s.glsl", shader_watcher->source_directory, name);
+
+    size_t code_size = 0U;
+    uint32_t *code = shader_watcher_compile(source_path, stage, &code_size);
+
+    free(source_path);
+
+    if (code == NULL) {
+        fprintf(stderr, "warning: failed to compile %s.glsl, keeping the previous shader\n", name);
+        return;
+    }
+
+    char message[128];
+    struct shader_module *shader_module = shader_module_cache_try_acquire_code(shader_watcher->shader_module_cache, code, code_size, message, sizeof message);
+
+    free(code);
+
+    if (shader_module == NULL) {
+        fprintf(stderr, "warning: %s.glsl: %s, keeping the previous shader\n", name, message);
+        return;
+    }
+
+    struct shader_watcher_update *update = malloc(sizeof *update);
+    snprintf(update->name, sizeof update->name, "%s", name);
+    update->shader_module = shader_module;
+    update->next = NULL;
+
+    pthread_mutex_lock(&shader_watcher->mutex);
+
+    if (shader_watcher->update_tail == NULL) {
+        shader_watcher->update_head = update;
+    } else {
+        shader_watcher->update_tail->next = update;
+    }
+
+    shader_watcher->update_tail = update;
+
+    pthread_mutex_unlock(&shader_watcher->mutex);
+}
+
+static void *shader_watcher_run(void *argument) {
+    struct shader_watcher *shader_watcher = argument;
+
+    // Aligned for struct inotify_event, large enough for a burst of events.
+    _Alignas(struct inotify_event) char events[4096];
+
+    for (;;) {
+        struct pollfd poll_descriptors[] = {
+            {.fd = shader_watcher->inotify_descriptor, .events = POLLIN, .revents = 0},
+            {.fd = shader_watcher->stop_pipe[0], .events = POLLIN, .revents = 0}
+        };
+
+        if (poll(poll_descriptors, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return NULL;
+        }
+
+        if (poll_descriptors[1].revents != 0) {
+            return NULL;
+        }
+
+        const ssize_t events_size = read(shader_watcher->inotify_descriptor, events, sizeof events);
+
+        if (events_size <= 0) {
+            continue;
+        }
+
+        // Editors often write a file several times when saving, each shader
+        // of a burst is compiled once.
+        char names[8][32];
+        uint32_t name_count = 0U;
+
+        for (ssize_t offset = 0; offset < events_size;) {
+            const struct inotify_event *const event = (const struct inotify_event *) &events[offset];
+            offset += (ssize_t) (sizeof *event + event->len);
+
+            const size_t name_length = event->len ? strlen(event->name) : 0U;
+
+            if (name_length <= 5U || name_length - 5U >= sizeof names[0] || strcmp(&event->name[name_length - 5U], ".glsl") != 0) {
+                continue;
+            }
+
+            char name[32];
+            memcpy(name, event->name, name_length - 5U);
+            name[name_length - 5U] = '\0';
+
+            bool known = false;
+
+            for (uint32_t name_index = 0U; name_index < name_count; ++name_index) {
+                known = known || strcmp(names[name_index], name) == 0;
+            }
+
+            if (!known && name_count < 8U) {
+                memcpy(names[name_count++], name, sizeof name);
+            }
+        }
+
+        for (uint32_t name_index = 0U; name_index < name_count; ++name_index) {
+            shader_watcher_reload(shader_watcher, names[name_index]);
+        }
+    }
+}
+
+struct shader_watcher *shader_watcher_create(struct shader_module_cache *shader_module_cache, const char *const source_directory) {
+    struct shader_watcher *shader_watcher = malloc(sizeof *shader_watcher);
+
+    shader_watcher->shader_module_cache = shader_module_cache;
+    shader_watcher->source_directory = strdup(source_directory);
+    shader_watcher->update_head = NULL;
+    shader_watcher->update_tail = NULL;
+
+    shader_watcher->inotify_descriptor = inotify_init1(IN_CLOEXEC);
+
+    if (shader_watcher->inotify_descriptor < 0) {
+        fprintf(stderr, "error: failed to initialize inotify\n");
+        exit(1);
+    }
+
+    // Saving through a temporary file and a rename shows up as IN_MOVED_TO.
+    if (inotify_add_watch(shader_watcher->inotify_descriptor, source_directory, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        fprintf(stderr, "error: failed to watch shader directory %s\n", source_directory);
+        exit(1);
+    }
+
+    if (pipe(shader_watcher->stop_pipe) != 0) {
+        fprintf(stderr, "error: failed to create shader watcher pipe\n");
+        exit(1);
+    }
+
+    pthread_mutex_init(&shader_watcher->mutex, NULL);
+
+    if (pthread_create(&shader_watcher->thread, NULL, shader_watcher_run, shader_watcher) != 0) {
+        fprintf(stderr, "error: failed to create shader watcher thread\n");
+        exit(1);
+    }
+
+    return shader_watcher;
+}
+
+void shader_watcher_destroy(struct shader_watcher *shader_watcher) {
+    // A compile in progress is finished before the thread sees the stop request.
+    const char stop = 0;
+    while (write(shader_watcher->stop_pipe[1], &stop, 1) < 0 && errno == EINTR);
+
+    pthread_join(shader_watcher->thread, NULL);
+
+    struct shader_watcher_update update;
+
+    while (shader_watcher_poll(shader_watcher, &update)) {
+        shader_module_cache_release(shader_watcher->shader_module_cache, update.shader_module);
+    }
+
+    pthread_mutex_destroy(&shader_watcher->mutex);
+    close(shader_watcher->stop_pipe[0]);
+    close(shader_watcher->stop_pipe[1]);
+    close(shader_watcher->inotify_descriptor);
+    free(shader_watcher->source_directory);
+    free(shader_watcher);
+}
+
+bool shader_watcher_poll(struct shader_watcher *shader_watcher, struct shader_watcher_update *update) {
+    pthread_mutex_lock(&shader_watcher->mutex);
+
+    struct shader_watcher_update *head = shader_watcher->update_head;
+
+    if (head != NULL) {
+        shader_watcher->update_head = head->next;
+
+        if (shader_watcher->update_head == NULL) {
+            shader_watcher->update_tail = NULL;
+        }
+    }
+
+    pthread_mutex_unlock(&shader_watcher->mutex);
+
+    if (head == NULL) {
+        return false;
+    }
+
+    *update = *head;
+    update->next = NULL;
+    free(head);
+
+    return true;
+}
@@ -51,7 +51,7 @@ VkSwapchainKHR swapchain_create(
         .imageColorSpace = surface_format.colorSpace,
         .imageExtent = surface_capabilities.currentExtent,
         .imageArrayLayers = 1,
-        .imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+        .imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | (surface_capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT),
         .imageSharingMode = VK_SHARING_MODE_EXCLUSIVE,
         .queueFamilyIndexCount = 0,
         .pQueueFamilyIndices = NULL,
@@ -88,6 +88,19 @@ uint32_t swapchain_get_image_count(const VkSwapchainKHR swapchain, const VkDevic
     return swapchain_image_count;
 }
 
+VkImage *swapchain_get_images(const VkSwapchainKHR swapchain, const VkDevice device, uint32_t swapchain_image_count) {
+    VkImage *swapchain_images = malloc(swapchain_image_count * (sizeof *swapchain_images));
+
+    VkResult result = vkGetSwapchainImagesKHR(device, swapchain, &swapchain_image_count, swapchain_images);
+
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "error: failed to get swapchain images\n");
+        exit(1);
+    }
+
+    return swapchain_images;
+}
+
 VkImageView *swapchain_create_image_views(const VkSwapchainKHR swapchain, const VkDevice device, const VkSurfaceFormatKHR surface_format, uint32_t swapchain_image_count) {
     VkImage *swapchain_images = malloc(swapchain_image_count * (sizeof *swapchain_images));
 
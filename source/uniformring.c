@@ -0,0 +1,180 @@
+#include <uniformring.h>
+
+#include <buffer.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static VkDeviceSize uniform_ring_align(const VkDeviceSize size, const VkDeviceSize alignment) {
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+static void uniform_ring_create_buffer(
+    const VkDevice device,
+    const VkPhysicalDeviceMemoryProperties physical_device_memory_properties,
+    struct uniform_ring *uniform_ring
+) {
+    const uint32_t buffer_size = (uint32_t) (uniform_ring->frame_size * uniform_ring->frame_count);
+
+    uniform_ring->buffer = buffer_create(device, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, buffer_size);
+    uniform_ring->buffer_device_memory = buffer_allocate_device_memory(uniform_ring->buffer, device, physical_device_memory_properties, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    // The ring stays mapped for its whole lifetime, per-draw updates are plain memcpys.
+    void *mapped_data = NULL;
+    const VkResult result = vkMapMemory(device, uniform_ring->buffer_device_memory, 0, buffer_size, 0, &mapped_data);
+
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "error: failed to map uniform ring memory\n");
+        exit(1);
+    }
+
+    uniform_ring->mapped_data = mapped_data;
+
+    // The descriptor covers one block, the dynamic offset selects which one.
+    const VkDescriptorBufferInfo descriptor_buffer_info = {
+        .buffer = uniform_ring->buffer,
+        .offset = 0,
+        .range = uniform_ring->block_size
+    };
+
+    const VkWriteDescriptorSet write_descriptor_set = {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .pNext = NULL,
+        .dstSet = uniform_ring->descriptor_set,
+        .dstBinding = 0,
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+        .pImageInfo = NULL,
+        .pBufferInfo = &descriptor_buffer_info,
+        .pTexelBufferView = NULL
+    };
+
+    vkUpdateDescriptorSets(device, 1, &write_descriptor_set, 0, NULL);
+}
+
+struct uniform_ring *uniform_ring_create(
+    const VkDevice device,
+    const VkDescriptorSetLayout descriptor_set_layout,
+    const VkPhysicalDeviceProperties physical_device_properties,
+    const VkPhysicalDeviceMemoryProperties physical_device_memory_properties,
+    const uint32_t frame_count,
+    const uint32_t frame_size,
+    const uint32_t block_size
+) {
+    struct uniform_ring *uniform_ring = malloc(sizeof *uniform_ring);
+
+    uniform_ring->alignment = physical_device_properties.limits.minUniformBufferOffsetAlignment;
+
+    if (uniform_ring->alignment == 0) {
+        uniform_ring->alignment = 1;
+    }
+
+    uniform_ring->block_size = uniform_ring_align(block_size, uniform_ring->alignment);
+    uniform_ring->frame_size = uniform_ring_align(frame_size, uniform_ring->alignment);
+    uniform_ring->frame_count = frame_count;
+    uniform_ring->frame_offset = 0;
+    uniform_ring->head = 0;
+
+    if (uniform_ring->block_size > physical_device_properties.limits.maxUniformBufferRange) {
+        fprintf(stderr, "error: uniform ring block size exceeds the maximum uniform buffer range\n");
+        exit(1);
+    }
+
+    uniform_ring->descriptor_set_layout = descriptor_set_layout;
+
+    const VkDescriptorPoolSize descriptor_pool_size = {
+        .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+        .descriptorCount = 1
+    };
+
+    const VkDescriptorPoolCreateInfo descriptor_pool_create_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .pNext = NULL,
+        .flags = 0,
+        .maxSets = 1,
+        .poolSizeCount = 1,
+        .pPoolSizes = &descriptor_pool_size
+    };
+
+    VkResult result = vkCreateDescriptorPool(device, &descriptor_pool_create_info, NULL, &uniform_ring->descriptor_pool);
+
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "error: failed to create uniform ring descriptor pool\n");
+        exit(1);
+    }
+
+    const VkDescriptorSetAllocateInfo descriptor_set_allocate_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .pNext = NULL,
+        .descriptorPool = uniform_ring->descriptor_pool,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &uniform_ring->descriptor_set_layout
+    };
+
+    result = vkAllocateDescriptorSets(device, &descriptor_set_allocate_info, &uniform_ring->descriptor_set);
+
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "error: failed to allocate uniform ring descriptor set\n");
+        exit(1);
+    }
+
+    uniform_ring_create_buffer(device, physical_device_memory_properties, uniform_ring);
+
+    return uniform_ring;
+}
+
+static void uniform_ring_destroy_buffer(const VkDevice device, struct uniform_ring *uniform_ring) {
+    vkUnmapMemory(device, uniform_ring->buffer_device_memory);
+    buffer_destroy(device, uniform_ring->buffer);
+    buffer_free_memory(device, uniform_ring->buffer_device_memory);
+}
+
+void uniform_ring_destroy(const VkDevice device, struct uniform_ring *uniform_ring) {
+    vkDestroyDescriptorPool(device, uniform_ring->descriptor_pool, NULL);
+    uniform_ring_destroy_buffer(device, uniform_ring);
+    free(uniform_ring);
+}
+
+// Reallocates the ring for a new number of frames in flight. The descriptor
+// set layout is kept, so pipeline layouts built on it stay valid.
+void uniform_ring_resize(
+    const VkDevice device,
+    const VkPhysicalDeviceMemoryProperties physical_device_memory_properties,
+    struct uniform_ring *uniform_ring,
+    const uint32_t frame_count
+) {
+    if (frame_count == uniform_ring->frame_count) {
+        return;
+    }
+
+    uniform_ring_destroy_buffer(device, uniform_ring);
+    uniform_ring->frame_count = frame_count;
+    uniform_ring->frame_offset = 0;
+    uniform_ring->head = 0;
+    uniform_ring_create_buffer(device, physical_device_memory_properties, uniform_ring);
+}
+
+void uniform_ring_begin_frame(struct uniform_ring *uniform_ring, const uint32_t frame_index) {
+    uniform_ring->frame_offset = (frame_index % uniform_ring->frame_count) * uniform_ring->frame_size;
+    uniform_ring->head = 0;
+}
+
+uint32_t uniform_ring_push(struct uniform_ring *uniform_ring, const void *const data, const uint32_t size) {
+    if (size > uniform_ring->block_size) {
+        fprintf(stderr, "error: uniform block is larger than the uniform ring block size\n");
+        exit(1);
+    }
+
+    if (uniform_ring->head + uniform_ring->block_size > uniform_ring->frame_size) {
+        fprintf(stderr, "error: uniform ring frame is full\n");
+        exit(1);
+    }
+
+    const VkDeviceSize offset = uniform_ring->frame_offset + uniform_ring->head;
+    memcpy(uniform_ring->mapped_data + offset, data, size);
+    uniform_ring->head += uniform_ring_align(size, uniform_ring->alignment);
+
+    return (uint32_t) offset;
+}
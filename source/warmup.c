@@ -0,0 +1,142 @@
+#include <context.h>
+#include <culling.h>
+#include <deferredlighting.h>
+#include <pipeline.h>
+#include <pipelinecache.h>
+#include <pipelinecompiler.h>
+#include <renderpass.h>
+#include <shadermodule.h>
+
+#include <stdio.h>
+#include <time.h>
+
+// Compiles every pipeline the application can request into a
+// pipeline cache ahead of time, so that the first start is as fast as a warm
+// one. A cache only applies to the device and driver it was built with, see
+// pipeline_cache_create, so deployments keep one per device.
+//
+// That covers each color format with every supported sample count, and the
+// G-buffer and lighting pipelines of deferred shading, and the compute
+// pipeline of GPU-driven culling.
+
+// The formats surface_choose_format prefers. Pipelines depend on the render
+// pass, or with dynamic rendering on nothing else, only through their
+// attachment formats.
+static const VkFormat color_formats[] = {VK_FORMAT_B8G8R8A8_UNORM, VK_FORMAT_R8G8B8A8_UNORM};
+
+static double time_get_seconds(void) {
+    struct timespec timespec;
+    clock_gettime(CLOCK_MONOTONIC, &timespec);
+    return timespec.tv_sec + timespec.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+    const char *const pipeline_cache_path = argc > 1 ? argv[1] : "pipeline.cache";
+
+    const double start_time = time_get_seconds();
+
+    struct context *context = context_create_headless(64U, 64U, color_formats[0]);
+
+    printf("info: warming up pipelines for %s, vendor 0x%04x, device 0x%04x, driver 0x%08x\n",
+        context->physical_device_properties.deviceName,
+        context->physical_device_properties.vendorID,
+        context->physical_device_properties.deviceID,
+        context->physical_device_properties.driverVersion);
+
+    const uint32_t color_format_count = (sizeof color_formats) / (sizeof *color_formats);
+
+    // Every sample count LEARN_VULKAN_MSAA_SAMPLES can select, see
+    // physical_device_choose_sample_count.
+    const VkSampleCountFlags sample_counts =
+        context->physical_device_properties.limits.framebufferColorSampleCounts &
+        context->physical_device_properties.limits.framebufferDepthSampleCounts;
+
+    // Render passes are used unless the device has dynamic rendering, which
+    // deferred shading does not change for the forward pipelines.
+    const bool use_render_pass = !context->enabled_dynamic_rendering_features.dynamicRendering;
+
+    // Every request is queued before waiting, so they compile in parallel.
+    for (uint32_t format_index = 0U; format_index < color_format_count; ++format_index) {
+        for (uint32_t sample_count = VK_SAMPLE_COUNT_1_BIT; sample_count <= VK_SAMPLE_COUNT_64_BIT; sample_count *= 2U) {
+            if (sample_count != VK_SAMPLE_COUNT_1_BIT && !(sample_counts & sample_count)) {
+                continue;
+            }
+
+            VkRenderPass render_pass = VK_NULL_HANDLE;
+
+            if (use_render_pass) {
+                struct render_pass_description render_pass_description;
+                render_pass_description_init(&render_pass_description, color_formats[format_index], context->depth_format, (VkSampleCountFlagBits) sample_count);
+                render_pass = render_pass_cache_get(context->render_pass_cache, &render_pass_description);
+            }
+
+            for (uint32_t variant = 0U; variant < CONTEXT_GRAPHICS_PIPELINE_VARIANT_COUNT; ++variant) {
+                struct graphics_pipeline_description description;
+                context_describe_graphics_pipeline(context, variant, &description);
+                description.render_pass = render_pass;
+                description.subpass = 0;
+                description.color_attachment_format = color_formats[format_index];
+                description.sample_count = (VkSampleCountFlagBits) sample_count;
+
+                pipeline_compiler_request_graphics(context->pipeline_compiler, &description);
+            }
+        }
+    }
+
+    // Deferred shading draws into a G-buffer with one sample and always uses
+    // its own render pass. The lighting pipeline of each of those passes is
+    // requested by a deferred_lighting made for it. See LEARN_VULKAN_DEFERRED.
+    const bool deferred_supported = context->depth_format != VK_FORMAT_D24_UNORM_S8_UINT;
+    struct deferred_lighting *deferred_lightings[(sizeof color_formats) / (sizeof *color_formats)] = {NULL};
+
+    for (uint32_t format_index = 0U; deferred_supported && format_index < color_format_count; ++format_index) {
+        struct render_pass_description render_pass_description;
+        render_pass_description_init_deferred(&render_pass_description, CONTEXT_GBUFFER_ALBEDO_FORMAT, context->depth_format, color_formats[format_index]);
+        const VkRenderPass render_pass = render_pass_cache_get(context->render_pass_cache, &render_pass_description);
+
+        for (uint32_t variant = 0U; variant < CONTEXT_GRAPHICS_PIPELINE_VARIANT_COUNT; ++variant) {
+            struct graphics_pipeline_description description;
+            context_describe_graphics_pipeline(context, variant, &description);
+            description.render_pass = render_pass;
+            description.subpass = 0;
+            description.color_attachment_format = CONTEXT_GBUFFER_ALBEDO_FORMAT;
+            description.sample_count = VK_SAMPLE_COUNT_1_BIT;
+
+            pipeline_compiler_request_graphics(context->pipeline_compiler, &description);
+        }
+
+        deferred_lightings[format_index] = deferred_lighting_create(context->device, context->shader_module_cache, context->pipeline_compiler, render_pass);
+    }
+
+    // The compute pipeline is created on this thread while the graphics
+    // pipelines compile in the background.
+    const VkShaderModule cull_shader_module = shader_module_create(context->device, "cull");
+    struct culling *culling = culling_create(context->device, context->pipeline_cache, context->physical_device_memory_properties, cull_shader_module, 1U);
+    vkDestroyShaderModule(context->device, cull_shader_module, NULL);
+    culling_destroy(context->device, culling);
+
+    pipeline_compiler_wait_idle(context->pipeline_compiler);
+
+    for (uint32_t format_index = 0U; format_index < color_format_count; ++format_index) {
+        if (deferred_lightings[format_index] != NULL) {
+            deferred_lighting_destroy(deferred_lightings[format_index]);
+        }
+    }
+
+    const struct pipeline_compiler_statistics statistics = pipeline_compiler_get_statistics(context->pipeline_compiler);
+
+    pipeline_cache_save(context->device, context->pipeline_cache, pipeline_cache_path);
+
+    printf("info: %u pipelines, %u compiled, %u library parts, %u optimized links in %.2f ms, %zu bytes written to %s\n",
+        statistics.request_count,
+        statistics.compile_count,
+        statistics.library_count,
+        statistics.optimized_link_count,
+        (time_get_seconds() - start_time) * 1e3,
+        pipeline_cache_get_data_size(context->device, context->pipeline_cache),
+        pipeline_cache_path);
+
+    context_destroy(context);
+
+    return 0;
+}